@@ -89,10 +89,13 @@ const int THRESHOLD1 = 550;
 PulseSensorPlayground pulseSensor(PULSE_SENSOR_COUNT);
 
 /*
-  Variables used to determine PTT.
+  The Playground pairs each beat on PulseSensor 0 with the same beat
+  arriving at PulseSensor 1, as it finds them, to measure PTT.
   NOTE: This code assumes the Pulse Sensor on analog pin 0 is closer to he heart.
+  For PTT finer than the 2 millisecond sample period, change
+  PULSE_SENSOR_INTERPOLATE_BEATS to true in the library's utility/PulseSensor.h.
 */
-unsigned long lastBeatSampleNumber[PULSE_SENSOR_COUNT];
+PulseSensorTransitTime pulseTransit(0, 1);
 int PTT;
 
 void setup() {
@@ -127,6 +130,7 @@ void setup() {
   pulseSensor.setSerial(Serial);
   pulseSensor.setOutputType(OUTPUT_TYPE);
 
+  pulseSensor.addTransitTime(pulseTransit);
 
   // Now that everything is ready, start reading the PulseSensor signal.
   if (!pulseSensor.begin()) {
@@ -200,13 +204,16 @@ if(pulseSensor.UsingHardwareTimer){
   for (int i = 0; i < PULSE_SENSOR_COUNT; ++i) {
     if (pulseSensor.sawStartOfBeat(i)) {
       pulseSensor.outputBeat(i);
-
-      lastBeatSampleNumber[i] = pulseSensor.getLastBeatTime(i);
-      if(i == 1){
-        PTT = lastBeatSampleNumber[1] - lastBeatSampleNumber[0];
-        pulseSensor.outputToSerial('|',PTT);
-      }
     }
   }
 
+  /*
+     If a beat has reached both PulseSensors since we last checked,
+     write the time it took (milliseconds) to Serial.
+  */
+  if (pulseTransit.sawNewTransitTime()) {
+    PTT = (pulseTransit.getTransitTimeMicros() + 500) / 1000;
+    pulseSensor.outputToSerial('|',PTT);
+  }
+
 }
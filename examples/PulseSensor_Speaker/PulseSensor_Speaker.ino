@@ -109,6 +109,16 @@ void setup() {
   pulseSensor.setOutputType(OUTPUT_TYPE);
   pulseSensor.setThreshold(THRESHOLD);
 
+  /*
+     Start and stop the beep from the sample interrupt (the true below),
+     within 2 milliseconds of the beat, however long loop() takes.
+     The beep stops when the signal falls back below the threshold,
+     or when there's been no beat for a while.
+  */
+  pulseSensor.onBeatStart(beepOn, NULL, true);
+  pulseSensor.onBeatEnd(beepOff, NULL, true);
+  pulseSensor.onSignalLost(beepOff, NULL, true);
+
   // Now that everything is ready, start reading the PulseSensor signal.
   if (!pulseSensor.begin()) {
     /*
@@ -178,23 +188,27 @@ void loop() {
   /*
      If a beat has happened since we last checked,
      write the per-beat information to Serial.
-     write a frequency to the PIN_SPEAKER
-     NOTE: Do not set the optional duration of tone! That is blocking!
+     The beep is handled by beepOn() and beepOff(), below.
    */
   if (pulseSensor.sawStartOfBeat()) {
     pulseSensor.outputBeat();
-    heartBeep(SPEAKER_PIN,true);
   }
 
-  /*
-    The Pulse variable is true only for a short time after the heartbeat is detected
-    Use this to time the duration of the beep
-  */
-  if(pulseSensor.isInsideBeat() == false){
-    heartBeep(SPEAKER_PIN,false);
-  }
+}
+
+/*
+  Called by the PulseSensor Playground when a beat starts, and when it ends.
+  They may be called from an interrupt, so they must be quick:
+  no Serial printing and no delay().
+*/
+void beepOn(const BeatEvent &beat, void *context) {
+  heartBeep(SPEAKER_PIN,true);
+}
 
+void beepOff(const BeatEvent &beat, void *context) {
+  heartBeep(SPEAKER_PIN,false);
 }
+
 /*
   heartBeep(a pin, to beep or not to beep)
     The pin parameter needs to be a PWM capable pin.
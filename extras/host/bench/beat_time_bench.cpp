@@ -0,0 +1,174 @@
+/*
+   How finely the beat finder times beats, with and without
+   PULSE_SENSOR_INTERPOLATE_BEATS, on synthetic PPG signals
+   (see synth/synthetic_ppg.h). Built against a Playground compiled
+   with PULSE_SENSOR_INTERPOLATE_BEATS true.
+
+   Usage:
+     beat_time_bench [seconds]
+
+     seconds  length of each signal (default 300).
+
+   Each scenario runs two PulseSensors through the Playground:
+   the same signal at a steady heart rate, the second one delayed
+   by a known Pulse Transit Time.
+   For each, prints the RMS error (microseconds) of:
+     ptt      getLastBeatTime(1) - getLastBeatTime(0) (whole sample periods),
+              and the Pulse Transit Times of a PulseSensorTransitTime,
+              against the delay.
+     ibi      getInterBeatIntervalMs() and getInterBeatIntervalMicros()
+              of PulseSensor 0, against the signal's true IBI.
+   then how many times smaller the interpolated PTT error is, and
+   the PulseSensorTransitTime's standard deviation of its latest
+   PULSE_SENSOR_TRANSIT_WINDOW times, and number of unpaired beats.
+   What error is left on a clean signal comes mostly from the threshold,
+   which follows the sampled peak and trough, so differs a little
+   between the two PulseSensors. With noise, the error is mostly the
+   noise's, not the sample period's.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include <synthetic_ppg.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#if !PULSE_SENSOR_INTERPOLATE_BEATS
+#error "beat_time_bench needs PULSE_SENSOR_INTERPOLATE_BEATS true"
+#endif
+
+struct Scenario {
+  const char *name;
+  unsigned int sampleRate;
+  double bpm;
+  double noise;
+  double delayMs;
+};
+
+static const Scenario SCENARIOS[] = {
+  // name         rate  bpm noise delay
+  { "clean",       500,  72,   0,  0.7 },
+  { "clean",       500,  72,   0,  3.3 },
+  { "fast 150",    500, 150,   0,  1.2 },
+  { "250Hz",       250,  72,   0,  1.7 },
+  { "1000Hz",     1000,  72,   0,  0.4 },
+  { "noise 2",     500,  72,   2,  0.7 },
+  { "noise 5",     500,  72,   5,  0.7 },
+};
+
+// Sums of squared errors, in microseconds.
+struct ErrorSum {
+  ErrorSum() : sum(0.0), count(0) {}
+  void add(double error) { sum += error * error; ++count; }
+  double rms() const { return count ? sqrt(sum / count) : 0.0; }
+  double sum;
+  unsigned long count;
+};
+
+int main(int argc, char *argv[]) {
+  double seconds = argc > 1 ? atof(argv[1]) : 300.0;
+
+  printf("%-10s %5s %6s %6s  %9s %9s  %9s %9s %6s %7s %5s\n", "signal", "rate", "delay",
+    "beats", "ptt q us", "ptt i us", "ibi q us", "ibi i us", "finer", "sd us", "miss");
+
+  for (size_t k = 0; k < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); ++k) {
+    const Scenario &scenario = SCENARIOS[k];
+    SyntheticPPGConfig config;
+    config.seconds = seconds;
+    config.sampleRate = scenario.sampleRate;
+    config.bpm = scenario.bpm;
+    config.variability = 0.0;
+    config.noise = scenario.noise;
+    config.seed = k + 1;
+    SyntheticPPG proximal;
+    generateSyntheticPPG(config, proximal);
+    config.delayMs = scenario.delayMs;
+    config.seed = k + 101;
+    SyntheticPPG distal;
+    generateSyntheticPPG(config, distal);
+
+    std::vector<int> channels[2];
+    channels[0].assign(proximal.samples.begin(), proximal.samples.end());
+    channels[1].assign(distal.samples.begin(), distal.samples.end());
+    size_t frames = channels[0].size();
+
+    ArduinoShim::reset();
+    PulseSensorPlayground pulse(2);
+    TransitTimeEvent transitStorage[4];
+    PulseSensorTransitTime transit(0, 1, transitStorage, 4);
+    transit.setWindow(0, (unsigned long) (SYNTHETIC_MATCH_MS * 1000));
+    pulse.addTransitTime(transit);
+    pulse.setSampleRate(scenario.sampleRate);
+    for (int i = 0; i < 2; ++i) {
+      pulse.analogInput(A0 + i, i);
+      pulse.setThreshold(550, i);
+      ArduinoShim::setAnalogSamples(A0 + i, channels[i].data(), frames);
+    }
+    const unsigned long interval = pulse.getSampleIntervalMicros();
+    const double sampleMs = 1000.0 / scenario.sampleRate;
+
+    ErrorSum pttQuantized, pttInterpolated, ibiQuantized, ibiInterpolated;
+    const double delayMicros = scenario.delayMs * 1000.0;
+    bool haveProximal = false;
+    unsigned long proximalMs = 0;
+    BeatMatches matches(proximal);
+    long previousMatch = -2; // the signal beat matched by the previous found beat.
+
+    pulse.begin();
+    for (size_t f = 0; f < frames; ++f) {
+      ArduinoShim::setMicros((f + 1) * interval);
+      if (!pulse.sawNewSample()) {
+        continue;
+      }
+      if (pulse.sawStartOfBeat(0)) {
+        haveProximal = true;
+        proximalMs = pulse.getLastBeatTime(0);
+
+        // The Playground's time is one sample period later than the signal's.
+        long beat = matchBeats(proximal,
+          pulse.getLastBeatTimeMicros(0) / 1000.0 - sampleMs, matches);
+        if (beat >= 0 && previousMatch == beat - 1 && proximal.beats[beat].ibiMs > 0.0) {
+          const SyntheticBeat &truth = proximal.beats[beat];
+          ibiQuantized.add(pulse.getInterBeatIntervalMs(0) * 1000.0 - truth.ibiMs * 1000.0);
+          ibiInterpolated.add((double) pulse.getInterBeatIntervalMicros(0) - truth.ibiMs * 1000.0);
+        }
+        previousMatch = beat;
+      }
+      if (pulse.sawStartOfBeat(1) && haveProximal) {
+        long pttMs = (long) (pulse.getLastBeatTime(1) - proximalMs);
+        if (pttMs >= 0 && pttMs <= SYNTHETIC_MATCH_MS) {
+          pttQuantized.add(pttMs * 1000.0 - delayMicros);
+        }
+      }
+      TransitTimeEvent event;
+      while (transit.readTransitTimes(&event, 1) == 1) {
+        pttInterpolated.add(event.transitTimeMicros - delayMicros);
+      }
+    }
+    if (transit.getOverruns() > 0) {
+      fprintf(stderr, "%s: %lu transit times dropped\n", scenario.name, transit.getOverruns());
+      return 1;
+    }
+
+    printf("%-10s %5u %6.1f %6lu  %9.1f %9.1f  %9.1f %9.1f %5.1fx %7ld %5lu\n",
+      scenario.name, scenario.sampleRate, scenario.delayMs, transit.getMatchCount(),
+      pttQuantized.rms(), pttInterpolated.rms(),
+      ibiQuantized.rms(), ibiInterpolated.rms(),
+      pttInterpolated.rms() > 0.0 ? pttQuantized.rms() / pttInterpolated.rms() : 0.0,
+      transit.getStandardDeviationMicros(), transit.getMissCount());
+  }
+  return 0;
+}
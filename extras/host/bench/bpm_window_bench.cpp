@@ -0,0 +1,95 @@
+/*
+   Per-beat cost of turning inter-beat intervals (IBIs) into beats per minute.
+
+   "before" is the original PulseSensor code: shift the whole rate[] array,
+   add it all up again, and divide. "after" is what PulseSensor does now,
+   PulseSensor::addIBI(): replace the oldest IBI in a ring, adjust the
+   running total, and convert with PulseSensor::ibiTotalToBPM().
+
+   Built several times by CMakeLists.txt, once for each combination of
+   PULSE_SENSOR_IBI_WINDOW and PULSE_SENSOR_BPM_LOOKUP.
+   Timings are for the computer running the benchmark, not for an Arduino.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const int WINDOW = PULSE_SENSOR_IBI_WINDOW;
+static volatile int Sink;
+
+// The original per-beat code, with its window widened to WINDOW.
+static int shiftAndSum(int *rate, int ibi) {
+  unsigned long runningTotal = 0;
+  for (int i = 0; i <= WINDOW - 2; i++) {
+    rate[i] = rate[i + 1];
+    runningTotal += rate[i];
+  }
+  rate[WINDOW - 1] = ibi;
+  runningTotal += rate[WINDOW - 1];
+  runningTotal /= WINDOW;
+  return 60000 / runningTotal;
+}
+
+static double nsPerBeat(std::chrono::steady_clock::time_point start, size_t beats) {
+  return std::chrono::duration<double, std::nano>(
+    std::chrono::steady_clock::now() - start).count() / beats;
+}
+
+int main(int argc, char *argv[]) {
+  size_t beats = argc > 1 ? strtoul(argv[1], NULL, 10) : 20000000UL;
+
+  // IBIs the beat finder can produce: over 250ms, under 2.5 seconds.
+  std::vector<int> ibis(4096);
+  srand(1);
+  for (size_t i = 0; i < ibis.size(); ++i) {
+    ibis[i] = 252 + rand() % 2249;
+  }
+
+  std::vector<int> before(WINDOW, ibis[0]);
+  std::vector<int> after(WINDOW, ibis[0]);
+  byte rateIndex = 0;
+  unsigned long rateTotal = (unsigned long) ibis[0] * WINDOW;
+
+  // Both must give the same answer for every beat.
+  for (size_t b = 0; b < ibis.size() * 4; ++b) {
+    int ibi = ibis[b % ibis.size()];
+    int expected = shiftAndSum(before.data(), ibi);
+    int actual = PulseSensor::addIBI(after.data(), rateIndex, rateTotal, ibi);
+    if (expected != actual) {
+      fprintf(stderr, "mismatch at beat %zu: %d BPM before, %d BPM after\n", b, expected, actual);
+      return 1;
+    }
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t b = 0; b < beats; ++b) {
+    Sink = shiftAndSum(before.data(), ibis[b & 4095]);
+  }
+  double beforeNs = nsPerBeat(start, beats);
+
+  start = std::chrono::steady_clock::now();
+  for (size_t b = 0; b < beats; ++b) {
+    Sink = PulseSensor::addIBI(after.data(), rateIndex, rateTotal, ibis[b & 4095]);
+  }
+  double afterNs = nsPerBeat(start, beats);
+
+  printf("window %3d, %s: before %6.2f ns/beat, after %6.2f ns/beat\n",
+    WINDOW, PULSE_SENSOR_BPM_LOOKUP ? "BPM lookup  " : "BPM division",
+    beforeNs, afterNs);
+  return 0;
+}
@@ -0,0 +1,144 @@
+/*
+   Per-sample cost of finding beats in many channels at once:
+   one PulseSensor object per channel, run the way
+   PulseSensorPlayground::processBlock() runs them, against
+   PulseSensorChannels::processBlock(), which keeps each beat finder
+   variable for all channels in one array.
+
+   Usage:
+     channels_bench [samples]
+
+     samples  roughly how many samples to time for each channel count
+              (default 16000000).
+
+   The channels are synthetic PPG signals (see synth/synthetic_ppg.h)
+   at different heart rates and noise levels. The benchmark also checks
+   that both find exactly the same beats.
+   Timings are for the computer running the benchmark, not for an Arduino.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include <synthetic_ppg.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const int SIGNALS = 8; // distinct synthetic signals, shared out among the channels.
+
+static bool sameBeats(const BeatEvent &a, const BeatEvent &b) {
+  return a.sampleIndex == b.sampleIndex && a.sensorIndex == b.sensorIndex
+    && a.beatTime == b.beatTime && a.beatsPerMinute == b.beatsPerMinute
+    && a.interBeatIntervalMs == b.interBeatIntervalMs
+    && a.pulseAmplitude == b.pulseAmplitude;
+}
+
+// PulseSensorPlayground::processBlock(), for any number of PulseSensors.
+static size_t processObjects(std::vector<PulseSensor> &sensors,
+  const int16_t *samples, size_t frameCount, BeatEvent *out, size_t outCap) {
+  size_t beats = 0;
+  const int16_t *pSample = samples;
+  for (size_t frame = 0; frame < frameCount; ++frame) {
+    for (size_t i = 0; i < sensors.size(); ++i) {
+      if ((sensors[i].findBeat(*pSample++) & PulseSensor::FOUND_BEAT_START) == 0) {
+        continue;
+      }
+      if (beats < outCap) {
+        sensors[i].getBeatEvent(out[beats]);
+        out[beats].sampleIndex = frame;
+        out[beats].sensorIndex = i;
+      }
+      ++beats;
+    }
+  }
+  return beats;
+}
+
+static double nsPerSample(std::chrono::steady_clock::time_point start, size_t samples) {
+  return std::chrono::duration<double, std::nano>(
+    std::chrono::steady_clock::now() - start).count() / samples;
+}
+
+int main(int argc, char *argv[]) {
+  size_t budget = argc > 1 ? strtoul(argv[1], NULL, 10) : 16000000UL;
+  static const int CHANNEL_COUNTS[] = { 1, 4, 16, 64, 256, 1024 };
+
+  std::vector<SyntheticPPG> signals(SIGNALS);
+  for (int s = 0; s < SIGNALS; ++s) {
+    SyntheticPPGConfig config;
+    config.seconds = 120.0;
+    config.bpm = 50 + 15 * s;
+    config.variability = 0.04;
+    config.notch = 0.1 * (s % 5);
+    config.noise = 2 * s;
+    config.wander = 10 * s;
+    config.dropoutsPerMinute = (s % 3 == 2) ? 1.0 : 0.0;
+    config.seed = s + 1;
+    generateSyntheticPPG(config, signals[s]);
+  }
+  size_t signalLength = signals[0].samples.size();
+
+  printf("%8s %8s %14s %14s %8s\n", "channels", "frames", "objects ns", "channels ns", "speedup");
+  for (size_t k = 0; k < sizeof(CHANNEL_COUNTS) / sizeof(CHANNEL_COUNTS[0]); ++k) {
+    int channels = CHANNEL_COUNTS[k];
+    size_t frames = budget / channels;
+    if (frames < 2000) {
+      frames = 2000;
+    }
+    if (frames > signalLength) {
+      frames = signalLength;
+    }
+
+    // Channel c plays signal c % SIGNALS, starting c samples in.
+    std::vector<int16_t> block(frames * channels);
+    for (size_t f = 0; f < frames; ++f) {
+      for (int c = 0; c < channels; ++c) {
+        const std::vector<int16_t> &samples = signals[c % SIGNALS].samples;
+        block[f * channels + c] = samples[(f + c) % signalLength];
+      }
+    }
+
+    size_t outCap = frames * channels / 100 + 16;
+    std::vector<BeatEvent> before(outCap);
+    std::vector<BeatEvent> after(outCap);
+
+    std::vector<PulseSensor> sensors(channels);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    size_t beforeBeats = processObjects(sensors, block.data(), frames, before.data(), outCap);
+    double beforeNs = nsPerSample(start, block.size());
+
+    PulseSensorChannels detector(channels);
+    start = std::chrono::steady_clock::now();
+    size_t afterBeats = detector.processBlock(block.data(), frames, after.data(), outCap);
+    double afterNs = nsPerSample(start, block.size());
+
+    if (beforeBeats != afterBeats) {
+      fprintf(stderr, "%d channels: %zu beats from PulseSensor, %zu from PulseSensorChannels\n",
+        channels, beforeBeats, afterBeats);
+      return 1;
+    }
+    for (size_t b = 0; b < beforeBeats && b < outCap; ++b) {
+      if (!sameBeats(before[b], after[b])) {
+        fprintf(stderr, "%d channels: beat %zu differs (channel %d, frame %lu)\n",
+          channels, b, before[b].sensorIndex, before[b].sampleIndex);
+        return 1;
+      }
+    }
+
+    printf("%8d %8zu %14.2f %14.2f %7.1fx\n", channels, frames, beforeNs, afterNs,
+      afterNs > 0 ? beforeNs / afterNs : 0.0);
+  }
+  return 0;
+}
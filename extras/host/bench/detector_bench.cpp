@@ -0,0 +1,214 @@
+/*
+   Speed and accuracy of the PulseSensor beat finder,
+   on synthetic PPG signals (see synth/synthetic_ppg.h).
+
+   Usage:
+     detector_bench [seconds]
+
+     seconds  length of each signal (default 600).
+
+   For each scenario, prints:
+     beats    beats in the signal (not counting those lost in dropouts).
+     sens     sensitivity: the percent of those beats that were found.
+     ppv      positive predictive value: the percent of the beats found
+              that were real.
+     bpm      mean error of getBeatsPerMinute() against the true average
+              heart rate over the same PULSE_SENSOR_IBI_WINDOW beats.
+     ibi      mean error of getInterBeatIntervalMs() (ms).
+     late     mean time from the halfway point of the pulse upstroke
+              to the sample the beat was found on (ms).
+     sample   ns per sample through readNextSample() and
+              processLatestSample(), and millions of samples per second.
+     block    ns per sample through processBlock().
+
+   A found beat is real if it is within 150ms of a beat in the signal
+   (see matchBeats() in synth/synthetic_ppg.h).
+   Only beats found after PULSE_SENSOR_IBI_WINDOW real beats in a row
+   count towards the BPM error.
+   Timings are for the computer running the benchmark, not for an Arduino.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include <synthetic_ppg.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+struct Scenario {
+  const char *name;
+  double bpm;
+  double variability;
+  int amplitude;
+  double wander;
+  double notch;
+  double noise;
+  double dropoutsPerMinute;
+};
+
+static const Scenario SCENARIOS[] = {
+  // name          bpm  var   amp  wander notch noise drops
+  { "clean 72",     72, 0.00, 300,   0,  0.0,  0,  0 },
+  { "slow 40",      40, 0.00, 300,   0,  0.0,  0,  0 },
+  { "fast 180",    180, 0.00, 300,   0,  0.0,  0,  0 },
+  { "variable",     72, 0.08, 300,   0,  0.0,  0,  0 },
+  { "notch",        72, 0.00, 300,   0,  0.6,  0,  0 },
+  { "wander",       72, 0.00, 300,  80,  0.0,  0,  0 },
+  { "small",        72, 0.00,  60,   0,  0.0,  0,  0 },
+  { "noise 10",     72, 0.00, 300,   0,  0.0, 10,  0 },
+  { "noise 30",     72, 0.00, 300,   0,  0.0, 30,  0 },
+  { "dropouts",     72, 0.00, 300,   0,  0.0,  0,  2 },
+  { "everything",   72, 0.05, 200,  50,  0.5, 10,  1 },
+};
+
+struct Accuracy {
+  explicit Accuracy(const SyntheticPPG &signal)
+    : matches(signal), bpmErrorSum(0.0), bpmErrors(0), ibiErrorSum(0.0), ibiErrors(0) {}
+  BeatMatches matches;
+  double bpmErrorSum;
+  unsigned long bpmErrors;
+  double ibiErrorSum;
+  unsigned long ibiErrors;
+};
+
+static void measureAccuracy(const SyntheticPPG &signal, unsigned int sampleRate,
+  Accuracy &result) {
+  PulseSensor sensor;
+  sensor.setSampleIntervalMicros(1000000UL / sampleRate);
+  std::vector<BeatEvent> found(signal.beats.size() * 2 + 16);
+  size_t n = sensor.processBlock(signal.samples.data(), signal.samples.size(),
+    found.data(), found.size());
+  if (n > found.size()) {
+    n = found.size();
+  }
+
+  double sampleMs = 1000.0 / sampleRate;
+  long previousMatch = -2;   // the signal beat matched by the previous found beat.
+  unsigned long inARow = 0;  // real beats found one after another.
+  for (size_t f = 0; f < n; ++f) {
+    long b = matchBeats(signal, found[f].sampleIndex * sampleMs, result.matches);
+    if (b < 0) {
+      inARow = 0;
+      previousMatch = -2;
+      continue;
+    }
+    const SyntheticBeat &beat = signal.beats[b];
+    if (!beat.visible) {
+      continue; // found in a dropout's edge; neither right nor wrong.
+    }
+
+    inARow = (previousMatch == b - 1) ? inARow + 1 : 1;
+    previousMatch = b;
+    if (inARow >= 2 && beat.ibiMs > 0.0) {
+      result.ibiErrorSum += fabs(found[f].interBeatIntervalMs - beat.ibiMs);
+      ++result.ibiErrors;
+    }
+    if (inARow > PULSE_SENSOR_IBI_WINDOW) {
+      double ibiTotal = 0.0;
+      for (size_t w = 0; w < PULSE_SENSOR_IBI_WINDOW; ++w) {
+        ibiTotal += signal.beats[b - w].ibiMs;
+      }
+      double trueBpm = 60000.0 * PULSE_SENSOR_IBI_WINDOW / ibiTotal;
+      result.bpmErrorSum += fabs(found[f].beatsPerMinute - trueBpm);
+      ++result.bpmErrors;
+    }
+  }
+}
+
+// ns per sample, reading each sample through analogRead().
+static double timeSampleBySample(const SyntheticPPG &signal, unsigned int sampleRate) {
+  std::vector<int> samples(signal.samples.begin(), signal.samples.end());
+  PulseSensor sensor;
+  sensor.analogInput(A0);
+  sensor.setSampleIntervalMicros(1000000UL / sampleRate);
+
+  double seconds = 0.0;
+  unsigned long processed = 0;
+  while (seconds < SYNTHETIC_MIN_SECONDS_TIMED) {
+    ArduinoShim::setAnalogSamples(A0, samples.data(), samples.size());
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < samples.size(); ++i) {
+      sensor.readNextSample();
+      sensor.processLatestSample();
+    }
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    processed += samples.size();
+  }
+  return seconds * 1e9 / processed;
+}
+
+// ns per sample through processBlock().
+static double timeBlock(const SyntheticPPG &signal, unsigned int sampleRate) {
+  PulseSensor sensor;
+  sensor.setSampleIntervalMicros(1000000UL / sampleRate);
+  std::vector<BeatEvent> found(signal.beats.size() * 2 + 16);
+
+  double seconds = 0.0;
+  unsigned long processed = 0;
+  while (seconds < SYNTHETIC_MIN_SECONDS_TIMED) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    sensor.processBlock(signal.samples.data(), signal.samples.size(),
+      found.data(), found.size());
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    processed += signal.samples.size();
+  }
+  return seconds * 1e9 / processed;
+}
+
+static double percent(unsigned long part, unsigned long whole) {
+  return whole ? 100.0 * part / whole : 0.0;
+}
+
+int main(int argc, char *argv[]) {
+  double seconds = argc > 1 ? atof(argv[1]) : 600.0;
+  unsigned int sampleRate = SAMPLE_RATE_500HZ;
+
+  printf("%-12s %6s %6s %6s %6s %6s %6s %13s %7s\n",
+    "scenario", "beats", "sens%", "ppv%", "bpm", "ibi", "late",
+    "sample ns  M/s", "block");
+  for (size_t s = 0; s < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); ++s) {
+    const Scenario &scenario = SCENARIOS[s];
+    SyntheticPPGConfig config;
+    config.sampleRate = sampleRate;
+    config.seconds = seconds;
+    config.bpm = scenario.bpm;
+    config.variability = scenario.variability;
+    config.amplitude = scenario.amplitude;
+    config.wander = scenario.wander;
+    config.notch = scenario.notch;
+    config.noise = scenario.noise;
+    config.dropoutsPerMinute = scenario.dropoutsPerMinute;
+    config.seed = (unsigned long) s + 1;
+    SyntheticPPG signal;
+    generateSyntheticPPG(config, signal);
+
+    Accuracy accuracy(signal);
+    measureAccuracy(signal, sampleRate, accuracy);
+    const BeatMatches &matches = accuracy.matches;
+    double sampleNs = timeSampleBySample(signal, sampleRate);
+    double blockNs = timeBlock(signal, sampleRate);
+
+    printf("%-12s %6lu %6.1f %6.1f %6.2f %6.1f %6.1f %6.1f %6.1f %7.1f\n",
+      scenario.name, matches.beats,
+      percent(matches.truePositives, matches.beats),
+      percent(matches.truePositives, matches.truePositives + matches.falsePositives),
+      accuracy.bpmErrors ? accuracy.bpmErrorSum / accuracy.bpmErrors : 0.0,
+      accuracy.ibiErrors ? accuracy.ibiErrorSum / accuracy.ibiErrors : 0.0,
+      matches.truePositives ? matches.lateSum / matches.truePositives : 0.0,
+      sampleNs, 1000.0 / sampleNs, blockNs);
+  }
+  return 0;
+}
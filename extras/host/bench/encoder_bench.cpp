@@ -0,0 +1,213 @@
+/*
+   Compression and speed of PulseSensorSampleEncoder,
+   on synthetic PPG signals (see synth/synthetic_ppg.h).
+
+   Usage:
+     encoder_bench [seconds]
+
+     seconds  length of each signal (default 600).
+
+   For each signal, prints the bits per sample of:
+     text     the samples as decimal text, one per line, as
+              SERIAL_PLOTTER sends a single PulseSensor's sample.
+     varint   differences as zigzag varints, whole bytes each,
+              as PulseSensorRecorder stores them.
+     rice N   PulseSensorSampleEncoder packets of N bytes (20: a BLE
+              notification; 64: COMPRESSED_STREAM; 244: the most a BLE 4.2+
+              notification holds), counting every packet's header.
+   then, for 64 byte packets, the ratio to 16 bit samples, and
+   the time to encode and decode a sample, in ns and in TSC cycles
+   (x86 only; the time stamp counter runs at a fixed rate, usually
+   close to the CPU's base clock).
+   Every packet is decoded and checked against the signal.
+   Timings are for the computer running the benchmark, not for an Arduino.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include <synthetic_ppg.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+struct Scenario {
+  const char *name;
+  double bpm;
+  int amplitude;
+  double wander;
+  double noise;
+  double dropoutsPerMinute;
+};
+
+static const Scenario SCENARIOS[] = {
+  // name          bpm  amp  wander noise drops
+  { "clean 72",     72, 300,   0,    0,  0 },
+  { "fast 180",    180, 300,   0,    0,  0 },
+  { "wander",       72, 300,  80,    0,  0 },
+  { "small",        72,  60,   0,    0,  0 },
+  { "noise 10",     72, 300,   0,   10,  0 },
+  { "noise 30",     72, 300,   0,   30,  0 },
+  { "dropouts",     72, 300,   0,    0,  2 },
+  { "everything",   72, 200,  50,   10,  1 },
+};
+
+static const word PACKET_SIZES[] = { 20, 64, 244 };
+
+static unsigned long long readTsc() {
+#ifdef HAVE_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static double textBits(const std::vector<int16_t> &samples) {
+  unsigned long bytes = 0;
+  char line[16];
+  for (size_t i = 0; i < samples.size(); ++i) {
+    bytes += snprintf(line, sizeof(line), "%d\r\n", samples[i]);
+  }
+  return bytes * 8.0 / samples.size();
+}
+
+static double varintBits(const std::vector<int16_t> &samples) {
+  unsigned long bytes = 2;
+  for (size_t i = 1; i < samples.size(); ++i) {
+    long difference = (long) samples[i] - samples[i - 1];
+    unsigned long z = difference < 0 ? ((unsigned long) -difference << 1) - 1
+      : (unsigned long) difference << 1;
+    do {
+      ++bytes;
+      z >>= 7;
+    } while (z);
+  }
+  return bytes * 8.0 / samples.size();
+}
+
+/*
+   Encode the samples into packets of the given size, one after another
+   in packets. Returns the time it took, and sets cycles to the TSC count.
+*/
+static double encode(const std::vector<int16_t> &samples, word packetSize,
+  std::vector<std::vector<byte> > &packets, unsigned long long &cycles) {
+  std::vector<byte> packet(packetSize);
+  PulseSensorSampleEncoder encoder;
+  encoder.begin(packet.data(), packetSize, 1);
+  packets.clear();
+  packets.reserve(samples.size() / 8 + 1);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  unsigned long long startCycles = readTsc();
+  for (size_t i = 0; i < samples.size(); ++i) {
+    if (!encoder.addFrame(&samples[i])) {
+      packets.push_back(std::vector<byte>(encoder.getPacket(),
+        encoder.getPacket() + encoder.getPacketLength()));
+      encoder.startPacket();
+      encoder.addFrame(&samples[i]);
+    }
+  }
+  packets.push_back(std::vector<byte>(encoder.getPacket(),
+    encoder.getPacket() + encoder.getPacketLength()));
+  cycles = readTsc() - startCycles;
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/*
+   Decode the packets, checking them against the samples.
+   Returns the time it took, or -1 if they don't match.
+*/
+static double decode(const std::vector<int16_t> &samples,
+  const std::vector<std::vector<byte> > &packets, unsigned long long &cycles) {
+  std::vector<int16_t> decoded(samples.size());
+  int16_t *pOut = decoded.data();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  unsigned long long startCycles = readTsc();
+  for (size_t p = 0; p < packets.size(); ++p) {
+    int frames = PulseSensorSampleEncoder::decodePacket(packets[p].data(),
+      packets[p].size(), pOut, 255);
+    if (frames < 0) {
+      return -1.0;
+    }
+    pOut += frames;
+  }
+  cycles = readTsc() - startCycles;
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return decoded == samples ? seconds : -1.0;
+}
+
+int main(int argc, char *argv[]) {
+  double seconds = argc > 1 ? atof(argv[1]) : 600.0;
+
+  printf("%-12s %6s %6s", "signal", "text", "varint");
+  for (size_t s = 0; s < sizeof(PACKET_SIZES) / sizeof(PACKET_SIZES[0]); ++s) {
+    printf("  rice %-3u", PACKET_SIZES[s]);
+  }
+  printf(" %6s %9s %9s %9s %9s\n", "ratio", "enc ns", "enc cyc", "dec ns", "dec cyc");
+
+  for (size_t k = 0; k < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); ++k) {
+    const Scenario &scenario = SCENARIOS[k];
+    SyntheticPPGConfig config;
+    config.seconds = seconds;
+    config.bpm = scenario.bpm;
+    config.amplitude = scenario.amplitude;
+    config.wander = scenario.wander;
+    config.noise = scenario.noise;
+    config.dropoutsPerMinute = scenario.dropoutsPerMinute;
+    config.seed = k + 1;
+    SyntheticPPG signal;
+    generateSyntheticPPG(config, signal);
+    const std::vector<int16_t> &samples = signal.samples;
+    const double count = (double) samples.size();
+
+    printf("%-12s %6.2f %6.2f", scenario.name, textBits(samples), varintBits(samples));
+    double riceBits = 0.0;
+    double encodeSeconds = 0.0;
+    double decodeSeconds = 0.0;
+    unsigned long long encodeCycles = 0;
+    unsigned long long decodeCycles = 0;
+    for (size_t s = 0; s < sizeof(PACKET_SIZES) / sizeof(PACKET_SIZES[0]); ++s) {
+      std::vector<std::vector<byte> > packets;
+      unsigned long long cycles;
+      double encodeTime = encode(samples, PACKET_SIZES[s], packets, cycles);
+      unsigned long bytes = 0;
+      for (size_t p = 0; p < packets.size(); ++p) {
+        bytes += packets[p].size();
+      }
+      unsigned long long dCycles;
+      double decodeTime = decode(samples, packets, dCycles);
+      if (decodeTime < 0) {
+        fprintf(stderr, "\n%s: %u byte packets don't decode to the signal\n",
+          scenario.name, PACKET_SIZES[s]);
+        return 1;
+      }
+      printf("  %8.2f", bytes * 8.0 / count);
+      if (PACKET_SIZES[s] == 64) {
+        riceBits = bytes * 8.0 / count;
+        encodeSeconds = encodeTime;
+        encodeCycles = cycles;
+        decodeSeconds = decodeTime;
+        decodeCycles = dCycles;
+      }
+    }
+    printf(" %5.1fx %9.1f %9.1f %9.1f %9.1f\n", 16.0 / riceBits,
+      encodeSeconds * 1e9 / count, encodeCycles / count,
+      decodeSeconds * 1e9 / count, decodeCycles / count);
+  }
+  return 0;
+}
@@ -0,0 +1,190 @@
+/*
+   The beat finder with and without a PulseSensorFilter, on the same
+   synthetic PPG signals (see synth/synthetic_ppg.h), and the cost
+   of the filter per sample.
+
+   Usage:
+     filter_bench [seconds]
+
+     seconds  length of each signal (default 600).
+
+   For each scenario, prints without, then with, the filter:
+     sens     sensitivity: the percent of the signal's beats found.
+     fp/min   false beats a minute: beats found that weren't real.
+     lost     times the beat finder gave up and started again
+              (FOUND_SIGNAL_LOST) outside a dropout.
+     late     mean time from the halfway point of the pulse upstroke
+              to the sample the beat was found on (ms).
+   Then, for the filter alone, ns per sample, and where the CPU has
+   a time stamp counter, counter cycles per sample. Timings are for the
+   computer running the benchmark, not for an Arduino; on a board,
+   compare getTimingHistogram() execution times with and without it.
+
+   A found beat is real if it is within 150ms of a beat in the signal
+   (see matchBeats() in synth/synthetic_ppg.h).
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include <synthetic_ppg.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TIME_STAMP_COUNTER 1
+#endif
+
+struct Scenario {
+  const char *name;
+  int amplitude;
+  double wander;
+  double breathsPerMinute;
+  double hum;
+  double humHz;
+  double noise;
+  double dropoutsPerMinute;
+};
+
+static const Scenario SCENARIOS[] = {
+  // name           amp  wander bpm  hum  Hz  noise drops
+  { "clean",        300,    0,  15,   0, 50,   0,  0 },
+  { "wander 80",    300,   80,  15,   0, 50,   0,  0 },
+  { "wander 200",   300,  200,  15,   0, 50,   0,  0 },
+  { "drift 150",    300,  150,   3,   0, 50,   0,  0 },
+  { "hum 30",       300,    0,  15,  30, 50,   0,  0 },
+  { "hum 60 60Hz",  300,    0,  15,  60, 60,   0,  0 },
+  { "noise 30",     300,    0,  15,   0, 50,  30,  0 },
+  { "small wander", 100,   60,  15,  10, 50,   5,  0 },
+  { "everything",   200,  120,  15,  30, 50,  10,  1 },
+};
+
+struct Result {
+  explicit Result(const SyntheticPPG &signal) : matches(signal), resets(0) {}
+  BeatMatches matches;
+  unsigned long resets;         // FOUND_SIGNAL_LOST outside a dropout.
+};
+
+static Result findBeats(const SyntheticPPG &signal, unsigned int sampleRate,
+  double seconds, double dropoutsPerMinute, bool filtered) {
+  std::vector<int> samples(signal.samples.begin(), signal.samples.end());
+  PulseSensor sensor;
+  PulseSensorFilter filter;
+  sensor.analogInput(A0);
+  sensor.setSampleIntervalMicros(1000000UL / sampleRate);
+  if (filtered) {
+    sensor.setFilter(&filter);
+  }
+  ArduinoShim::setAnalogSamples(A0, samples.data(), samples.size());
+
+  Result result(signal);
+  const double sampleMs = 1000.0 / sampleRate;
+  for (size_t i = 0; i < samples.size(); ++i) {
+    sensor.readNextSample();
+    byte found = sensor.processLatestSample();
+    if (found & PulseSensor::FOUND_SIGNAL_LOST) {
+      ++result.resets;
+    }
+    if (found & PulseSensor::FOUND_BEAT_START) {
+      matchBeats(signal, i * sampleMs, result.matches);
+    }
+  }
+  // A dropout is meant to lose the signal; count only the other times.
+  unsigned long dropouts = (unsigned long) lround(dropoutsPerMinute * seconds / 60.0);
+  result.resets = result.resets > dropouts ? result.resets - dropouts : 0;
+  return result;
+}
+
+static void timeFilter(const SyntheticPPG &signal, double &nanos, double &cycles) {
+  PulseSensorFilter filter;
+  filter.setSampleIntervalMicros(PulseSensorPlayground::MICROS_PER_READ);
+  volatile int sink = 0;
+  double seconds = 0.0;
+  unsigned long long ticks = 0;
+  unsigned long processed = 0;
+  while (seconds < SYNTHETIC_MIN_SECONDS_TIMED) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+#if HAVE_TIME_STAMP_COUNTER
+    unsigned long long tickStart = __rdtsc();
+#endif
+    for (size_t i = 0; i < signal.samples.size(); ++i) {
+      sink = filter.filter(signal.samples[i]);
+    }
+#if HAVE_TIME_STAMP_COUNTER
+    ticks += __rdtsc() - tickStart;
+#endif
+    seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    processed += signal.samples.size();
+  }
+  (void) sink;
+  nanos = seconds * 1e9 / processed;
+  cycles = (double) ticks / processed;
+}
+
+static double percent(unsigned long part, unsigned long whole) {
+  return whole ? 100.0 * part / whole : 0.0;
+}
+
+int main(int argc, char *argv[]) {
+  double seconds = argc > 1 ? atof(argv[1]) : 600.0;
+  unsigned int sampleRate = SAMPLE_RATE_500HZ;
+
+  printf("%-13s %5s  %-28s  %-28s\n", "", "", "     without filter", "      with filter");
+  printf("%-13s %5s  %6s %6s %6s %6s  %6s %6s %6s %6s\n", "scenario", "beats",
+    "sens%", "fp/min", "lost", "late", "sens%", "fp/min", "lost", "late");
+
+  SyntheticPPG timed;
+  for (size_t k = 0; k < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); ++k) {
+    const Scenario &scenario = SCENARIOS[k];
+    SyntheticPPGConfig config;
+    config.sampleRate = sampleRate;
+    config.seconds = seconds;
+    config.amplitude = scenario.amplitude;
+    config.wander = scenario.wander;
+    config.breathsPerMinute = scenario.breathsPerMinute;
+    config.hum = scenario.hum;
+    config.humHz = scenario.humHz;
+    config.noise = scenario.noise;
+    config.dropoutsPerMinute = scenario.dropoutsPerMinute;
+    config.seed = k + 1;
+    SyntheticPPG signal;
+    generateSyntheticPPG(config, signal);
+
+    printf("%-13s %5lu", scenario.name, (unsigned long) signal.beats.size());
+    for (int filtered = 0; filtered < 2; ++filtered) {
+      Result result = findBeats(signal, sampleRate, seconds,
+        scenario.dropoutsPerMinute, filtered != 0);
+      const BeatMatches &matches = result.matches;
+      printf("  %6.1f %6.2f %6lu %6.1f",
+        percent(matches.truePositives, matches.beats),
+        matches.falsePositives * 60.0 / seconds, result.resets,
+        matches.truePositives ? matches.lateSum / matches.truePositives : 0.0);
+    }
+    printf("\n");
+    if (k == sizeof(SCENARIOS) / sizeof(SCENARIOS[0]) - 1) {
+      timed = signal;
+    }
+  }
+
+  double nanos, cycles;
+  timeFilter(timed, nanos, cycles);
+  printf("\nfilter alone: %.1f ns/sample", nanos);
+  if (cycles > 0.0) {
+    printf(", %.0f time stamp counter cycles/sample", cycles);
+  }
+  printf("\n");
+  return 0;
+}
@@ -0,0 +1,270 @@
+/*
+   Heart rate variability from PulseSensorHRV on synthetic PPG signals
+   (see synth/synthetic_ppg.h), against the signals' true IBIs.
+   Built against a Playground compiled with PULSE_SENSOR_INTERPOLATE_BEATS true.
+
+   Usage:
+     hrv_bench [seconds]
+
+     seconds  length of each signal (default 300).
+
+   For each scenario, prints RMSSD, SDNN (ms) and pNN50 (%)
+   over the last 64 IBIs:
+     true     from the signal's own IBIs.
+     ms       from a PulseSensorHRV fed getInterBeatIntervalMs().
+     us       from the Playground's PulseSensorHRV (getHRV()), fed
+              the interpolated IBIs.
+   then the IBIs left out as artifacts, and the largest difference
+   (ms) between getHRV() and the same measures worked out directly
+   from the window at every beat, which should be rounding error only.
+   Finally, times PulseSensorHRV::addBeat() for several window sizes,
+   which should cost the same for all of them.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include <synthetic_ppg.h>
+
+#include <chrono>
+#include <deque>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#if !PULSE_SENSOR_INTERPOLATE_BEATS
+#error "hrv_bench needs PULSE_SENSOR_INTERPOLATE_BEATS true"
+#endif
+
+static const byte WINDOW = 64;
+
+struct Scenario {
+  const char *name;
+  unsigned int sampleRate;
+  double variability;
+  double noise;
+  double dropoutsPerMinute;
+};
+
+static const Scenario SCENARIOS[] = {
+  // name          rate  var  noise drops
+  { "steady",       500, 0.00,   0,   0 },
+  { "rsa 3%",       500, 0.03,   0,   0 },
+  { "rsa 8%",       500, 0.08,   0,   0 },
+  { "rsa 3% 250Hz", 250, 0.03,   0,   0 },
+  { "noise 5",      500, 0.05,   5,   0 },
+  { "dropouts",     500, 0.05,   0,   1 },
+};
+
+struct Measures {
+  Measures() : rmssd(0.0), sdnn(0.0), pnn50(0.0) {}
+  double rmssd;
+  double sdnn;
+  double pnn50;
+};
+
+// An IBI (ms) and whether it follows the one before it.
+struct Interval {
+  double ms;
+  bool successive;
+};
+
+static Measures direct(const std::deque<Interval> &window) {
+  Measures measures;
+  double sum = 0.0;
+  for (size_t i = 0; i < window.size(); ++i) {
+    sum += window[i].ms;
+  }
+  double mean = sum / window.size();
+  double squares = 0.0;
+  double differenceSquares = 0.0;
+  int differences = 0;
+  int nn50 = 0;
+  for (size_t i = 0; i < window.size(); ++i) {
+    squares += (window[i].ms - mean) * (window[i].ms - mean);
+    if (i > 0 && window[i].successive) {
+      double difference = window[i].ms - window[i - 1].ms;
+      differenceSquares += difference * difference;
+      ++differences;
+      if (fabs(difference) > 50.0) {
+        ++nn50;
+      }
+    }
+  }
+  if (window.size() > 1) {
+    measures.sdnn = sqrt(squares / (window.size() - 1));
+  }
+  if (differences > 0) {
+    measures.rmssd = sqrt(differenceSquares / differences);
+    measures.pnn50 = 100.0 * nn50 / differences;
+  }
+  return measures;
+}
+
+static Measures fromMetrics(const HRVMetrics &metrics) {
+  Measures measures;
+  measures.rmssd = metrics.rmssdMs;
+  measures.sdnn = metrics.sdnnMs;
+  measures.pnn50 = metrics.pnn50Percent;
+  return measures;
+}
+
+static volatile bool signalLost;
+
+static void sawSignalLost(const BeatEvent &, void *) {
+  signalLost = true;
+}
+
+static double addBeatNanos(byte capacity) {
+  std::vector<word> storage(capacity);
+  PulseSensorHRV hrv(storage.data(), capacity);
+  hrv.setArtifactLimit(0);
+  const unsigned long beats = 2000000UL;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned long i = 0; i < beats; ++i) {
+    hrv.addBeat(PulseSensor::FOUND_BEAT_START, 800000UL + (i * 7919UL) % 100000UL);
+  }
+  auto end = std::chrono::steady_clock::now();
+  HRVMetrics metrics;
+  hrv.getMetrics(metrics);
+  if (metrics.intervals != capacity) {
+    fprintf(stderr, "window %u: %u IBIs\n", capacity, metrics.intervals);
+    exit(1);
+  }
+  return std::chrono::duration<double, std::nano>(end - start).count() / beats;
+}
+
+int main(int argc, char *argv[]) {
+  double seconds = argc > 1 ? atof(argv[1]) : 300.0;
+
+  printf("last %u IBIs\n", WINDOW);
+  printf("%-12s %5s  %6s %6s %6s  %6s %6s %6s  %5s %5s %5s  %4s %8s\n", "signal", "beats",
+    "rmssd", "ms", "us", "sdnn", "ms", "us", "pnn50", "ms", "us", "rej", "max diff");
+
+  for (size_t k = 0; k < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); ++k) {
+    const Scenario &scenario = SCENARIOS[k];
+    SyntheticPPGConfig config;
+    config.seconds = seconds;
+    config.sampleRate = scenario.sampleRate;
+    config.bpm = 72;
+    config.variability = scenario.variability;
+    config.noise = scenario.noise;
+    config.dropoutsPerMinute = scenario.dropoutsPerMinute;
+    config.seed = k + 1;
+    SyntheticPPG ppg;
+    generateSyntheticPPG(config, ppg);
+
+    // The truth: the last WINDOW IBIs of the signal.
+    std::deque<Interval> truth;
+    for (size_t b = 1; b < ppg.beats.size(); ++b) {
+      Interval interval = { ppg.beats[b].ibiMs, true };
+      truth.push_back(interval);
+      if (truth.size() > WINDOW) {
+        truth.pop_front();
+      }
+    }
+    truth.front().successive = false;
+
+    std::vector<int> channel(ppg.samples.begin(), ppg.samples.end());
+    ArduinoShim::reset();
+    PulseSensorPlayground pulse;
+    word ibiStorage[WINDOW];
+    PulseSensorHRV hrv(ibiStorage, WINDOW);
+    pulse.setHRV(hrv);
+    word msStorage[WINDOW];
+    PulseSensorHRV msHRV(msStorage, WINDOW);
+    signalLost = false;
+    pulse.onSignalLost(sawSignalLost, NULL, true);
+    pulse.setSampleRate(scenario.sampleRate);
+    pulse.analogInput(A0);
+    pulse.setThreshold(550);
+    ArduinoShim::setAnalogSamples(A0, channel.data(), channel.size());
+    const unsigned long interval = pulse.getSampleIntervalMicros();
+
+    // The same window, kept directly, with the same artifact rule.
+    std::deque<Interval> window;
+    bool successive = false;
+    double previousMs = 0.0;
+    double maxDifference = 0.0;
+    unsigned long beats = 0;
+
+    pulse.begin();
+    for (size_t f = 0; f < channel.size(); ++f) {
+      ArduinoShim::setMicros((f + 1) * interval);
+      if (!pulse.sawNewSample()) {
+        continue;
+      }
+      if (signalLost) {
+        signalLost = false;
+        successive = false;
+        previousMs = 0.0;
+        msHRV.addBeat(PulseSensor::FOUND_SIGNAL_LOST, 0);
+      }
+      if (!pulse.sawStartOfBeat()) {
+        continue;
+      }
+      ++beats;
+      msHRV.addBeat(PulseSensor::FOUND_BEAT_START, pulse.getInterBeatIntervalMs() * 1000UL);
+
+      double ibiMs = ((pulse.getInterBeatIntervalMicros() + 50) / 100) / 10.0;
+      bool artifact = previousMs != 0.0
+        && fabs(ibiMs - previousMs) * 100 > previousMs * PULSE_SENSOR_HRV_ARTIFACT_PERCENT;
+      previousMs = ibiMs;
+      if (artifact) {
+        successive = false;
+        continue;
+      }
+      Interval entry = { ibiMs, successive && !window.empty() };
+      window.push_back(entry);
+      if (window.size() > WINDOW) {
+        window.pop_front();
+        window.front().successive = false;
+      }
+      successive = true;
+
+      HRVMetrics metrics;
+      if (pulse.getHRV(metrics)) {
+        Measures expected = direct(window);
+        Measures streamed = fromMetrics(metrics);
+        maxDifference = fmax(maxDifference, fabs(expected.rmssd - streamed.rmssd));
+        maxDifference = fmax(maxDifference, fabs(expected.sdnn - streamed.sdnn));
+      }
+    }
+
+    HRVMetrics metrics;
+    Measures trueMeasures = direct(truth);
+    Measures msMeasures;
+    Measures usMeasures;
+    unsigned long rejected = 0;
+    if (msHRV.getMetrics(metrics)) {
+      msMeasures = fromMetrics(metrics);
+    }
+    if (pulse.getHRV(metrics)) {
+      usMeasures = fromMetrics(metrics);
+      rejected = metrics.rejected;
+    }
+    printf("%-12s %5lu  %6.1f %6.1f %6.1f  %6.1f %6.1f %6.1f  %5.1f %5.1f %5.1f  %4lu %8.5f\n",
+      scenario.name, beats,
+      trueMeasures.rmssd, msMeasures.rmssd, usMeasures.rmssd,
+      trueMeasures.sdnn, msMeasures.sdnn, usMeasures.sdnn,
+      trueMeasures.pnn50, msMeasures.pnn50, usMeasures.pnn50,
+      rejected, maxDifference);
+  }
+
+  printf("\n%-8s %10s\n", "window", "ns/beat");
+  const byte capacities[] = { 8, 64, 255 };
+  for (size_t i = 0; i < sizeof(capacities); ++i) {
+    printf("%-8u %10.1f\n", capacities[i], addBeatNanos(capacities[i]));
+  }
+  return 0;
+}
@@ -0,0 +1,164 @@
+/*
+   What setOversampling() buys and costs, on synthetic PPG signals
+   (see synth/synthetic_ppg.h) read through a noisy simulated ADC.
+
+   Usage:
+     oversample_bench [seconds]
+
+     seconds  length of each signal (default 120).
+
+   Each sample period, the simulated ADC returns the clean signal
+   (moved by a slowly changing fraction of a count, so it falls between
+   counts) plus Gaussian noise, rounded to a whole count, once for every
+   reading the Playground takes. For each ADC noise level and oversampling
+   ratio, prints the RMS error (ADC counts) against the clean signal of:
+     sample   getLatestSample(), what the beat finder sees.
+     fine     getOversampledSample(), scaled back to 0..1023.
+   and the effective bits gained over a single reading.
+
+   Then, with each analogRead() taking as long as it does on a 16MHz
+   AVR (112 us) and on a typical 32-bit board (10 us), prints the
+   largest acquisition time per sample (getTimingHistogram()) for
+   1 to 8 PulseSensors, as a percent of the 2000 us sample interval
+   at 500 samples per second. Over 100% can't keep up.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include <synthetic_ppg.h>
+
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+static const byte RATIOS[] = { 1, 2, 4, 8, 16 };
+static const double NOISES[] = { 0.5, 2.0, 5.0 };
+static const int SENSOR_COUNTS[] = { 1, 2, 4, 8 };
+static const unsigned long CONVERSION_MICROS[] = { 112, 10 };
+
+// The ADC readings for ratio readings a sample of the clean signal.
+static std::vector<int> noisyReadings(const std::vector<double> &clean,
+  byte ratio, double noise, unsigned long seed) {
+  std::mt19937 random(seed);
+  std::normal_distribution<double> gaussian(0.0, noise);
+  std::vector<int> readings;
+  readings.reserve(clean.size() * ratio);
+  for (size_t i = 0; i < clean.size(); ++i) {
+    for (byte r = 0; r < ratio; ++r) {
+      long value = lround(clean[i] + gaussian(random));
+      readings.push_back((int) constrain(value, 0L, 1023L));
+    }
+  }
+  return readings;
+}
+
+// The extra bits getOversampledSample() has at each ratio.
+static int fineBits(byte ratio) {
+  int shift = 0;
+  while ((1 << shift) < ratio) {
+    ++shift;
+  }
+  return shift / 2;
+}
+
+int main(int argc, char *argv[]) {
+  double seconds = argc > 1 ? atof(argv[1]) : 120.0;
+
+  SyntheticPPGConfig config;
+  config.seconds = seconds;
+  SyntheticPPG ppg;
+  generateSyntheticPPG(config, ppg);
+  std::vector<double> clean(ppg.samples.size());
+  for (size_t i = 0; i < clean.size(); ++i) {
+    clean[i] = ppg.samples[i] + 0.5 * sin(i * 0.0063);
+  }
+
+  printf("%6s %5s  %8s %8s %6s\n", "noise", "ratio", "sample", "fine", "bits");
+  for (size_t n = 0; n < sizeof(NOISES) / sizeof(NOISES[0]); ++n) {
+    double singleError = 0.0;
+    for (size_t r = 0; r < sizeof(RATIOS); ++r) {
+      byte ratio = RATIOS[r];
+      std::vector<int> readings = noisyReadings(clean, ratio, NOISES[n], 1000 + n);
+
+      ArduinoShim::reset();
+      PulseSensorPlayground pulse;
+      pulse.analogInput(A0);
+      pulse.setOversampling(ratio);
+      ArduinoShim::setAnalogSamples(A0, readings.data(), readings.size());
+      const unsigned long interval = pulse.getSampleIntervalMicros();
+      const double fineScale = 1.0 / (1 << fineBits(ratio));
+
+      double sampleSquares = 0.0;
+      double fineSquares = 0.0;
+      size_t count = 0;
+      pulse.begin();
+      for (size_t i = 0; i < clean.size(); ++i) {
+        ArduinoShim::setMicros((i + 1) * interval);
+        if (!pulse.sawNewSample()) {
+          continue;
+        }
+        double sampleError = pulse.getLatestSample() - clean[i];
+        double fineError = pulse.getOversampledSample() * fineScale - clean[i];
+        sampleSquares += sampleError * sampleError;
+        fineSquares += fineError * fineError;
+        ++count;
+      }
+      double sampleRms = sqrt(sampleSquares / count);
+      double fineRms = sqrt(fineSquares / count);
+      if (ratio == 1) {
+        singleError = fineRms;
+      }
+      printf("%6.1f %5u  %8.3f %8.3f %6.2f\n", NOISES[n], ratio, sampleRms, fineRms,
+        fineRms > 0.0 ? log2(singleError / fineRms) : 0.0);
+    }
+  }
+
+  for (size_t c = 0; c < sizeof(CONVERSION_MICROS) / sizeof(CONVERSION_MICROS[0]); ++c) {
+    printf("\nacquisition, %lu us per analogRead(): us per sample (%% of 2000 us)\n",
+      CONVERSION_MICROS[c]);
+    printf("%5s", "ratio");
+    for (size_t s = 0; s < sizeof(SENSOR_COUNTS) / sizeof(SENSOR_COUNTS[0]); ++s) {
+      printf("  %7d sensor%s", SENSOR_COUNTS[s], SENSOR_COUNTS[s] == 1 ? " " : "s");
+    }
+    printf("\n");
+    for (size_t r = 0; r < sizeof(RATIOS); ++r) {
+      printf("%5u", RATIOS[r]);
+      for (size_t s = 0; s < sizeof(SENSOR_COUNTS) / sizeof(SENSOR_COUNTS[0]); ++s) {
+        int sensors = SENSOR_COUNTS[s];
+        ArduinoShim::reset();
+        ArduinoShim::setAnalogReadMicros(CONVERSION_MICROS[c]);
+        PulseSensorPlayground pulse(sensors);
+        for (int i = 0; i < sensors; ++i) {
+          pulse.analogInput(A0 + i, i);
+        }
+        pulse.setOversampling(RATIOS[r]);
+        const unsigned long interval = pulse.getSampleIntervalMicros();
+        pulse.begin();
+        for (int i = 0; i < 100; ++i) {
+          if (micros() < (i + 1) * interval) {
+            ArduinoShim::setMicros((i + 1) * interval);
+          }
+          pulse.sawNewSample();
+        }
+        PulseSensorTimingHistogram timing;
+        pulse.getTimingHistogram(timing);
+        unsigned long acquisition = timing.getMaxAcquisitionMicros();
+        printf("  %6lu (%3.0f%%)", acquisition, 100.0 * acquisition / interval);
+      }
+      printf("\n");
+    }
+  }
+  return 0;
+}
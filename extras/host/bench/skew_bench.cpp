@@ -0,0 +1,162 @@
+/*
+   How much reading PulseSensors one after another adds to a Pulse
+   Transit Time, and how much of it setSkewCompensation() takes away,
+   on synthetic PPG signals (see synth/synthetic_ppg.h). Built against
+   a Playground compiled with PULSE_SENSOR_ACQUISITION_TIMES true, and
+   with PULSE_SENSOR_INTERPOLATE_BEATS true so the beat times are finer
+   than the skew.
+
+   Usage:
+     skew_bench [seconds]
+
+     seconds  length of each signal (default 120).
+
+   The signals are generated at 20000 samples per second and read with
+   ArduinoShim::setAnalogWaveform(), so each PulseSensor sees the signal
+   as it was when it was read. PulseSensor 0 has the proximal signal;
+   the others all have the same signal 2 ms later, and the last one's
+   Pulse Transit Time from PulseSensor 0 is measured. Half a count of
+   noise dithers the rounding to whole counts, which would otherwise
+   hide a skew that moves the signal by less than a count.
+   For each way of reading them, prints:
+     skew     getAcquisitionOffsetMicros() of the last PulseSensor
+              less that of the first (us).
+     off, on  the mean and RMS error (us) of the Pulse Transit Times
+              against 2 ms, without and with skew compensation.
+   What error is left with compensation is the noise's, and the
+   threshold's, as in beat_time_bench.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include <SimulatedDMA.h>
+#include <synthetic_ppg.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#if !PULSE_SENSOR_INTERPOLATE_BEATS
+#error "skew_bench needs PULSE_SENSOR_INTERPOLATE_BEATS true"
+#endif
+#if !PULSE_SENSOR_ACQUISITION_TIMES
+#error "skew_bench needs PULSE_SENSOR_ACQUISITION_TIMES true"
+#endif
+
+static const unsigned int WAVEFORM_RATE = 20000;
+static const double DELAY_MS = 2.0;
+static const double NOISE = 0.5;
+static const int DMA_FRAMES = 50;
+
+struct Scenario {
+  const char *name;
+  int sensors;
+  unsigned long readMicros;   // per analogRead(), or 0 to read by SimulatedDMA.
+  byte ratio;                 // setOversampling().
+};
+
+static const Scenario SCENARIOS[] = {
+  // name        sensors  read ratio
+  { "AVR",             2,  112,   1 },
+  { "AVR",             4,  112,   1 },
+  { "AVR x4",          4,  112,   4 },
+  { "32-bit",          4,   10,   1 },
+  { "DMA",             2,    0,   1 },
+  { "DMA",             4,    0,   1 },
+};
+
+// Errors of the Pulse Transit Times, in microseconds.
+struct TransitErrors {
+  TransitErrors() : sum(0.0), squares(0.0), count(0), skew(0) {}
+  void add(double error) { sum += error; squares += error * error; ++count; }
+  double mean() const { return count ? sum / count : 0.0; }
+  double rms() const { return count ? sqrt(squares / count) : 0.0; }
+  double sum;
+  double squares;
+  unsigned long count;
+  long skew;
+};
+
+static TransitErrors run(const Scenario &scenario, const std::vector<int> &proximal,
+  const std::vector<int> &distal, double seconds, bool compensate) {
+  ArduinoShim::reset();
+  ArduinoShim::setAnalogReadMicros(scenario.readMicros);
+  const double waveformMicros = 1000000.0 / WAVEFORM_RATE;
+  PulseSensorPlayground pulse(scenario.sensors);
+  for (int i = 0; i < scenario.sensors; ++i) {
+    pulse.analogInput(A0 + i, i);
+    const std::vector<int> &signal = i == 0 ? proximal : distal;
+    ArduinoShim::setAnalogWaveform(A0 + i, signal.data(), signal.size(), waveformMicros);
+  }
+  pulse.setOversampling(scenario.ratio);
+  pulse.setSkewCompensation(compensate);
+
+  int last = scenario.sensors - 1;
+  TransitTimeEvent transitStorage[4];
+  PulseSensorTransitTime transit(0, last, transitStorage, 4);
+  pulse.addTransitTime(transit);
+
+  std::vector<int16_t> dmaStorage(2 * DMA_FRAMES * scenario.sensors);
+  SimulatedDMA dma(dmaStorage.data(), DMA_FRAMES);
+  if (scenario.readMicros == 0) {
+    pulse.setAcquisition(dma);
+  }
+
+  TransitErrors errors;
+  const unsigned long interval = pulse.getSampleIntervalMicros();
+  const unsigned long samples = (unsigned long) (seconds * 1000000.0 / interval);
+  pulse.begin();
+  for (unsigned long i = 0; i < samples; ++i) {
+    if (micros() < (i + 1) * interval) {
+      ArduinoShim::setMicros((i + 1) * interval);
+    }
+    pulse.sawNewSample();
+    TransitTimeEvent event;
+    while (transit.readTransitTimes(&event, 1) == 1) {
+      errors.add(event.transitTimeMicros - DELAY_MS * 1000.0);
+    }
+  }
+  errors.skew = (long) pulse.getAcquisitionOffsetMicros(last)
+    - (long) pulse.getAcquisitionOffsetMicros(0);
+  return errors;
+}
+
+int main(int argc, char *argv[]) {
+  double seconds = argc > 1 ? atof(argv[1]) : 120.0;
+
+  SyntheticPPGConfig config;
+  config.seconds = seconds + 1.0;  // room for the last sample's readings.
+  config.sampleRate = WAVEFORM_RATE;
+  config.variability = 0.05;
+  config.noise = NOISE;
+  SyntheticPPG proximal;
+  generateSyntheticPPG(config, proximal);
+  config.delayMs = DELAY_MS;
+  SyntheticPPG distal;
+  generateSyntheticPPG(config, distal);
+  std::vector<int> proximalSignal(proximal.samples.begin(), proximal.samples.end());
+  std::vector<int> distalSignal(distal.samples.begin(), distal.samples.end());
+
+  printf("%-8s %7s %5s %5s %6s  %8s %8s  %8s %8s %6s\n", "read", "sensors", "us",
+    "ratio", "skew", "off mean", "off rms", "on mean", "on rms", "beats");
+  for (size_t k = 0; k < sizeof(SCENARIOS) / sizeof(SCENARIOS[0]); ++k) {
+    const Scenario &scenario = SCENARIOS[k];
+    TransitErrors off = run(scenario, proximalSignal, distalSignal, seconds, false);
+    TransitErrors on = run(scenario, proximalSignal, distalSignal, seconds, true);
+    printf("%-8s %7d %5lu %5u %6ld  %8.1f %8.1f  %8.1f %8.1f %6lu\n",
+      scenario.name, scenario.sensors, scenario.readMicros, scenario.ratio, off.skew,
+      off.mean(), off.rms(), on.mean(), on.rms(), on.count);
+  }
+  return 0;
+}
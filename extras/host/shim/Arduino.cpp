@@ -0,0 +1,319 @@
+/*
+   Minimal Arduino core for building the PulseSensor Playground
+   on a desktop computer. See Arduino.h in this folder.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include "Arduino.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+/*
+   Simulated board state.
+*/
+static unsigned long NowMicros = 0;
+static std::vector<int> AnalogSamples[NUM_SHIM_PINS];
+static size_t AnalogNext[NUM_SHIM_PINS];
+static double WaveformMicros[NUM_SHIM_PINS]; // setAnalogWaveform()'s sample period, or 0.
+static int PinValues[NUM_SHIM_PINS];
+static unsigned long PinWrites = 0;
+static unsigned long AnalogReadMicros = 0;
+
+unsigned long micros() {
+  return NowMicros;
+}
+
+unsigned long millis() {
+  return NowMicros / 1000UL;
+}
+
+void delay(unsigned long ms) {
+  NowMicros += ms * 1000UL;
+}
+
+void delayMicroseconds(unsigned int us) {
+  NowMicros += us;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void) pin;
+  (void) mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  if (pin < NUM_SHIM_PINS) {
+    PinValues[pin] = val;
+  }
+  ++PinWrites;
+}
+
+int digitalRead(uint8_t pin) {
+  return pin < NUM_SHIM_PINS ? (PinValues[pin] ? HIGH : LOW) : LOW;
+}
+
+int analogRead(uint8_t pin) {
+  unsigned long readMicros = NowMicros;
+  NowMicros += AnalogReadMicros;
+  if (pin >= NUM_SHIM_PINS) {
+    return 512; // idle PulseSensor signal.
+  }
+  if (WaveformMicros[pin] > 0.0) {
+    const std::vector<int> &samples = AnalogSamples[pin];
+    double position = readMicros / WaveformMicros[pin];
+    size_t index = (size_t) position;
+    if (index + 1 >= samples.size()) {
+      return 512;
+    }
+    double fraction = position - index;
+    return (int) lround(samples[index] + fraction * (samples[index + 1] - samples[index]));
+  }
+  if (AnalogNext[pin] >= AnalogSamples[pin].size()) {
+    return 512;
+  }
+  return AnalogSamples[pin][AnalogNext[pin]++];
+}
+
+void analogWrite(uint8_t pin, int val) {
+  if (pin < NUM_SHIM_PINS) {
+    PinValues[pin] = val;
+  }
+  ++PinWrites;
+}
+
+namespace ArduinoShim {
+  void setAnalogSamples(uint8_t pin, const int *samples, size_t count) {
+    if (pin >= NUM_SHIM_PINS) {
+      return;
+    }
+    AnalogSamples[pin].assign(samples, samples + count);
+    AnalogNext[pin] = 0;
+    WaveformMicros[pin] = 0.0;
+  }
+
+  void setAnalogWaveform(uint8_t pin, const int *samples, size_t count,
+    double microsPerSample) {
+    if (pin >= NUM_SHIM_PINS || microsPerSample <= 0.0) {
+      return;
+    }
+    AnalogSamples[pin].assign(samples, samples + count);
+    AnalogNext[pin] = 0;
+    WaveformMicros[pin] = microsPerSample;
+  }
+
+  size_t analogSamplesRemaining(uint8_t pin) {
+    if (pin >= NUM_SHIM_PINS) {
+      return 0;
+    }
+    if (WaveformMicros[pin] > 0.0) {
+      // The samples not yet passed by the clock.
+      size_t passed = (size_t) (NowMicros / WaveformMicros[pin]);
+      return passed < AnalogSamples[pin].size() ? AnalogSamples[pin].size() - passed : 0;
+    }
+    return AnalogSamples[pin].size() - AnalogNext[pin];
+  }
+
+  void setMicros(unsigned long now) {
+    NowMicros = now;
+  }
+
+  void advanceMicros(unsigned long delta) {
+    NowMicros += delta;
+  }
+
+  void setAnalogReadMicros(unsigned long conversionMicros) {
+    AnalogReadMicros = conversionMicros;
+  }
+
+  int pinValue(uint8_t pin) {
+    return pin < NUM_SHIM_PINS ? PinValues[pin] : 0;
+  }
+
+  unsigned long pinWriteCount() {
+    return PinWrites;
+  }
+
+  void reset() {
+    NowMicros = 0;
+    PinWrites = 0;
+    AnalogReadMicros = 0;
+    for (int i = 0; i < NUM_SHIM_PINS; ++i) {
+      AnalogSamples[i].clear();
+      AnalogNext[i] = 0;
+      WaveformMicros[i] = 0.0;
+      PinValues[i] = 0;
+    }
+  }
+}
+
+/*
+   CaptureStream
+*/
+namespace ArduinoShim {
+  CaptureStream::CaptureStream()
+    : WriteSpace(-1), Baud(0), FifoSize(0), ByteMicros(0.0),
+      SendingUntil(0.0), StalledMicros(0) {
+  }
+
+  void CaptureStream::setBaudRate(unsigned long baud, int fifoSize) {
+    Baud = baud;
+    FifoSize = fifoSize > 0 ? fifoSize : 1;
+    ByteMicros = baud ? 10e6 / baud : 0.0;
+    SendingUntil = (double) NowMicros;
+  }
+
+  int CaptureStream::availableForWrite() {
+    if (WriteSpace >= 0) {
+      return WriteSpace;
+    }
+    if (!Baud) {
+      return 0x7FFF;
+    }
+    double sending = SendingUntil - (double) NowMicros;
+    if (sending <= 0.0) {
+      return FifoSize;
+    }
+    int queued = (int) ceil(sending / ByteMicros);
+    return queued >= FifoSize ? 0 : FifoSize - queued;
+  }
+
+  size_t CaptureStream::write(uint8_t c) {
+    if (Baud) {
+      double now = (double) NowMicros;
+      if (SendingUntil < now) {
+        SendingUntil = now;
+      }
+      // Wait until the byte fits in the transmit buffer.
+      double roomAt = SendingUntil - (FifoSize - 1) * ByteMicros;
+      if (roomAt > now) {
+        unsigned long wait = (unsigned long) ceil(roomAt - now);
+        NowMicros += wait;
+        StalledMicros += wait;
+      }
+      SendingUntil += ByteMicros;
+    }
+    Captured.push_back((char) c);
+    return 1;
+  }
+}
+
+/*
+   Print
+*/
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::printNumber(unsigned long n, int base) {
+  char buf[8 * sizeof(long) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+
+  *str = '\0';
+  if (base < 2) {
+    base = 10;
+  }
+  do {
+    char c = (char) (n % base);
+    n /= base;
+    *--str = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (n);
+
+  return write(str);
+}
+
+size_t Print::print(const char str[]) {
+  return write(str);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t) c);
+}
+
+size_t Print::print(unsigned char n, int base) {
+  return print((unsigned long) n, base);
+}
+
+size_t Print::print(int n, int base) {
+  return print((long) n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+  return print((unsigned long) n, base);
+}
+
+size_t Print::print(long n, int base) {
+  if (base == 10 && n < 0) {
+    size_t t = print('-');
+    return t + printNumber(0UL - (unsigned long) n, 10);
+  }
+  return printNumber((unsigned long) n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  return printNumber(n, base);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t Print::println() {
+  return write("\r\n");
+}
+
+size_t Print::println(const char str[]) {
+  size_t n = print(str);
+  return n + println();
+}
+
+size_t Print::println(char c) {
+  size_t n = print(c);
+  return n + println();
+}
+
+size_t Print::println(unsigned char b, int base) {
+  size_t n = print(b, base);
+  return n + println();
+}
+
+size_t Print::println(int num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(unsigned int num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(long num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(unsigned long num, int base) {
+  size_t n = print(num, base);
+  return n + println();
+}
+
+size_t Print::println(double num, int digits) {
+  size_t n = print(num, digits);
+  return n + println();
+}
@@ -0,0 +1,217 @@
+/*
+   Minimal Arduino core for building the PulseSensor Playground
+   on a desktop computer (Linux, macOS) for profiling and replay.
+   See extras/host/README.md
+
+   This is NOT a complete Arduino core. It provides just enough of the
+   Arduino API for the library sources to compile, plus a few controls
+   (in namespace ArduinoShim) that a host program uses to feed analog
+   samples, move the simulated clock, and inspect pin writes.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef ARDUINO_SHIM_H
+#define ARDUINO_SHIM_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+
+typedef uint8_t byte;
+typedef uint16_t word;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+
+/*
+   Pin numbering follows the Arduino Uno.
+*/
+#define LED_BUILTIN 13
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define A6 20
+#define A7 21
+#define NUM_SHIM_PINS 32
+
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+
+// Strings live in ordinary memory on the host.
+#define F(string_literal) (string_literal)
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+
+unsigned long micros();
+unsigned long millis();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+
+/*
+   Print and Stream, trimmed to what the library and its examples use.
+*/
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    virtual int availableForWrite() { return 0; }
+    size_t write(const char *str) {
+      return str ? write((const uint8_t *) str, strlen(str)) : 0;
+    }
+
+    size_t print(const char str[]);
+    size_t print(char c);
+    size_t print(unsigned char n, int base = DEC);
+    size_t print(int n, int base = DEC);
+    size_t print(unsigned int n, int base = DEC);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double n, int digits = 2);
+
+    size_t println();
+    size_t println(const char str[]);
+    size_t println(char c);
+    size_t println(unsigned char n, int base = DEC);
+    size_t println(int n, int base = DEC);
+    size_t println(unsigned int n, int base = DEC);
+    size_t println(long n, int base = DEC);
+    size_t println(unsigned long n, int base = DEC);
+    size_t println(double n, int digits = 2);
+
+  private:
+    size_t printNumber(unsigned long n, int base);
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+};
+
+namespace ArduinoShim {
+  /*
+     Feed analogRead(pin) from the given samples, one sample per call.
+     The samples are copied. Once they run out, analogRead(pin)
+     returns 512, the idle value of a PulseSensor.
+  */
+  void setAnalogSamples(uint8_t pin, const int *samples, size_t count);
+
+  // Number of samples not yet returned by analogRead(pin),
+  // or for a waveform, not yet passed by the clock.
+  size_t analogSamplesRemaining(uint8_t pin);
+
+  /*
+     Feed analogRead(pin) from a signal sampled every microsPerSample
+     microseconds from time 0, instead: each call returns the signal at
+     micros() (before setAnalogReadMicros() moves the clock on), by a
+     straight line between the samples either side, rounded.
+     So PulseSensors read at different times see different values.
+     The samples are copied. Past the end, analogRead(pin) returns 512.
+     setAnalogSamples() on the pin goes back to one sample per call.
+  */
+  void setAnalogWaveform(uint8_t pin, const int *samples, size_t count,
+    double microsPerSample);
+
+  // Set or advance the simulated clock read by micros() and millis().
+  void setMicros(unsigned long now);
+  void advanceMicros(unsigned long delta);
+
+  /*
+     Have each analogRead() move the clock on by conversionMicros,
+     as a real ADC conversion takes time (about 112 on a 16MHz AVR).
+     0, the default, takes no time.
+  */
+  void setAnalogReadMicros(unsigned long conversionMicros);
+
+  // Most recent digitalWrite() or analogWrite() value on the pin.
+  int pinValue(uint8_t pin);
+
+  // Number of digitalWrite() + analogWrite() calls since reset().
+  unsigned long pinWriteCount();
+
+  // Clear all samples, pin state, and the clock.
+  void reset();
+
+  /*
+     A Stream that keeps everything written to it,
+     in place of Serial, for checking and replaying output.
+  */
+  class CaptureStream : public Stream {
+    public:
+      CaptureStream();
+
+      size_t write(uint8_t c);
+      using Print::write;
+
+      /*
+         -1 (the default) reports unlimited space. Anything else is
+         reported as-is, to exercise code that avoids blocking writes.
+      */
+      void setAvailableForWrite(int space) { WriteSpace = space; }
+      int availableForWrite();
+
+      /*
+         Act like a UART sending baud bits per second (10 bits a byte)
+         from a transmit buffer of fifoSize bytes, timed by micros().
+         availableForWrite() reports the room left in the buffer, and
+         a write to a full buffer waits for room by advancing the
+         simulated clock, as Serial.write() would.
+         0 (the default) sends instantly.
+      */
+      void setBaudRate(unsigned long baud, int fifoSize = 64);
+
+      // Total simulated time writes have waited for room.
+      unsigned long stalledMicros() const { return StalledMicros; }
+
+      int available() { return 0; }
+      int read() { return -1; }
+      int peek() { return -1; }
+
+      const std::string &captured() const { return Captured; }
+      void clear() { Captured.clear(); }
+
+    private:
+      std::string Captured;
+      int WriteSpace;
+      unsigned long Baud;
+      int FifoSize;
+      double ByteMicros;        // time to send one byte.
+      double SendingUntil;      // micros() when the transmit buffer will be empty.
+      unsigned long StalledMicros;
+  };
+}
+
+#endif // ARDUINO_SHIM_H
@@ -0,0 +1,73 @@
+/*
+   A simulated DMA acquisition for the host build.
+   See SimulatedDMA.h
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include "SimulatedDMA.h"
+
+SimulatedDMA::SimulatedDMA(int16_t *storage, int framesPerBlock,
+  byte conversions, byte bits)
+  : PulseSensorAcquisition(storage, framesPerBlock) {
+  SimulatedConversions = conversions ? conversions : 1;
+  Bits = constrain(bits, 10, 15);
+  Running = false;
+  Sensors = NULL;
+}
+
+bool SimulatedDMA::startScan(PulseSensor *sensors, byte sensorCount,
+  unsigned long intervalMicros) {
+  Conversions = SimulatedConversions;
+  SampleShift = Bits - 10;
+  // Conversions spread evenly over the frame, as on an RP2040.
+  ConversionNanos = intervalMicros * 1000UL / (sensorCount * Conversions);
+  Rounds = Conversions;
+  Sensors = sensors;
+  IntervalMicros = intervalMicros;
+  StartMicros = micros();
+  FramesWritten = 0;
+  Filling = 0;
+  FrameIndex = 0;
+  Running = true;
+  return true;
+}
+
+void SimulatedDMA::stopScan() {
+  Running = false;
+}
+
+void SimulatedDMA::poll() {
+  /*
+     Write every frame that's come due, as the hardware would have,
+     reading each pin when getOffsetMicros() says it was converted
+     (see ArduinoShim::setAnalogWaveform()), then putting the clock back.
+  */
+  unsigned long now = micros();
+  while (Running && now - StartMicros >= (FramesWritten + 1) * IntervalMicros) {
+    int16_t *pFrame = getBlock(Filling) + FrameIndex * SensorCount * Conversions;
+    for (byte s = 0; s < SensorCount; ++s) {
+      ArduinoShim::setMicros(StartMicros + FramesWritten * IntervalMicros + getOffsetMicros(s));
+      int16_t conversion = (int16_t) (analogRead(Sensors[s].getInputPin()) << SampleShift);
+      for (byte c = 0; c < Conversions; ++c) {
+        pFrame[c * SensorCount + s] = conversion;
+      }
+    }
+    ++FramesWritten;
+    if (++FrameIndex >= getFramesPerBlock()) {
+      blockComplete(Filling);
+      Filling ^= 1;
+      FrameIndex = 0;
+    }
+  }
+  ArduinoShim::setMicros(now);
+}
@@ -0,0 +1,61 @@
+/*
+   A simulated DMA acquisition for the host build, so Sketches and tools
+   can exercise PulseSensorPlayground::setAcquisition() without a board.
+   See extras/host/README.md
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef SIMULATED_DMA_H
+#define SIMULATED_DMA_H
+
+#include <PulseSensorPlayground.h>
+
+/*
+   Behaves as a PulseSensorDMA: a frame is due every sample interval
+   of the simulated clock from begin(), whether or not the Sketch is
+   looking, and blocks fill in turn and are overwritten if not read.
+   Each frame reads every PulseSensor's pin once with analogRead()
+   (see ArduinoShim::setAnalogSamples()) and stores the reading as an
+   ADC with the given resolution would, the given number of times,
+   so readBlock() has to scale and average them as it would on a board.
+   The conversions are spread evenly over the frame, as on an RP2040,
+   and each pin is read at the middle of its conversions, which matters
+   to a time-based source (see ArduinoShim::setAnalogWaveform()).
+*/
+class SimulatedDMA : public PulseSensorAcquisition {
+  public:
+    /*
+       storage, framesPerBlock = as for PulseSensorAcquisition.
+       conversions = times each reading is stored per frame (1 or more).
+       bits = the simulated ADC's resolution (10 to 15).
+    */
+    SimulatedDMA(int16_t *storage, int framesPerBlock,
+      byte conversions = 1, byte bits = 10);
+
+  protected:
+    bool startScan(PulseSensor *sensors, byte sensorCount, unsigned long intervalMicros);
+    void stopScan();
+    void poll();
+
+  private:
+    byte SimulatedConversions;
+    byte Bits;
+    bool Running;
+    PulseSensor *Sensors;
+    unsigned long IntervalMicros;
+    unsigned long StartMicros;    // micros() at begin().
+    unsigned long FramesWritten;  // since begin().
+    byte Filling;                 // the block being filled,
+    int FrameIndex;               // and the next frame in it.
+};
+
+#endif // SIMULATED_DMA_H
@@ -0,0 +1,237 @@
+/*
+   Synthetic photoplethysmogram (PPG) signals.
+   See synthetic_ppg.h
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include "synthetic_ppg.h"
+
+#include <math.h>
+
+/*
+   Shape of one beat, in fractions of the IBI:
+   where the systolic and diastolic waves peak, and how wide they are.
+*/
+static const double SYSTOLIC_PEAK = 0.18;
+static const double SYSTOLIC_WIDTH = 0.06;
+static const double DIASTOLIC_PEAK = 0.42;
+static const double DIASTOLIC_WIDTH = 0.09;
+
+// The halfway point of the systolic upstroke, before its peak: sqrt(2 ln 2).
+static const double HALF_HEIGHT_WIDTHS = 1.1774;
+
+static const double TWO_PI = 6.283185307179586;
+
+SyntheticPPGConfig::SyntheticPPGConfig() {
+  sampleRate = 500;
+  seconds = 60.0;
+  bpm = 72.0;
+  variability = 0.0;
+  breathsPerMinute = 15.0;
+  baseline = 512;
+  amplitude = 300;
+  wander = 0.0;
+  notch = 0.0;
+  noise = 0.0;
+  hum = 0.0;
+  humHz = 50.0;
+  dropoutsPerMinute = 0.0;
+  dropoutSeconds = 2.0;
+  delayMs = 0.0;
+  seed = 1;
+}
+
+/*
+   xorshift64*, so the signal doesn't depend on the C library's rand().
+*/
+class SynthRandom {
+  public:
+    explicit SynthRandom(unsigned long seed) {
+      State = 0x9E3779B97F4A7C15ULL ^ seed;
+      if (State == 0) {
+        State = 1;
+      }
+      HaveSpare = false;
+    }
+
+    // Uniform in [0, 1).
+    double uniform() {
+      State ^= State >> 12;
+      State ^= State << 25;
+      State ^= State >> 27;
+      return (double) ((State * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+    }
+
+    // Normal, mean 0, standard deviation 1 (Box-Muller).
+    double normal() {
+      if (HaveSpare) {
+        HaveSpare = false;
+        return Spare;
+      }
+      double u = 1.0 - uniform();
+      double v = uniform();
+      double r = sqrt(-2.0 * log(u));
+      Spare = r * sin(TWO_PI * v);
+      HaveSpare = true;
+      return r * cos(TWO_PI * v);
+    }
+
+  private:
+    uint64_t State;
+    bool HaveSpare;
+    double Spare;
+};
+
+static double gaussian(double x, double peak, double width) {
+  double z = (x - peak) / width;
+  return exp(-0.5 * z * z);
+}
+
+// The pulse wave, sinceStartMs into a beat that lasts ibiMs.
+static double beatWave(double sinceStartMs, double ibiMs, double notch) {
+  double phase = sinceStartMs / ibiMs;
+  return gaussian(phase, SYSTOLIC_PEAK, SYSTOLIC_WIDTH)
+    + notch * gaussian(phase, DIASTOLIC_PEAK, DIASTOLIC_WIDTH);
+}
+
+void generateSyntheticPPG(const SyntheticPPGConfig &config, SyntheticPPG &out) {
+  out.samples.clear();
+  out.beats.clear();
+  if (config.sampleRate == 0 || config.bpm <= 0.0 || config.seconds <= 0.0) {
+    return;
+  }
+
+  SynthRandom noise(config.seed);
+  SynthRandom dropouts(config.seed * 2654435761UL + 1);
+
+  double sampleMs = 1000.0 / config.sampleRate;
+  double meanIbiMs = 60000.0 / config.bpm;
+  double breathHz = config.breathsPerMinute / 60.0;
+  unsigned long count = (unsigned long) (config.seconds * config.sampleRate);
+
+  // Beat start times, with the IBI swinging at the breathing rate.
+  std::vector<double> starts;
+  std::vector<double> ibis;
+  double endMs = count * sampleMs;
+  double start = config.delayMs - meanIbiMs * 0.5;
+  while (start < endMs + meanIbiMs) {
+    double ibi = meanIbiMs
+      * (1.0 + config.variability * sin(TWO_PI * breathHz * start / 1000.0));
+    starts.push_back(start);
+    ibis.push_back(ibi);
+    start += ibi;
+  }
+
+  // Dropouts, at random (Poisson) times.
+  std::vector<double> dropStarts;
+  if (config.dropoutsPerMinute > 0.0) {
+    double meanGapMs = 60000.0 / config.dropoutsPerMinute;
+    double t = -log(1.0 - dropouts.uniform()) * meanGapMs;
+    while (t < endMs) {
+      dropStarts.push_back(t);
+      t += config.dropoutSeconds * 1000.0 - log(1.0 - dropouts.uniform()) * meanGapMs;
+    }
+  }
+  double dropMs = config.dropoutSeconds * 1000.0;
+
+  size_t drop = 0;
+  size_t beat = 0;
+  out.samples.resize(count);
+  for (unsigned long i = 0; i < count; ++i) {
+    double t = i * sampleMs;
+    while (beat + 1 < starts.size() && starts[beat + 1] <= t) {
+      ++beat;
+    }
+    while (drop < dropStarts.size() && dropStarts[drop] + dropMs <= t) {
+      ++drop;
+    }
+    bool inDropout = drop < dropStarts.size() && dropStarts[drop] <= t;
+
+    double breath = sin(TWO_PI * breathHz * t / 1000.0);
+    double value = config.baseline + config.wander * breath;
+    if (!inDropout) {
+      double wave = 0.0;
+      if (t >= starts[beat]) {
+        wave += beatWave(t - starts[beat], ibis[beat], config.notch);
+      }
+      if (beat > 0) {
+        wave += beatWave(t - starts[beat - 1], ibis[beat - 1], config.notch);
+      }
+      value += config.amplitude * (wave - 0.5);
+    }
+    value += config.hum * sin(TWO_PI * config.humHz * t / 1000.0);
+    value += config.noise * noise.normal();
+
+    long rounded = lround(value);
+    out.samples[i] = (int16_t) (rounded < 0 ? 0 : (rounded > 1023 ? 1023 : rounded));
+  }
+
+  // The beats, at the halfway point of each systolic upstroke.
+  drop = 0;
+  double previousMs = -1.0;
+  for (size_t b = 0; b < starts.size(); ++b) {
+    double halfMs = starts[b]
+      + ibis[b] * (SYSTOLIC_PEAK - HALF_HEIGHT_WIDTHS * SYSTOLIC_WIDTH);
+    if (halfMs < 0.0) {
+      continue;
+    }
+    if (halfMs >= endMs) {
+      break;
+    }
+    while (drop < dropStarts.size() && dropStarts[drop] + dropMs <= halfMs) {
+      ++drop;
+    }
+    SyntheticBeat found;
+    found.timeMs = halfMs;
+    found.sampleIndex = (unsigned long) ceil(halfMs / sampleMs);
+    found.ibiMs = previousMs < 0.0 ? 0.0 : halfMs - previousMs;
+    found.visible = !(drop < dropStarts.size() && dropStarts[drop] <= halfMs);
+    if (found.sampleIndex < count) {
+      out.beats.push_back(found);
+    }
+    previousMs = halfMs;
+  }
+}
+
+BeatMatches::BeatMatches(const SyntheticPPG &signal)
+  : beats(0), truePositives(0), falsePositives(0), lateSum(0.0),
+    matched(signal.beats.size(), false), nearest(0) {
+  for (size_t b = 0; b < signal.beats.size(); ++b) {
+    if (signal.beats[b].visible) {
+      ++beats;
+    }
+  }
+}
+
+long matchBeats(const SyntheticPPG &signal, double foundMs, BeatMatches &matches) {
+  if (signal.beats.empty()) {
+    ++matches.falsePositives;
+    return -1;
+  }
+  size_t &b = matches.nearest;
+  while (b + 1 < signal.beats.size()
+    && fabs(signal.beats[b + 1].timeMs - foundMs) <= fabs(signal.beats[b].timeMs - foundMs)) {
+    ++b;
+  }
+  const SyntheticBeat &beat = signal.beats[b];
+  if (matches.matched[b] || fabs(beat.timeMs - foundMs) > SYNTHETIC_MATCH_MS) {
+    ++matches.falsePositives;
+    return -1;
+  }
+  matches.matched[b] = true;
+  if (beat.visible) {
+    ++matches.truePositives;
+    matches.lateSum += foundMs - beat.timeMs;
+  }
+  return (long) b;
+}
@@ -0,0 +1,106 @@
+/*
+   Synthetic photoplethysmogram (PPG) signals, for measuring how fast
+   and how well the PulseSensor beat finder works on the host.
+
+   Each beat is a systolic wave and a smaller diastolic wave (two
+   Gaussians), with a dicrotic notch between them when the diastolic
+   wave is large enough. On top of that go baseline wander and
+   heart rate swing at the breathing rate, white noise, and dropouts
+   where the sensor loses contact and the pulse disappears.
+
+   The signal is reproducible: the same configuration and seed
+   give the same samples on every computer.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef SYNTHETIC_PPG_H
+#define SYNTHETIC_PPG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+struct SyntheticPPGConfig {
+  SyntheticPPGConfig();
+
+  unsigned int sampleRate;   // samples per second.
+  double seconds;            // length of the signal.
+  double bpm;                // average heart rate.
+  double variability;        // IBI swing with breathing, as a fraction of the IBI (0.05 = +/-5%).
+  double breathsPerMinute;   // rate of the baseline wander and IBI swing.
+  int baseline;              // middle of the signal (ADC counts, 0..1023).
+  int amplitude;             // trough to systolic peak (ADC counts).
+  double wander;             // baseline wander, either way (ADC counts).
+  double notch;              // diastolic wave height, relative to the systolic wave (0..1).
+  double noise;              // RMS of the white noise (ADC counts).
+  double hum;                // mains hum, either way (ADC counts).
+  double humHz;              // mains frequency.
+  double dropoutsPerMinute;  // average number of dropouts a minute.
+  double dropoutSeconds;     // length of each dropout.
+  double delayMs;            // how much later than usual every beat arrives (for pulse transit time).
+  unsigned long seed;        // seed for the noise and dropouts.
+};
+
+/*
+   A beat in the synthetic signal.
+   sampleIndex is the sample on which the systolic upstroke is
+   halfway up, where a threshold-crossing beat finder should fire.
+   visible is false for beats lost in a dropout.
+*/
+struct SyntheticBeat {
+  unsigned long sampleIndex;
+  double timeMs;            // the exact time of sampleIndex's halfway point (ms).
+  double ibiMs;             // time since the previous beat (ms); 0 for the first.
+  bool visible;
+};
+
+struct SyntheticPPG {
+  std::vector<int16_t> samples;   // 0..1023.
+  std::vector<SyntheticBeat> beats;
+};
+
+// Generate a signal from the given configuration.
+void generateSyntheticPPG(const SyntheticPPGConfig &config, SyntheticPPG &out);
+
+// A found beat is real if it is within this many ms of a beat in the signal.
+static const double SYNTHETIC_MATCH_MS = 150.0;
+
+// The least time (seconds) a benchmark times anything for.
+static const double SYNTHETIC_MIN_SECONDS_TIMED = 0.25;
+
+/*
+   How the beats a beat finder found compare with a signal's beats.
+   Start with one made from the signal, then pass each beat found,
+   oldest first, to matchBeats().
+*/
+struct BeatMatches {
+  explicit BeatMatches(const SyntheticPPG &signal);
+
+  unsigned long beats;          // visible beats in the signal.
+  unsigned long truePositives;  // beats found that matched a visible beat.
+  unsigned long falsePositives; // beats found that matched no beat.
+  double lateSum;               // total time the true positives were found after their beats (ms).
+
+  std::vector<bool> matched;    // (for matchBeats()) the signal's beats matched so far.
+  size_t nearest;               // (for matchBeats()) the signal beat nearest the last beat found.
+};
+
+/*
+   Match a beat found at foundMs against the nearest of signal's beats,
+   if that's within SYNTHETIC_MATCH_MS and not already matched.
+   Returns the index of the signal beat matched, or -1 if none.
+   A beat found at the edge of a dropout matches an invisible beat,
+   and counts as neither a true nor a false positive.
+*/
+long matchBeats(const SyntheticPPG &signal, double foundMs, BeatMatches &matches);
+
+#endif // SYNTHETIC_PPG_H
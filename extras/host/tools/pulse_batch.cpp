@@ -0,0 +1,309 @@
+/*
+   Find the beats in many PulseSensor recordings at once,
+   on every core of a desktop computer.
+
+   Each recording is read by one thread, then each of its PulseSensors
+   (channels) is run through its own PulseSensor beat finder, by
+   whichever thread is free. A recording of one channel keeps one thread
+   busy; many recordings, or a recording of many channels, keep them all
+   busy. The results are the same as from pulse_replay -b, in the same
+   order, however many threads there are.
+
+   Usage:
+     pulse_batch [-j threads] [-t threshold] [-r rate] file...
+
+     -j threads    number of threads (default: one per core).
+     -t threshold  setThreshold() value for every sensor (default 550).
+     -r rate       samples per second the recordings were made at
+                   (default 500).
+     file          the recordings, text or binary, as pulse_replay reads.
+
+   Beats are printed in recording order, then sample order, as:
+     sensor,beat time (ms),BPM,IBI (ms)
+   With more than one recording, each recording's beats start with
+   a line "# file". A throughput summary is printed on standard error.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include "recording.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/*
+   One recording, from when a thread reads it until its beats are printed.
+*/
+struct Recording {
+  const char *name;
+  std::vector<std::vector<int16_t> > channels;
+  std::vector<std::vector<BeatEvent> > beats;   // per channel.
+  int channelsLeft;   // channels whose beats haven't been found yet.
+  bool done;          // ready to print.
+  const char *error;  // why it couldn't be read, or NULL.
+};
+
+struct ChannelTask {
+  size_t recording;
+  int channel;
+};
+
+/*
+   The work shared by the threads, and what they've done.
+   Everything is guarded by Lock.
+*/
+class BatchReplay {
+  public:
+    BatchReplay(std::vector<Recording> &recordings, unsigned int rate,
+      int threshold, size_t maxUnprinted)
+      : Recordings(recordings), Rate(rate), Threshold(threshold),
+        MaxUnprinted(maxUnprinted), NextToRead(0), NextToPrint(0), Reading(0),
+        ReadSeconds(0.0), FindSeconds(0.0), Samples(0), Channels(0) {
+    }
+
+    // A worker thread: read recordings and find beats until there's nothing left.
+    void work() {
+      std::unique_lock<std::mutex> lock(Lock);
+      for (;;) {
+        if (!Tasks.empty()) {
+          ChannelTask task = Tasks.front();
+          Tasks.pop_front();
+          lock.unlock();
+          double seconds = findBeats(task);
+          lock.lock();
+          FindSeconds += seconds;
+          Recording &recording = Recordings[task.recording];
+          if (--recording.channelsLeft == 0) {
+            recording.done = true;
+            Changed.notify_all();
+          }
+        } else if (NextToRead < Recordings.size()
+          && NextToRead - NextToPrint < MaxUnprinted) {
+          size_t r = NextToRead++;
+          ++Reading;
+          lock.unlock();
+          double seconds = read(Recordings[r]);
+          lock.lock();
+          --Reading;
+          ReadSeconds += seconds;
+          Recording &recording = Recordings[r];
+          if (recording.error) {
+            recording.done = true;
+          } else {
+            Samples += (unsigned long) recording.channels.size() * recording.channels[0].size();
+            Channels += recording.channels.size();
+            for (int c = 0; c < recording.channelsLeft; ++c) {
+              ChannelTask task = { r, c };
+              Tasks.push_back(task);
+            }
+          }
+          Changed.notify_all();
+        } else if (NextToRead >= Recordings.size() && Reading == 0) {
+          return; // everything has been read, and every task taken.
+        } else {
+          Changed.wait(lock);
+        }
+      }
+    }
+
+    /*
+       Print each recording's beats once they're all found, in order,
+       and free its memory. Returns false if any recording couldn't be read.
+    */
+    bool print(unsigned long &beats) {
+      bool ok = true;
+      beats = 0;
+      for (size_t r = 0; r < Recordings.size(); ++r) {
+        Recording &recording = Recordings[r];
+        {
+          std::unique_lock<std::mutex> lock(Lock);
+          while (!recording.done) {
+            Changed.wait(lock);
+          }
+        }
+
+        if (recording.error) {
+          fprintf(stderr, "%s: %s\n", recording.name, recording.error);
+          ok = false;
+        } else {
+          beats += printBeats(recording);
+        }
+
+        std::vector<std::vector<int16_t> >().swap(recording.channels);
+        std::vector<std::vector<BeatEvent> >().swap(recording.beats);
+        std::lock_guard<std::mutex> lock(Lock);
+        ++NextToPrint;
+        Changed.notify_all();
+      }
+      return ok;
+    }
+
+    double getReadSeconds() { return ReadSeconds; }
+    double getFindSeconds() { return FindSeconds; }
+    unsigned long getSamples() { return Samples; }
+    unsigned long getChannels() { return Channels; }
+
+  private:
+    // Read a recording. Returns the time it took (seconds).
+    double read(Recording &recording) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      std::vector<std::vector<int> > channels;
+      if (access(recording.name, R_OK) != 0) {
+        recording.error = "can't open";
+      } else if (!loadRecording(recording.name, channels)) {
+        recording.error = "no samples, or lines with differing sensor counts";
+      }
+      if (!recording.error) {
+        recording.channels.resize(channels.size());
+        for (size_t c = 0; c < channels.size(); ++c) {
+          recording.channels[c].assign(channels[c].begin(), channels[c].end());
+        }
+        recording.beats.resize(channels.size());
+        recording.channelsLeft = (int) channels.size();
+      }
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Find the beats in one channel. Returns the time it took (seconds).
+    double findBeats(const ChannelTask &task) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      Recording &recording = Recordings[task.recording];
+      const std::vector<int16_t> &samples = recording.channels[task.channel];
+      std::vector<BeatEvent> &beats = recording.beats[task.channel];
+
+      PulseSensor sensor;
+      unsigned long intervalMicros = 1000000UL / Rate;
+      sensor.setSampleIntervalMicros(intervalMicros);
+      sensor.setThreshold(Threshold);
+      // Beats are more than 250ms apart.
+      beats.resize(samples.size() * (intervalMicros / 1000 + 1) / 250 + 2);
+      size_t found = sensor.processBlock(samples.data(), samples.size(),
+        beats.data(), beats.size());
+      beats.resize(std::min(found, beats.size()));
+      for (size_t b = 0; b < beats.size(); ++b) {
+        beats[b].sensorIndex = task.channel;
+      }
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Print a recording's beats in sample order, then sensor order.
+    unsigned long printBeats(const Recording &recording) {
+      std::vector<BeatEvent> merged;
+      for (size_t c = 0; c < recording.beats.size(); ++c) {
+        merged.insert(merged.end(), recording.beats[c].begin(), recording.beats[c].end());
+      }
+      std::stable_sort(merged.begin(), merged.end(), earlier);
+
+      if (Recordings.size() > 1) {
+        printf("# %s\n", recording.name);
+      }
+      for (size_t b = 0; b < merged.size(); ++b) {
+        printf("%d,%lu,%d,%d\n", merged[b].sensorIndex, merged[b].beatTime,
+          merged[b].beatsPerMinute, merged[b].interBeatIntervalMs);
+      }
+      return merged.size();
+    }
+
+    static bool earlier(const BeatEvent &a, const BeatEvent &b) {
+      return a.sampleIndex < b.sampleIndex;
+    }
+
+    std::vector<Recording> &Recordings;
+    const unsigned int Rate;
+    const int Threshold;
+    const size_t MaxUnprinted;      // recordings read but not printed, at most.
+
+    std::mutex Lock;
+    std::condition_variable Changed;
+    std::deque<ChannelTask> Tasks;  // channels waiting for a thread.
+    size_t NextToRead;
+    size_t NextToPrint;
+    int Reading;                    // threads reading a recording.
+    double ReadSeconds;             // thread time spent reading.
+    double FindSeconds;             // thread time spent finding beats.
+    unsigned long Samples;
+    unsigned long Channels;
+};
+
+int main(int argc, char *argv[]) {
+  int threads = (int) std::thread::hardware_concurrency();
+  int threshold = 550;
+  unsigned int rate = SAMPLE_RATE_500HZ;
+  int opt;
+  while ((opt = getopt(argc, argv, "j:t:r:")) != -1) {
+    switch (opt) {
+      case 'j':
+        threads = atoi(optarg);
+        break;
+      case 't':
+        threshold = atoi(optarg);
+        break;
+      case 'r':
+        rate = (unsigned int) atoi(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-j threads] [-t threshold] [-r rate] file...\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "usage: %s [-j threads] [-t threshold] [-r rate] file...\n", argv[0]);
+    return 2;
+  }
+  if (rate == 0 || rate > 10000) {
+    fprintf(stderr, "%s: unsupported sample rate %u\n", argv[0], rate);
+    return 2;
+  }
+  if (threads < 1) {
+    threads = 1;
+  }
+
+  std::vector<Recording> recordings(argc - optind);
+  for (size_t r = 0; r < recordings.size(); ++r) {
+    recordings[r].name = argv[optind + r];
+    recordings[r].channelsLeft = 0;
+    recordings[r].done = false;
+    recordings[r].error = NULL;
+  }
+
+  // Read ahead no further than the threads can keep busy.
+  BatchReplay batch(recordings, rate, threshold, (size_t) threads * 2);
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; ++t) {
+    workers.push_back(std::thread(&BatchReplay::work, &batch));
+  }
+  unsigned long beats;
+  bool ok = batch.print(beats);
+  for (size_t t = 0; t < workers.size(); ++t) {
+    workers[t].join();
+  }
+  double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  fprintf(stderr, "%zu recording(s), %lu channels, %lu samples, %lu beats, %d thread(s), %.3f s, %.0f samples/s\n",
+    recordings.size(), batch.getChannels(), batch.getSamples(), beats, threads, seconds,
+    seconds > 0 ? batch.getSamples() / seconds : 0.0);
+  fprintf(stderr, "thread time: reading %.3f s, finding beats %.3f s (%.1f ns/sample)\n",
+    batch.getReadSeconds(), batch.getFindSeconds(),
+    batch.getSamples() ? batch.getFindSeconds() * 1e9 / batch.getSamples() : 0.0);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,233 @@
+/*
+   Decode the PulseSensor Playground's BINARY_STREAM or COMPRESSED_STREAM
+   serial output. The frame formats are described in
+   src/utility/PulseSensorSerialOutput.h.
+
+   Usage:
+     pulse_decode [file]
+
+     file  the bytes received from the Arduino; standard input if omitted.
+           For example, a capture of the serial port.
+
+   Each sample period prints as one line of samples, one per PulseSensor,
+   separated by commas; the same as a pulse_replay recording.
+   Each beat prints as a comment line after its frame:
+     # beat sensor,BPM,IBI (ms)
+   Frames lost (by sequence number), bad CRCs and skipped bytes
+   are counted on standard error.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+#include <stdio.h>
+#include <vector>
+
+/*
+   Frame statistics.
+*/
+struct DecodeCounts {
+  unsigned long frames;
+  unsigned long lostFrames;
+  unsigned long badCrcs;
+  unsigned long skippedBytes;
+  unsigned long badPackets;   // COMPRESSED_STREAM packets with a good CRC that didn't decode.
+};
+
+/*
+   Returns the size of the frame at the start of buf, 0 if buf doesn't
+   hold all of it yet, or -1 if buf doesn't start with a valid header.
+*/
+static long frameSize(const uint8_t *buf, size_t len) {
+  if (len < 5) {
+    return 0;
+  }
+  if (buf[0] == BINARY_STREAM_SYNC0 && buf[1] == COMPRESSED_STREAM_SYNC1) {
+    size_t size = 3 + buf[2];
+    if (buf[2] < PULSE_SENSOR_ENCODER_HEADER_BYTES) {
+      return -1;
+    }
+    if (len < size + 1) {
+      return 0;
+    }
+    size += 1 + 3 * __builtin_popcount(buf[size]) + 2;
+    return len < size ? 0 : (long) size;
+  }
+  if (buf[0] != BINARY_STREAM_SYNC0 || buf[1] != BINARY_STREAM_SYNC1) {
+    return -1;
+  }
+  uint8_t flags = buf[3];
+  if (flags & 0x0C) {
+    return -1; // unused flag bits must be 0.
+  }
+  int sampleBits = (flags & BINARY_STREAM_12_BIT) ? 12 : 10;
+  int periods = (flags >> BINARY_STREAM_PERIODS_SHIFT) + 1;
+  int samples = periods * __builtin_popcount(buf[4]);
+  size_t size = 5 + (samples * sampleBits + 7) / 8;
+  if (flags & BINARY_STREAM_BEATS) {
+    if (len < size + 1) {
+      return 0;
+    }
+    size += 1 + 3 * __builtin_popcount(buf[size]);
+  }
+  size += 2;
+  return len < size ? 0 : (long) size;
+}
+
+static bool crcMatches(const uint8_t *frame, size_t size) {
+  word crc = 0xFFFF;
+  for (size_t i = 2; i < size - 2; ++i) {
+    crc = PulseSensorSerialOutput::crc16Update(crc, frame[i]);
+  }
+  return frame[size - 2] == (uint8_t) crc && frame[size - 1] == (uint8_t) (crc >> 8);
+}
+
+// Returns the frame's sequence number.
+static uint8_t sequenceOf(const uint8_t *frame) {
+  return frame[1] == COMPRESSED_STREAM_SYNC1 ? frame[3] : frame[2];
+}
+
+static void printBeats(const uint8_t *beats) {
+  uint8_t beatMap = *beats++;
+  for (int i = 0; i < BINARY_STREAM_MAX_SENSORS; ++i) {
+    if (beatMap & (1 << i)) {
+      printf("# beat %d,%d,%d\n", i, beats[0], beats[1] | (beats[2] << 8));
+      beats += 3;
+    }
+  }
+}
+
+// Print a COMPRESSED_STREAM frame. Returns false if its packet is damaged.
+static bool printCompressedFrame(const uint8_t *frame) {
+  uint8_t length = frame[2];
+  const uint8_t *packet = frame + 3;
+  int16_t samples[255 * BINARY_STREAM_MAX_SENSORS];
+  int frames = PulseSensorSampleEncoder::decodePacket(packet, length, samples,
+    sizeof(samples) / sizeof(samples[0]));
+  if (frames < 0) {
+    return false;
+  }
+  int sensorCount = packet[1];
+  for (int f = 0; f < frames; ++f) {
+    for (int i = 0; i < sensorCount; ++i) {
+      printf(i ? ",%d" : "%d", samples[f * sensorCount + i]);
+    }
+    printf("\n");
+  }
+  printBeats(packet + length);
+  return true;
+}
+
+static void printFrame(const uint8_t *frame) {
+  uint8_t flags = frame[3];
+  uint8_t sensorMap = frame[4];
+  int sampleBits = (flags & BINARY_STREAM_12_BIT) ? 12 : 10;
+  int periods = (flags >> BINARY_STREAM_PERIODS_SHIFT) + 1;
+  size_t n = 5;
+
+  unsigned long bits = 0;
+  int bitCount = 0;
+  for (int p = 0; p < periods; ++p) {
+    bool first = true;
+    for (int i = 0; i < BINARY_STREAM_MAX_SENSORS; ++i) {
+      if (!(sensorMap & (1 << i))) {
+        continue;
+      }
+      while (bitCount < sampleBits) {
+        bits |= (unsigned long) frame[n++] << bitCount;
+        bitCount += 8;
+      }
+      printf(first ? "%lu" : ",%lu", bits & ((1UL << sampleBits) - 1));
+      bits >>= sampleBits;
+      bitCount -= sampleBits;
+      first = false;
+    }
+    printf("\n");
+  }
+
+  if (flags & BINARY_STREAM_BEATS) {
+    printBeats(frame + n);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  FILE *in = stdin;
+  if (argc > 1) {
+    in = fopen(argv[1], "rb");
+    if (!in) {
+      perror(argv[1]);
+      return 1;
+    }
+  }
+
+  DecodeCounts counts = {0, 0, 0, 0, 0};
+  std::vector<uint8_t> buf;
+  size_t start = 0;
+  bool haveSequence = false;
+  uint8_t nextSequence = 0;
+  uint8_t chunk[4096];
+  size_t got;
+  bool atEnd = false;
+
+  while (!atEnd) {
+    got = fread(chunk, 1, sizeof(chunk), in);
+    if (got == 0) {
+      atEnd = true;
+    }
+    buf.erase(buf.begin(), buf.begin() + start);
+    buf.insert(buf.end(), chunk, chunk + got);
+    start = 0;
+
+    for (;;) {
+      long size = frameSize(buf.data() + start, buf.size() - start);
+      if (size == 0) {
+        break; // wait for the rest of the frame.
+      }
+      if (size < 0 || !crcMatches(buf.data() + start, size)) {
+        if (size > 0) {
+          ++counts.badCrcs;
+        }
+        // Look for the next sync word.
+        ++start;
+        ++counts.skippedBytes;
+        continue;
+      }
+
+      const uint8_t *frame = buf.data() + start;
+      if (frame[1] == COMPRESSED_STREAM_SYNC1 && !printCompressedFrame(frame)) {
+        ++counts.badPackets;
+        start += size;
+        continue;
+      }
+      if (frame[1] == BINARY_STREAM_SYNC1) {
+        printFrame(frame);
+      }
+      if (haveSequence) {
+        counts.lostFrames += (uint8_t) (sequenceOf(frame) - nextSequence);
+      }
+      haveSequence = true;
+      nextSequence = sequenceOf(frame) + 1;
+      ++counts.frames;
+      start += size;
+    }
+  }
+  counts.skippedBytes += buf.size() - start;
+
+  fprintf(stderr, "%lu frames, %lu lost, %lu bad CRCs, %lu bytes skipped",
+    counts.frames, counts.lostFrames, counts.badCrcs, counts.skippedBytes);
+  if (counts.badPackets) {
+    fprintf(stderr, ", %lu bad packets", counts.badPackets);
+  }
+  fprintf(stderr, "\n");
+  return 0;
+}
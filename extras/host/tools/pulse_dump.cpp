@@ -0,0 +1,116 @@
+/*
+   Print a binary PulseSensor recording (see src/utility/PulseSensorRecorder.h)
+   as text, from any point in it.
+
+   Usage:
+     pulse_dump [-s seconds] [-n frames] file
+
+     -s seconds  start this far into the recording (default: the start).
+                 Fractions of a second are fine.
+     -n frames   print no more than this many frames.
+     file        the binary recording, made by PulseSensorRecorder
+                 or pulse_pack.
+
+   Each frame prints as one line of samples, one per PulseSensor,
+   separated by commas; the same as a pulse_replay recording.
+   Each beat prints as a comment line after its frame:
+     # beat sensor,BPM,IBI (ms)
+   The recording's settings print as comment lines first. How long it
+   took to open the recording, find the start and decode the frames
+   is printed on standard error.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include "recording.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+static double microsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(
+    std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+  double startSeconds = 0.0;
+  unsigned long maxFrames = (unsigned long) -1;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:n:")) != -1) {
+    switch (opt) {
+      case 's':
+        startSeconds = atof(optarg);
+        break;
+      case 'n':
+        maxFrames = strtoul(optarg, NULL, 10);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-s seconds] [-n frames] file\n", argv[0]);
+        return 2;
+    }
+  }
+  if (argc - optind != 1 || startSeconds < 0) {
+    fprintf(stderr, "usage: %s [-s seconds] [-n frames] file\n", argv[0]);
+    return 2;
+  }
+  const char *path = argv[optind];
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  MappedRecording recording;
+  if (!recording.open(path)) {
+    fprintf(stderr, "%s: %s\n", path, recording.getError());
+    return 1;
+  }
+  double openMicros = microsSince(start);
+
+  const int sensorCount = recording.getSensorCount();
+  printf("# %d sensor(s), %lu us per sample, %lu frames\n# thresholds",
+    sensorCount, recording.getSampleIntervalMicros(), recording.getFrameCount());
+  for (int i = 0; i < sensorCount; ++i) {
+    printf(" %d", recording.getThreshold(i));
+  }
+  printf("\n");
+
+  start = std::chrono::steady_clock::now();
+  RecordingCursor cursor(recording);
+  if (!cursor.seekMicros((uint64_t) (startSeconds * 1e6 + 0.5))) {
+    fprintf(stderr, "%s: no frame %.3f s in\n", path, startSeconds);
+    return 1;
+  }
+  double seekMicros = microsSince(start);
+
+  start = std::chrono::steady_clock::now();
+  std::vector<int16_t> frame(sensorCount);
+  unsigned long frames = 0;
+  while (frames < maxFrames && cursor.next(frame.data())) {
+    for (int i = 0; i < sensorCount; ++i) {
+      printf(i ? ",%d" : "%d", frame[i]);
+    }
+    printf("\n");
+    RecordedBeat beat;
+    while (cursor.nextBeat(beat)) {
+      printf("# beat %d,%d,%d\n", beat.sensorIndex, beat.beatsPerMinute,
+        beat.interBeatIntervalMs);
+    }
+    ++frames;
+  }
+  double decodeMicros = microsSince(start);
+
+  fprintf(stderr, "%zu chunks%s%s; open %.0f us, seek %.0f us, %lu frames in %.0f us\n",
+    recording.getChunkCount(), recording.hasIndex() ? " (indexed)" : "",
+    recording.isCutShort() ? " (cut short)" : "",
+    openMicros, seekMicros, frames, decodeMicros);
+  return 0;
+}
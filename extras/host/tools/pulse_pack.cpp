@@ -0,0 +1,156 @@
+/*
+   Convert a PulseSensor recording to the binary recording format
+   of PulseSensorRecorder (see src/utility/PulseSensorRecorder.h),
+   with the beats PulseSensorChannels finds in it, and an index
+   so pulse_dump and other readers can seek straight to any time.
+
+   Usage:
+     pulse_pack [-t threshold] [-r rate] [-k bytes] in out
+
+     -t threshold  setThreshold() value for every sensor (default 550).
+     -r rate       samples per second the recording was made at
+                   (default 500).
+     -k bytes      storage for each chunk, as given to
+                   PulseSensorRecorder::begin() (default 4096).
+     in            the recording, in the format pulse_replay reads.
+     out           the binary recording to write.
+
+   The sizes before and after are printed on standard error.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include "recording.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// A Print that writes to a file, as an SD card File would.
+class FilePrint : public Print {
+  public:
+    FilePrint(FILE *file) : File(file) {}
+    size_t write(uint8_t c) {
+      return fputc(c, File) == EOF ? 0 : 1;
+    }
+    size_t write(const uint8_t *buffer, size_t size) {
+      return fwrite(buffer, 1, size, File);
+    }
+  private:
+    FILE *File;
+};
+
+static long fileSize(const char *path) {
+  struct stat status;
+  return stat(path, &status) == 0 ? (long) status.st_size : -1;
+}
+
+int main(int argc, char *argv[]) {
+  int threshold = 550;
+  unsigned int rate = SAMPLE_RATE_500HZ;
+  long storageSize = 4096;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:r:k:")) != -1) {
+    switch (opt) {
+      case 't':
+        threshold = atoi(optarg);
+        break;
+      case 'r':
+        rate = (unsigned int) atoi(optarg);
+        break;
+      case 'k':
+        storageSize = atol(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-t threshold] [-r rate] [-k bytes] in out\n", argv[0]);
+        return 2;
+    }
+  }
+  if (argc - optind != 2) {
+    fprintf(stderr, "usage: %s [-t threshold] [-r rate] [-k bytes] in out\n", argv[0]);
+    return 2;
+  }
+  const char *inPath = argv[optind];
+  const char *outPath = argv[optind + 1];
+  if (rate == 0 || rate > 10000) {
+    fprintf(stderr, "%s: unsupported sample rate %u\n", argv[0], rate);
+    return 2;
+  }
+
+  std::vector<std::vector<int> > channels;
+  if (!loadRecording(inPath, channels)) {
+    fprintf(stderr, "%s: no samples, or lines with differing sensor counts\n", inPath);
+    return 1;
+  }
+  const int sensorCount = (int) channels.size();
+  const size_t frames = channels[0].size();
+  if (sensorCount > 255) {
+    fprintf(stderr, "%s: %d sensors; the binary format holds up to 255\n", inPath, sensorCount);
+    return 1;
+  }
+  if (storageSize < 16 * sensorCount || storageSize > 65535) {
+    fprintf(stderr, "%s: -k must be from %d to 65535\n", argv[0], 16 * sensorCount);
+    return 2;
+  }
+
+  FILE *out = fopen(outPath, "wb");
+  if (!out) {
+    perror(outPath);
+    return 1;
+  }
+  FilePrint file(out);
+  std::vector<byte> storage(storageSize);
+  std::vector<int> thresholds(sensorCount, threshold);
+  PulseSensorRecorder recorder;
+  PulseSensorChannels detector(sensorCount);
+  detector.setSampleIntervalMicros(1000000UL / rate);
+  for (int i = 0; i < sensorCount; ++i) {
+    detector.setThreshold(i, threshold);
+  }
+
+  bool ok = recorder.begin(file, storage.data(), (word) storageSize, (byte) sensorCount,
+    1000000UL / rate, thresholds.data());
+  unsigned long beats = 0;
+  std::vector<int16_t> frame(sensorCount);
+  for (size_t f = 0; ok && f < frames; ++f) {
+    for (int i = 0; i < sensorCount; ++i) {
+      frame[i] = (int16_t) channels[i][f];
+    }
+    ok = recorder.addFrame(frame.data());
+    if (!detector.processFrame(frame.data())) {
+      continue;
+    }
+    for (int i = 0; ok && i < sensorCount; ++i) {
+      if (detector.getFound(i) & PulseSensor::FOUND_BEAT_START) {
+        ok = recorder.addBeat(i, detector.getBeatsPerMinute(i),
+          detector.getInterBeatIntervalMs(i));
+        ++beats;
+      }
+    }
+  }
+  ok = ok && recorder.flush();
+  if (fclose(out) != 0 || !ok || !appendRecordingIndex(outPath)) {
+    fprintf(stderr, "%s: write failed\n", outPath);
+    return 1;
+  }
+
+  long before = fileSize(inPath);
+  long after = fileSize(outPath);
+  double samples = (double) frames * sensorCount;
+  fprintf(stderr, "%d sensor(s), %zu frames, %lu beats; %ld bytes -> %ld bytes (%.1f:1, %.2f bits/sample)\n",
+    sensorCount, frames, beats, before, after,
+    after > 0 ? (double) before / after : 0.0, samples > 0 ? after * 8.0 / samples : 0.0);
+  return 0;
+}
@@ -0,0 +1,357 @@
+/*
+   Replay a recorded PulseSensor signal through the PulseSensor Playground
+   on a desktop computer, as fast as the CPU allows.
+
+   Input is text, one sample period per line. A line holds one value
+   per PulseSensor (0..1023), separated by commas, tabs or spaces.
+   Lines starting with '#' are ignored. A file may also be a binary
+   recording (see pulse_pack).
+
+   Usage:
+     pulse_replay [-t threshold] [-r rate] [-p | -o format | -b | -m | -c when]
+       [-f] [-d frames] [-u baud] [-q bytes] [-H] [file]
+
+     -t threshold  setThreshold() value for every sensor (default 550).
+     -r rate       samples per second the recording was made at
+                   (default 500). See setSampleRate().
+     -p            print the library's SERIAL_PLOTTER output for every
+                   sample, instead of one line per detected beat.
+     -o format     the same, in the given output format: plotter,
+                   visualizer, binary (BINARY_STREAM) or compressed
+                   (COMPRESSED_STREAM); see pulse_decode for the last two.
+     -b            find beats with processBlock() instead of sampling
+                   through sawNewSample().
+     -m            find beats with PulseSensorChannels::processBlock(),
+                   all sensors at once. Any number of sensors.
+     -c when       print beats from an onBeatStart() callback instead of
+                   polling sawStartOfBeat(): when is isr (called as the
+                   sample is processed) or deferred (by sawNewSample()).
+     -f            band-pass filter each sensor's samples with a
+                   PulseSensorFilter before finding beats. Not with -m.
+     -d frames     read the sensors through a simulated DMA acquisition
+                   (see setAcquisition()) in blocks of the given number
+                   of frames, stored as 12-bit conversions, two a sample,
+                   as an RP2040 does at low sample rates. Use with -c:
+                   sawStartOfBeat() sees only the last beat of a block.
+                   The frames of a last, partly filled block are not read.
+     -u baud       with -p or -o, send output through a simulated UART
+                   of the given baud rate that waits when its transmit
+                   buffer is full, delaying sampling.
+     -q bytes      with -p or -o, queue output with setOutputQueue()
+                   instead of waiting for the UART.
+     -H            print the sample timing histograms at the end,
+                   on standard error. See getTimingHistogram().
+     file          the recording to read; standard input if omitted.
+
+   Beats are printed as: sensor,beat time (ms),BPM,IBI (ms)
+   A throughput summary is printed on standard error, and with -u,
+   how late sampling was and how much output was dropped.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+#include <SimulatedDMA.h>
+#include "recording.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+// The onBeatStart() callback for -c. context is the beat count.
+static void printBeat(const BeatEvent &beat, void *context) {
+  ++*(unsigned long *) context;
+  printf("%d,%lu,%d,%d\n", beat.sensorIndex, beat.beatTime,
+    beat.beatsPerMinute, beat.interBeatIntervalMs);
+}
+
+static void printSummary(int sensorCount, size_t frames, unsigned long beats,
+  double seconds) {
+  double samples = (double) frames * sensorCount;
+  fprintf(stderr, "%d sensor(s), %zu frames, %lu beats, %.3f s, %.0f samples/s, %.1f ns/sample\n",
+    sensorCount, frames, beats, seconds,
+    seconds > 0 ? samples / seconds : 0.0,
+    samples > 0 ? seconds * 1e9 / samples : 0.0);
+}
+
+int main(int argc, char *argv[]) {
+  int threshold = 550;
+  unsigned int rate = SAMPLE_RATE_500HZ;
+  bool plot = false;
+  byte outputType = SERIAL_PLOTTER;
+  bool block = false;
+  bool multi = false;
+  unsigned long baud = 0;
+  int queueSize = 0;
+  bool histogram = false;
+  int callbacks = 0; // 1 from the ISR, 2 deferred.
+  bool filter = false;
+  int dmaFrames = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:r:po:bmc:fd:u:q:H")) != -1) {
+    switch (opt) {
+      case 't':
+        threshold = atoi(optarg);
+        break;
+      case 'r':
+        rate = (unsigned int) atoi(optarg);
+        break;
+      case 'p':
+        plot = true;
+        break;
+      case 'o':
+        plot = true;
+        if (strcmp(optarg, "plotter") == 0) {
+          outputType = SERIAL_PLOTTER;
+        } else if (strcmp(optarg, "visualizer") == 0) {
+          outputType = PROCESSING_VISUALIZER;
+        } else if (strcmp(optarg, "binary") == 0) {
+          outputType = BINARY_STREAM;
+        } else if (strcmp(optarg, "compressed") == 0) {
+          outputType = COMPRESSED_STREAM;
+        } else {
+          fprintf(stderr, "%s: unknown output format %s\n", argv[0], optarg);
+          return 2;
+        }
+        break;
+      case 'b':
+        block = true;
+        break;
+      case 'm':
+        multi = true;
+        break;
+      case 'c':
+        if (strcmp(optarg, "isr") == 0) {
+          callbacks = 1;
+        } else if (strcmp(optarg, "deferred") == 0) {
+          callbacks = 2;
+        } else {
+          fprintf(stderr, "%s: -c takes isr or deferred, not %s\n", argv[0], optarg);
+          return 2;
+        }
+        break;
+      case 'f':
+        filter = true;
+        break;
+      case 'd':
+        dmaFrames = atoi(optarg);
+        if (dmaFrames <= 0) {
+          fprintf(stderr, "%s: -d takes a number of frames, not %s\n", argv[0], optarg);
+          return 2;
+        }
+        break;
+      case 'u':
+        baud = strtoul(optarg, NULL, 10);
+        break;
+      case 'q':
+        queueSize = atoi(optarg);
+        break;
+      case 'H':
+        histogram = true;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-t threshold] [-r rate] [-p | -o format | -b | -m | -c when] [-f] [-d frames] [-u baud] [-q bytes] [-H] [file]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  std::vector<std::vector<int> > channels;
+  bool loaded;
+  if (optind < argc) {
+    if (access(argv[optind], R_OK) != 0) {
+      perror(argv[optind]);
+      return 1;
+    }
+    loaded = loadRecording(argv[optind], channels);
+  } else {
+    loaded = readRecording(stdin, channels);
+  }
+  if (!loaded) {
+    fprintf(stderr, "%s: no samples, or lines with differing sensor counts\n", argv[0]);
+    return 1;
+  }
+  const int sensorCount = (int) channels.size();
+  const size_t frames = channels[0].size();
+
+  unsigned long beats = 0;
+  std::chrono::steady_clock::time_point start;
+  std::vector<int16_t> interleaved;
+  std::vector<BeatEvent> events;
+  if (block || multi) {
+    interleaved.resize(frames * sensorCount);
+    for (size_t f = 0; f < frames; ++f) {
+      for (int i = 0; i < sensorCount; ++i) {
+        interleaved[f * sensorCount + i] = (int16_t) channels[i][f];
+      }
+    }
+    events.resize(frames * sensorCount / 100 + 16);
+  }
+
+  if (multi) {
+    if (rate == 0 || rate > 10000) {
+      fprintf(stderr, "%s: unsupported sample rate %u\n", argv[0], rate);
+      return 2;
+    }
+    PulseSensorChannels detector(sensorCount);
+    detector.setSampleIntervalMicros(1000000UL / rate);
+    for (int i = 0; i < sensorCount; ++i) {
+      detector.setThreshold(i, threshold);
+    }
+
+    start = std::chrono::steady_clock::now();
+    beats = detector.processBlock(interleaved.data(), frames, events.data(), events.size());
+    double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+    for (size_t b = 0; b < beats && b < events.size(); ++b) {
+      printf("%d,%lu,%d,%d\n", events[b].sensorIndex, events[b].beatTime,
+        events[b].beatsPerMinute, events[b].interBeatIntervalMs);
+    }
+    printSummary(sensorCount, frames, beats, seconds);
+    return 0;
+  }
+
+  ArduinoShim::reset();
+  ArduinoShim::CaptureStream serial;
+  PulseSensorPlayground pulse(sensorCount);
+  if (!pulse.setSampleRate(rate)) {
+    fprintf(stderr, "%s: unsupported sample rate %u\n", argv[0], rate);
+    return 2;
+  }
+  std::vector<PulseSensorFilter> filters(filter ? sensorCount : 0);
+  for (int i = 0; i < sensorCount; ++i) {
+    pulse.analogInput(A0 + i, i);
+    pulse.setThreshold(threshold, i);
+    if (filter && !pulse.setFilter(filters[i], i)) {
+      fprintf(stderr, "%s: the filter can't run at %u samples per second\n", argv[0], rate);
+      return 2;
+    }
+    ArduinoShim::setAnalogSamples(A0 + i, channels[i].data(), frames);
+  }
+  pulse.setSerial(serial);
+  pulse.setOutputType(outputType);
+  std::vector<int16_t> dmaStorage(2 * dmaFrames * sensorCount);
+  SimulatedDMA dma(dmaStorage.data(), dmaFrames, 2, 12);
+  if (dmaFrames) {
+    pulse.setAcquisition(dma);
+  }
+
+  if (block) {
+    start = std::chrono::steady_clock::now();
+    beats = pulse.processBlock(interleaved.data(), frames, events.data(), events.size());
+    double seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+    for (size_t b = 0; b < beats && b < events.size(); ++b) {
+      printf("%d,%lu,%d,%d\n", events[b].sensorIndex, events[b].beatTime,
+        events[b].beatsPerMinute, events[b].interBeatIntervalMs);
+    }
+    printSummary(sensorCount, frames, beats, seconds);
+    return 0;
+  }
+
+  std::vector<byte> queue(queueSize);
+  if (queueSize > 0) {
+    pulse.setOutputQueue(queue.data(), queueSize);
+  }
+  if (baud) {
+    serial.setBaudRate(baud);
+  }
+
+  // How late samples were taken, when output waits for the UART.
+  unsigned long lateSamples = 0;
+  unsigned long maxGapMicros = 0;
+  unsigned long lastSampleMicros = 0;
+  unsigned long skippedFrames = 0;
+  const unsigned long interval = pulse.getSampleIntervalMicros();
+
+  PendingBeatEvent beatEvents[4];
+  if (callbacks) {
+    pulse.onBeatStart(printBeat, &beats, callbacks == 1);
+    pulse.setEventQueue(beatEvents, 4);
+  }
+  if (!pulse.begin()) {
+    fprintf(stderr, "%s: the Playground couldn't start%s\n", argv[0],
+      dmaFrames ? "; try more DMA frames" : "");
+    return 1;
+  }
+  start = std::chrono::steady_clock::now();
+  for (size_t f = 0; f < frames; ++f) {
+    // Move the clock to when the sample is due, unless output has already passed it.
+    unsigned long due = (f + 1) * interval;
+    if ((long) (due - micros()) > 0) {
+      ArduinoShim::setMicros(due);
+    }
+    if (!pulse.sawNewSample()) {
+      ++skippedFrames;
+      continue;
+    }
+    if (micros() != due) {
+      ++lateSamples;
+    }
+    if (micros() - lastSampleMicros > maxGapMicros) {
+      maxGapMicros = micros() - lastSampleMicros;
+    }
+    lastSampleMicros = micros();
+    if (plot) {
+      pulse.outputSample();
+    }
+    for (int i = 0; i < sensorCount && !callbacks; ++i) {
+      if (pulse.sawStartOfBeat(i)) {
+        ++beats;
+        if (plot) {
+          pulse.outputBeat(i);
+        } else {
+          printf("%d,%lu,%d,%d\n", i, pulse.getLastBeatTime(i),
+            pulse.getBeatsPerMinute(i), pulse.getInterBeatIntervalMs(i));
+        }
+      }
+    }
+    if (plot && serial.captured().size() > 4096) {
+      fwrite(serial.captured().data(), 1, serial.captured().size(), stdout);
+      serial.clear();
+    }
+  }
+  double seconds = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  // Send whatever is still queued.
+  serial.setBaudRate(0);
+  pulse.drainOutputQueue();
+  fwrite(serial.captured().data(), 1, serial.captured().size(), stdout);
+
+  printSummary(sensorCount, frames, beats, seconds);
+  if (baud) {
+    fprintf(stderr, "output waited %lu us; %lu samples late; longest time between samples %lu us; %lu frames skipped; %lu outputs dropped\n",
+      serial.stalledMicros(), lateSamples, maxGapMicros, skippedFrames,
+      pulse.getOutputDrops());
+  }
+  if (dma.getOverruns()) {
+    fprintf(stderr, "%lu DMA blocks overwritten before they were read\n", dma.getOverruns());
+  }
+  if (callbacks == 2 && pulse.getEventOverruns()) {
+    fprintf(stderr, "%lu beat events dropped\n", pulse.getEventOverruns());
+  }
+  if (histogram) {
+    PulseSensorTimingHistogram timing;
+    pulse.getTimingHistogram(timing);
+    ArduinoShim::CaptureStream report;
+    timing.outputHistogram(&report);
+    fprintf(stderr, "timing (us): bucket jitter execution acquisition;"
+      " max jitter %lu, max execution %lu, max acquisition %lu\n%s",
+      timing.getMaxJitterMicros(), timing.getMaxExecutionMicros(),
+      timing.getMaxAcquisitionMicros(), report.captured().c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,126 @@
+/*
+   Write a synthetic PPG recording (see synth/synthetic_ppg.h)
+   in the text format pulse_replay reads.
+
+   Usage:
+     pulse_synth [-r rate] [-s seconds] [-b bpm] [-v variability]
+       [-a amplitude] [-w wander] [-n notch] [-N noise] [-m hum]
+       [-d dropouts] [-D dropout seconds] [-c sensors] [-l lag] [-S seed]
+
+     -r rate         samples per second (default 500).
+     -s seconds      length of the recording (default 60).
+     -b bpm          average heart rate (default 72).
+     -v variability  IBI swing with breathing, as a fraction (default 0).
+     -a amplitude    trough to systolic peak, ADC counts (default 300).
+     -w wander       baseline wander either way, ADC counts (default 0).
+     -n notch        diastolic wave height relative to systolic, 0..1 (default 0).
+     -N noise        RMS white noise, ADC counts (default 0).
+     -m hum          50 Hz mains hum either way, ADC counts (default 0).
+     -d dropouts     dropouts per minute (default 0).
+     -D seconds      length of each dropout (default 2).
+     -c sensors      number of PulseSensors (columns) (default 1).
+     -l lag          how much later each PulseSensor sees the pulse
+                     than the one before, in ms (default 0).
+     -S seed         seed for the noise and dropouts (default 1).
+
+   The number of beats is printed on standard error.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <synthetic_ppg.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <vector>
+
+int main(int argc, char *argv[]) {
+  SyntheticPPGConfig config;
+  int sensors = 1;
+  double lagMs = 0.0;
+  int opt;
+  while ((opt = getopt(argc, argv, "r:s:b:v:a:w:n:N:m:d:D:c:l:S:")) != -1) {
+    switch (opt) {
+      case 'r':
+        config.sampleRate = (unsigned int) atoi(optarg);
+        break;
+      case 's':
+        config.seconds = atof(optarg);
+        break;
+      case 'b':
+        config.bpm = atof(optarg);
+        break;
+      case 'v':
+        config.variability = atof(optarg);
+        break;
+      case 'a':
+        config.amplitude = atoi(optarg);
+        break;
+      case 'w':
+        config.wander = atof(optarg);
+        break;
+      case 'n':
+        config.notch = atof(optarg);
+        break;
+      case 'N':
+        config.noise = atof(optarg);
+        break;
+      case 'm':
+        config.hum = atof(optarg);
+        break;
+      case 'd':
+        config.dropoutsPerMinute = atof(optarg);
+        break;
+      case 'D':
+        config.dropoutSeconds = atof(optarg);
+        break;
+      case 'c':
+        sensors = atoi(optarg);
+        break;
+      case 'l':
+        lagMs = atof(optarg);
+        break;
+      case 'S':
+        config.seed = strtoul(optarg, NULL, 10);
+        break;
+      default:
+        fprintf(stderr, "usage: pulse_synth [-r rate] [-s seconds] [-b bpm] [-v variability]"
+          " [-a amplitude] [-w wander] [-n notch] [-N noise] [-m hum] [-d dropouts]"
+          " [-D dropout seconds] [-c sensors] [-l lag] [-S seed]\n");
+        return 2;
+    }
+  }
+  if (sensors < 1 || config.sampleRate == 0 || config.bpm <= 0.0) {
+    fprintf(stderr, "pulse_synth: bad -c, -r or -b\n");
+    return 2;
+  }
+
+  std::vector<SyntheticPPG> signals(sensors);
+  unsigned long seed = config.seed;
+  for (int i = 0; i < sensors; ++i) {
+    config.delayMs = i * lagMs;
+    config.seed = seed + i;
+    generateSyntheticPPG(config, signals[i]);
+  }
+
+  size_t count = signals[0].samples.size();
+  for (size_t n = 0; n < count; ++n) {
+    for (int i = 0; i < sensors; ++i) {
+      printf(i ? ",%d" : "%d", signals[i].samples[n]);
+    }
+    printf("\n");
+  }
+
+  fprintf(stderr, "%zu samples, %zu beats\n", count, signals[0].beats.size());
+  return 0;
+}
@@ -0,0 +1,454 @@
+/*
+   Reading PulseSensor recordings, for the host tools.
+   See recording.h
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include "recording.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool readRecording(FILE *in, std::vector<std::vector<int> > &channels) {
+  char *line = NULL;
+  size_t lineSize = 0;
+  while (getline(&line, &lineSize, in) != -1) {
+    if (line[0] == '#') {
+      continue;
+    }
+    size_t column = 0;
+    char *next = line;
+    for (;;) {
+      char *end;
+      long value = strtol(next, &end, 10);
+      if (end == next) {
+        break;
+      }
+      if (channels.size() <= column) {
+        channels.resize(column + 1);
+      }
+      channels[column++].push_back((int) value);
+      next = end + strspn(end, ", \t\r\n");
+    }
+  }
+  free(line);
+  for (size_t i = 1; i < channels.size(); ++i) {
+    if (channels[i].size() != channels[0].size()) {
+      return false; // ragged input
+    }
+  }
+  return !channels.empty() && !channels[0].empty();
+}
+
+bool loadRecording(const char *path, std::vector<std::vector<int> > &channels) {
+  FILE *in = fopen(path, "rb");
+  if (!in) {
+    return false;
+  }
+  char magic[4];
+  bool binary = fread(magic, 1, 4, in) == 4 && memcmp(magic, "PSR1", 4) == 0;
+  if (!binary) {
+    rewind(in);
+    bool ok = readRecording(in, channels);
+    fclose(in);
+    return ok;
+  }
+  fclose(in);
+
+  MappedRecording recording;
+  if (!recording.open(path)) {
+    return false;
+  }
+  int sensorCount = recording.getSensorCount();
+  channels.assign(sensorCount, std::vector<int>());
+  for (int i = 0; i < sensorCount; ++i) {
+    channels[i].reserve(recording.getFrameCount());
+  }
+  RecordingCursor cursor(recording);
+  std::vector<int16_t> frame(sensorCount);
+  while (cursor.next(frame.data())) {
+    for (int i = 0; i < sensorCount; ++i) {
+      channels[i].push_back(frame[i]);
+    }
+  }
+  return channels[0].size() == recording.getFrameCount() && !channels[0].empty();
+}
+
+static unsigned int readWord(const uint8_t *p) {
+  return p[0] | (p[1] << 8);
+}
+
+static unsigned long readLong(const uint8_t *p) {
+  return (unsigned long) readWord(p) | ((unsigned long) readWord(p + 2) << 16);
+}
+
+static uint64_t readLongLong(const uint8_t *p) {
+  return (uint64_t) readLong(p) | ((uint64_t) readLong(p + 4) << 32);
+}
+
+static void writeLittleEndian(uint8_t *p, uint64_t value, int bytes) {
+  for (int i = 0; i < bytes; ++i) {
+    p[i] = (uint8_t) (value >> (8 * i));
+  }
+}
+
+bool appendRecordingIndex(const char *path) {
+  std::vector<uint8_t> index;
+  {
+    MappedRecording recording;
+    if (!recording.open(path)) {
+      return false;
+    }
+    if (recording.hasIndex()) {
+      return true;
+    }
+    if (recording.isCutShort()) {
+      return false; // the index would follow the partial chunk.
+    }
+    size_t count = recording.getChunkCount();
+    index.resize(count * PULSE_SENSOR_RECORDING_INDEX_ENTRY_BYTES
+      + PULSE_SENSOR_RECORDING_FOOTER_BYTES);
+    uint64_t indexOffset = 0;
+    for (size_t c = 0; c < count; ++c) {
+      RecordingChunk chunk;
+      uint64_t offset;
+      recording.getChunk(c, chunk, &offset);
+      uint8_t *entry = &index[c * PULSE_SENSOR_RECORDING_INDEX_ENTRY_BYTES];
+      writeLittleEndian(entry, chunk.firstFrame, 4);
+      writeLittleEndian(entry + 4, offset, 8);
+      indexOffset = offset + PULSE_SENSOR_RECORDING_CHUNK_HEADER_BYTES
+        + (chunk.beats - chunk.samples) + chunk.beatCount * PULSE_SENSOR_RECORDING_BEAT_BYTES;
+    }
+    if (count == 0) {
+      return true; // nothing to index.
+    }
+    uint8_t *footer = &index[count * PULSE_SENSOR_RECORDING_INDEX_ENTRY_BYTES];
+    memcpy(footer, "PSRX", 4);
+    writeLittleEndian(footer + 4, count, 4);
+    writeLittleEndian(footer + 8, indexOffset, 8);
+  }
+
+  FILE *out = fopen(path, "ab");
+  if (!out) {
+    return false;
+  }
+  bool ok = fwrite(index.data(), 1, index.size(), out) == index.size();
+  return fclose(out) == 0 && ok;
+}
+
+MappedRecording::MappedRecording()
+  : Data(NULL), Size(0), Error(NULL), SensorCount(0), SampleIntervalMicros(0),
+    Thresholds(NULL), ChunksEnd(0), FrameCount(0), Indexed(false), CutShort(false) {
+}
+
+MappedRecording::~MappedRecording() {
+  close();
+}
+
+bool MappedRecording::open(const char *path) {
+  close();
+  int fd = ::open(path, O_RDONLY);
+  if (fd < 0) {
+    return fail("can't open");
+  }
+  struct stat status;
+  if (fstat(fd, &status) != 0 || status.st_size < PULSE_SENSOR_RECORDING_HEADER_BYTES) {
+    ::close(fd);
+    return fail("not a binary recording");
+  }
+  void *data = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    return fail("can't map");
+  }
+  Data = (const uint8_t *) data;
+  Size = (size_t) status.st_size;
+
+  unsigned int headerBytes = readWord(Data + 4);
+  SensorCount = Data[7];
+  if (memcmp(Data, "PSR1", 4) != 0) {
+    return fail("not a binary recording");
+  }
+  if (Data[6] != PULSE_SENSOR_RECORDING_VERSION) {
+    return fail("unsupported recording version");
+  }
+  if (SensorCount == 0 || headerBytes < PULSE_SENSOR_RECORDING_HEADER_BYTES + 2 * (unsigned int) SensorCount
+    || headerBytes > Size) {
+    return fail("damaged header");
+  }
+  SampleIntervalMicros = readLong(Data + 8);
+  Thresholds = Data + PULSE_SENSOR_RECORDING_HEADER_BYTES;
+
+  if (!readIndex() && !scanChunks()) {
+    return false;
+  }
+  FrameCount = 0;
+  if (!Chunks.empty()) {
+    RecordingChunk last;
+    if (!getChunk(Chunks.size() - 1, last)) {
+      return fail("damaged chunk");
+    }
+    FrameCount = last.firstFrame + last.frameCount;
+  }
+  return true;
+}
+
+void MappedRecording::close() {
+  if (Data) {
+    munmap((void *) Data, Size);
+  }
+  Data = NULL;
+  Size = 0;
+  Error = NULL;
+  SensorCount = 0;
+  Thresholds = NULL;
+  ChunksEnd = 0;
+  FrameCount = 0;
+  Indexed = false;
+  CutShort = false;
+  Chunks.clear();
+}
+
+bool MappedRecording::fail(const char *error) {
+  close();
+  Error = error;
+  return false;
+}
+
+/*
+   Read the index at the end of the file, if there is one.
+   Returns false if there isn't; getChunk() checks each chunk it points to.
+*/
+bool MappedRecording::readIndex() {
+  size_t headerBytes = readWord(Data + 4);
+  if (Size < headerBytes + PULSE_SENSOR_RECORDING_FOOTER_BYTES) {
+    return false;
+  }
+  const uint8_t *footer = Data + Size - PULSE_SENSOR_RECORDING_FOOTER_BYTES;
+  if (memcmp(footer, "PSRX", 4) != 0) {
+    return false;
+  }
+  uint64_t count = readLong(footer + 4);
+  uint64_t indexOffset = readLongLong(footer + 8);
+  // Check each part fits before adding or multiplying, so nothing can wrap.
+  const uint64_t indexEnd = Size - PULSE_SENSOR_RECORDING_FOOTER_BYTES;
+  if (indexOffset < headerBytes || indexOffset > indexEnd
+    || count > (indexEnd - indexOffset) / PULSE_SENSOR_RECORDING_INDEX_ENTRY_BYTES
+    || indexOffset + count * PULSE_SENSOR_RECORDING_INDEX_ENTRY_BYTES != indexEnd) {
+    return false;
+  }
+
+  Chunks.resize(count);
+  const uint8_t *entry = Data + indexOffset;
+  for (size_t c = 0; c < count; ++c, entry += PULSE_SENSOR_RECORDING_INDEX_ENTRY_BYTES) {
+    Chunks[c].firstFrame = readLong(entry);
+    Chunks[c].offset = readLongLong(entry + 4);
+    if (c > 0 && (Chunks[c].firstFrame < Chunks[c - 1].firstFrame
+      || Chunks[c].offset <= Chunks[c - 1].offset)) {
+      Chunks.clear();
+      return false; // out of order: not an index we can use.
+    }
+  }
+  ChunksEnd = (size_t) indexOffset;
+  Indexed = true;
+  return true;
+}
+
+/*
+   Find the chunks by reading each chunk header in turn.
+   A recording whose last chunk was only partly written (the power
+   went off, say) ends at the last complete chunk.
+*/
+bool MappedRecording::scanChunks() {
+  size_t offset = readWord(Data + 4);
+  while (offset < Size) {
+    const uint8_t *p = Data + offset;
+    if (Size - offset < PULSE_SENSOR_RECORDING_CHUNK_HEADER_BYTES
+      || Size - offset - PULSE_SENSOR_RECORDING_CHUNK_HEADER_BYTES < readWord(p + 2)) {
+      CutShort = true;
+      break;
+    }
+    if (p[0] != 'C' || p[1] != 'K') {
+      return fail("damaged chunk");
+    }
+    ChunkStart start = { readLong(p + 4), offset };
+    Chunks.push_back(start);
+    offset += PULSE_SENSOR_RECORDING_CHUNK_HEADER_BYTES + readWord(p + 2);
+  }
+  ChunksEnd = offset;
+  return true;
+}
+
+int MappedRecording::getThreshold(int sensorIndex) const {
+  if (sensorIndex < 0 || sensorIndex >= SensorCount) {
+    return 0; // out of range.
+  }
+  return (int16_t) readWord(Thresholds + 2 * sensorIndex);
+}
+
+bool MappedRecording::getChunk(size_t i, RecordingChunk &chunk, uint64_t *offset) const {
+  if (i >= Chunks.size() || Chunks[i].offset > ChunksEnd
+    || ChunksEnd - Chunks[i].offset < PULSE_SENSOR_RECORDING_CHUNK_HEADER_BYTES) {
+    return false;
+  }
+  const uint8_t *p = Data + Chunks[i].offset;
+  size_t payload = readWord(p + 2);
+  chunk.firstFrame = readLong(p + 4);
+  chunk.frameCount = readWord(p + 8);
+  chunk.beatCount = readWord(p + 10);
+  size_t beatBytes = (size_t) chunk.beatCount * PULSE_SENSOR_RECORDING_BEAT_BYTES;
+  if (p[0] != 'C' || p[1] != 'K' || chunk.firstFrame != Chunks[i].firstFrame
+    || ChunksEnd - Chunks[i].offset - PULSE_SENSOR_RECORDING_CHUNK_HEADER_BYTES < payload
+    || beatBytes > payload) {
+    return false;
+  }
+  chunk.samples = p + PULSE_SENSOR_RECORDING_CHUNK_HEADER_BYTES;
+  chunk.samplesEnd = chunk.samples + payload - beatBytes;
+  chunk.beats = chunk.samplesEnd;
+  if (offset) {
+    *offset = Chunks[i].offset;
+  }
+  return true;
+}
+
+size_t MappedRecording::findChunk(unsigned long frame) const {
+  // Binary search for the last chunk starting at or before the frame.
+  size_t low = 0;
+  size_t high = Chunks.size();
+  while (high - low > 1) {
+    size_t middle = low + (high - low) / 2;
+    if (Chunks[middle].firstFrame <= frame) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+unsigned long MappedRecording::frameAtMicros(uint64_t micros) const {
+  if (SampleIntervalMicros == 0) {
+    return 0;
+  }
+  return (unsigned long) (micros / SampleIntervalMicros);
+}
+
+void MappedRecording::getBeat(const RecordingChunk &chunk, unsigned int b, RecordedBeat &beat) {
+  const uint8_t *p = chunk.beats + (size_t) b * PULSE_SENSOR_RECORDING_BEAT_BYTES;
+  beat.frame = chunk.firstFrame + readWord(p);
+  beat.sensorIndex = p[2];
+  beat.beatsPerMinute = readWord(p + 4);
+  beat.interBeatIntervalMs = readWord(p + 6);
+}
+
+RecordingCursor::RecordingCursor(const MappedRecording &recording)
+  : Recording(recording), Previous(recording.getSensorCount()), ChunkIndex(0),
+    ChunkLoaded(false), Next(NULL), Frame(0), Beat(0) {
+}
+
+bool RecordingCursor::loadChunk(size_t c) {
+  ChunkLoaded = false;
+  if (!Recording.getChunk(c, Chunk)) {
+    return false;
+  }
+  ChunkIndex = c;
+  ChunkLoaded = true;
+  Next = Chunk.samples;
+  Frame = Chunk.firstFrame;
+  Beat = 0;
+  return true;
+}
+
+bool RecordingCursor::seekFrame(unsigned long frame) {
+  if (frame >= Recording.getFrameCount() || !loadChunk(Recording.findChunk(frame))) {
+    return false;
+  }
+  // Decode from the chunk's first frame up to the one before.
+  while (Frame < frame) {
+    if (!next(NULL)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool RecordingCursor::seekMicros(uint64_t micros) {
+  return seekFrame(Recording.frameAtMicros(micros));
+}
+
+bool RecordingCursor::next(int16_t *frame) {
+  if (!ChunkLoaded) {
+    if (!loadChunk(ChunkIndex)) {
+      return false;
+    }
+  }
+  while (Frame >= Chunk.firstFrame + Chunk.frameCount) {
+    if (ChunkIndex + 1 >= Recording.getChunkCount() || !loadChunk(ChunkIndex + 1)) {
+      return false;
+    }
+  }
+
+  const int sensorCount = (int) Previous.size();
+  if (Frame == Chunk.firstFrame) {
+    // The first frame of a chunk is stored as-is.
+    if (Chunk.samplesEnd - Next < 2 * sensorCount) {
+      return false;
+    }
+    for (int i = 0; i < sensorCount; ++i, Next += 2) {
+      Previous[i] = (int16_t) readWord(Next);
+    }
+  } else {
+    for (int i = 0; i < sensorCount; ++i) {
+      // A zigzag-encoded difference, 7 bits per byte.
+      unsigned long zigzag = 0;
+      int shift = 0;
+      uint8_t b;
+      do {
+        if (Next >= Chunk.samplesEnd || shift > 14) {
+          return false;
+        }
+        b = *Next++;
+        zigzag |= (unsigned long) (b & 0x7F) << shift;
+        shift += 7;
+      } while (b & 0x80);
+      long difference = (long) (zigzag >> 1) ^ -(long) (zigzag & 1);
+      Previous[i] = (int16_t) (Previous[i] + difference);
+    }
+  }
+  ++Frame;
+  if (frame) {
+    memcpy(frame, Previous.data(), sensorCount * sizeof(int16_t));
+  }
+  return true;
+}
+
+bool RecordingCursor::nextBeat(RecordedBeat &beat) {
+  if (!ChunkLoaded || Frame == Chunk.firstFrame) {
+    return false; // no frame yet.
+  }
+  while (Beat < Chunk.beatCount) {
+    MappedRecording::getBeat(Chunk, Beat, beat);
+    if (beat.frame >= Frame) {
+      return false; // on a later frame.
+    }
+    ++Beat;
+    if (beat.frame == Frame - 1) {
+      return true;
+    }
+  }
+  return false;
+}
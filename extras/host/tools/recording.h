@@ -0,0 +1,183 @@
+/*
+   Reading PulseSensor recordings, for the host tools.
+
+   A recording is text, one sample period per line. A line holds one
+   value per PulseSensor (0..1023), separated by commas, tabs or spaces.
+   Lines starting with '#' are ignored.
+   Recordings may also be in the binary format of PulseSensorRecorder
+   (see src/utility/PulseSensorRecorder.h), which MappedRecording reads.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <PulseSensorPlayground.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+/*
+   Read a recording into one vector of samples per PulseSensor.
+   Returns false if there are no samples, or if lines have
+   differing numbers of values.
+*/
+bool readRecording(FILE *in, std::vector<std::vector<int> > &channels);
+
+/*
+   Read a text or binary recording from the named file.
+   Returns false as readRecording() does, or if the file can't be read.
+*/
+bool loadRecording(const char *path, std::vector<std::vector<int> > &channels);
+
+/*
+   Add an index to the end of a binary recording, so readers can find
+   its chunks without reading them all. Does nothing if it has one.
+   Returns false if the file can't be read or written, or is cut short.
+*/
+bool appendRecordingIndex(const char *path);
+
+/*
+   A chunk of a binary recording. The pointers point into the
+   mapped file; nothing is copied.
+*/
+struct RecordingChunk {
+  unsigned long firstFrame;       // number of the chunk's first frame.
+  unsigned int frameCount;
+  unsigned int beatCount;
+  const uint8_t *samples;         // the encoded samples.
+  const uint8_t *samplesEnd;
+  const uint8_t *beats;           // beatCount beats, 8 bytes each.
+};
+
+// A beat from a binary recording.
+struct RecordedBeat {
+  unsigned long frame;            // frame the beat was found on.
+  int sensorIndex;
+  int beatsPerMinute;
+  int interBeatIntervalMs;
+};
+
+/*
+   A binary recording, mapped into memory with mmap().
+   Opening it reads only the header and the index at the end of the
+   file (or, without an index, each chunk header). Samples are decoded
+   straight from the mapped file by a RecordingCursor.
+*/
+class MappedRecording {
+  public:
+    MappedRecording();
+    ~MappedRecording();
+
+    /*
+       Map the named file. Returns false, with getError() saying why,
+       if it can't be read or isn't a binary recording.
+    */
+    bool open(const char *path);
+    void close();
+    const char *getError() const { return Error; }
+
+    int getSensorCount() const { return SensorCount; }
+    unsigned long getSampleIntervalMicros() const { return SampleIntervalMicros; }
+    int getThreshold(int sensorIndex) const;
+    unsigned long getFrameCount() const { return FrameCount; }
+    size_t getChunkCount() const { return Chunks.size(); }
+    bool hasIndex() const { return Indexed; }
+    // Returns true if the last chunk was cut short, and left out.
+    bool isCutShort() const { return CutShort; }
+
+    /*
+       Find chunk i. Returns false if it's damaged.
+       offset, if not NULL, is set to where the chunk starts in the file.
+    */
+    bool getChunk(size_t i, RecordingChunk &chunk, uint64_t *offset = NULL) const;
+
+    // Returns the chunk holding the given frame (the last chunk if past the end).
+    size_t findChunk(unsigned long frame) const;
+
+    // Returns the frame sampled at the given time since the recording began.
+    unsigned long frameAtMicros(uint64_t micros) const;
+
+    // Returns beat b of the chunk.
+    static void getBeat(const RecordingChunk &chunk, unsigned int b, RecordedBeat &beat);
+
+  private:
+    MappedRecording(const MappedRecording &);              // not copyable.
+    MappedRecording &operator=(const MappedRecording &);
+
+    bool fail(const char *error);
+    bool readIndex();
+    bool scanChunks();
+
+    struct ChunkStart {
+      unsigned long firstFrame;
+      uint64_t offset;
+    };
+
+    const uint8_t *Data;
+    size_t Size;
+    const char *Error;
+    int SensorCount;
+    unsigned long SampleIntervalMicros;
+    const uint8_t *Thresholds;
+    size_t ChunksEnd;               // where the chunks (and the index) end.
+    unsigned long FrameCount;
+    bool Indexed;
+    bool CutShort;
+    std::vector<ChunkStart> Chunks;
+};
+
+/*
+   Reads a MappedRecording one frame at a time, from any frame.
+     RecordingCursor cursor(recording);
+     cursor.seekMicros(60000000);        // one minute in.
+     while (cursor.next(frame)) {
+       RecordedBeat beat;
+       while (cursor.nextBeat(beat)) ...
+     }
+*/
+class RecordingCursor {
+  public:
+    RecordingCursor(const MappedRecording &recording);
+
+    // Move to the given frame, or to the frame sampled at the given time.
+    // Returns false if there's no such frame.
+    bool seekFrame(unsigned long frame);
+    bool seekMicros(uint64_t micros);
+
+    /*
+       Decode the next frame into frame[0..getSensorCount() - 1].
+       Returns false at the end of the recording, or if it's damaged.
+    */
+    bool next(int16_t *frame);
+
+    // Returns the number of the frame next() returned last.
+    unsigned long getFrame() const { return Frame - 1; }
+
+    // Returns the beats on the frame next() returned last, one per call.
+    bool nextBeat(RecordedBeat &beat);
+
+  private:
+    bool loadChunk(size_t c);
+
+    const MappedRecording &Recording;
+    std::vector<int16_t> Previous;  // each sensor's previous sample.
+    RecordingChunk Chunk;
+    size_t ChunkIndex;
+    bool ChunkLoaded;
+    const uint8_t *Next;            // next encoded sample.
+    unsigned long Frame;            // the frame next() will return.
+    unsigned int Beat;              // next beat of the chunk to look at.
+};
+
+#endif // RECORDING_H
@@ -27,6 +27,83 @@
 #include "utility/TimerHandler.h"   
 #endif
 
+/*
+   The FOUND_* flags a PulseSensorTransitTime needs to see.
+*/
+#define TRANSIT_TIME_EVENTS (PulseSensor::FOUND_BEAT_START | PulseSensor::FOUND_SIGNAL_LOST)
+
+#if USE_HARDWARE_TIMER && defined(ARDUINO_ARCH_AVR)
+/*
+   AVR timer prescalers, as powers of 2, in clock select (CS bits) order.
+*/
+static const byte TIMER2_PRESCALE_SHIFTS[] = {0, 3, 5, 6, 7, 8, 10};   // 1, 8, 32 .. 1024
+static const byte TIMER16_PRESCALE_SHIFTS[] = {0, 3, 6, 8, 10};        // Timer1, Timer3: 1, 8, 64, 256, 1024
+static const byte TINY_TIMER1_PRESCALE_SHIFTS[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14};
+
+/*
+   Find the smallest prescaler that lets an AVR timer in CTC mode
+   count one sample interval in maxCounts counts or fewer.
+   The smallest prescaler gives the most accurate sample rate.
+
+   top = set to the count to put in the timer's compare register.
+   Returns the clock select (CS) bits for the prescaler, or 0 if the
+   interval is too long for the timer.
+*/
+static byte findTimerPrescale(unsigned long intervalMicros,
+  const byte *prescaleShifts, byte prescaleCount, unsigned long maxCounts,
+  unsigned long &top) {
+  unsigned long cycles = (F_CPU / 1000000UL) * intervalMicros;
+  for (byte i = 0; i < prescaleCount; ++i) {
+    byte shift = prescaleShifts[i];
+    unsigned long counts = cycles >> shift;
+    if (shift > 0 && (cycles & (1UL << (shift - 1)))) {
+      ++counts; // round to nearest
+    }
+    if (counts > 0 && counts <= maxCounts) {
+      top = counts - 1;
+      return i + 1;
+    }
+  }
+  return 0;
+}
+#endif
+
+#if PULSE_SENSOR_ADC_CHAIN
+/*
+   The ADC's voltage reference (REFS) bits, as analogRead() last set
+   them, so conversions started here honor analogReference().
+*/
+static byte AdcReference;
+
+/*
+   The ADC channel of an analog pin, as analogRead() works it out.
+*/
+static byte adcChannel(int pin) {
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+  if (pin >= 54) pin -= 54;   // allow for channel or pin numbers
+#elif defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega16U4__)
+  if (pin >= 18) pin -= 18;
+  pin = analogPinToChannel(pin);
+#else
+  if (pin >= 14) pin -= 14;
+#endif
+  return (byte) pin;
+}
+
+/*
+   Start converting the given analog pin, with the conversion complete
+   interrupt on, and return straight away.
+*/
+static void startConversion(int pin) {
+  byte channel = adcChannel(pin);
+#if defined(MUX5)
+  ADCSRB = (ADCSRB & ~(1 << MUX5)) | (((channel >> 3) & 0x01) << MUX5);
+#endif
+  ADMUX = AdcReference | (channel & 0x07);
+  ADCSRA |= (1 << ADSC) | (1 << ADIE);
+}
+#endif // PULSE_SENSOR_ADC_CHAIN
+
 PulseSensorPlayground::PulseSensorPlayground(int numberOfSensors) {
   // Save a static pointer to our playground so the ISR can read it.
 #if USE_HARDWARE_TIMER    
@@ -36,13 +113,44 @@ PulseSensorPlayground::PulseSensorPlayground(int numberOfSensors) {
   // Dynamically create the array to minimize ram usage.
   SensorCount = (byte) numberOfSensors;
   Sensors = new PulseSensor[SensorCount];
+  initializeVariables();
+}
+
+PulseSensorPlayground::PulseSensorPlayground(PulseSensor *sensors, int numberOfSensors) {
+#if USE_HARDWARE_TIMER    
+  OurThis = this;
+#endif
+
+  // The caller owns the array; see PulseSensorPlaygroundT.
+  SensorCount = (byte) numberOfSensors;
+  Sensors = sensors;
+  initializeVariables();
+}
+
+void PulseSensorPlayground::initializeVariables() {
+  SampleIntervalMicros = MICROS_PER_READ;
+  DeferLEDs = false;
+  CallbackEvents = 0;
+  CallbackFlags = 0;
+  CallbackInISR = 0;
+  pTransitTimes = NULL;
+  pAcquisition = NULL;
+  for (int i = 0; i < 3; ++i) {
+    BeatCallbacks[i] = NULL;
+    BeatCallbackContexts[i] = NULL;
+  }
+  EventOverruns = 0;
+  SampleCount = 0;
+#if PULSE_SENSOR_ACQUISITION_TIMES
+  CompensateSkew = false;
+  FirstOffsetMicros = 0;
+#endif
 
 // set our internal variable to reflect hardware timer use
   UsingHardwareTimer = USE_HARDWARE_TIMER;
 
 #if PULSE_SENSOR_TIMING_ANALYSIS
-  // We want sample timing analysis, so we construct it.
-  pTiming = new PulseSensorTimingStatistics(MICROS_PER_READ, 500 * 30L);
+  pTiming = NULL; // constructed in begin(), once the sample rate is known.
 #endif // PULSE_SENSOR_TIMING_ANALYSIS
 }
 
@@ -52,20 +160,49 @@ bool PulseSensorPlayground::PulseSensorPlayground::begin() {
     Sensors[i].initializeLEDs();
   }
 
+#if PULSE_SENSOR_TIMING_ANALYSIS
+  // We want sample timing analysis, so we construct it.
+  if (!pTiming) {
+    pTiming = new PulseSensorTimingStatistics(SampleIntervalMicros, getSampleRate() * 30L);
+  }
+#endif // PULSE_SENSOR_TIMING_ANALYSIS
+
   // Note the time, for non-interrupt sampling and for timing statistics.
-  NextSampleMicros = micros() + MICROS_PER_READ;
+  NextSampleMicros = micros() + SampleIntervalMicros;
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+  TimingHistogram.begin(SampleIntervalMicros, SensorCount);
+#endif
 
   SawNewSample = false;
+  SampleCount = 0;
 	Paused = false;
 
+#if PULSE_SENSOR_ADC_CHAIN
+  /*
+     Let analogRead() set up the ADC (and the reference the Sketch chose)
+     once; from now on the sample timer and the ADC interrupt read it.
+  */
+  Converting = false;
+  SampleDue = false;
+  SkippedSamples = 0;
+  SampleOverruns = 0;
+  analogRead(Sensors[0].getInputPin());
+  AdcReference = ADMUX & ((1 << REFS1) | (1 << REFS0));
+#endif
+
 #if PULSE_SENSOR_MEMORY_USAGE
   // Report the RAM usage
   printMemoryUsage();
   // for (;;);   // optional hang.
 #endif // PULSE_SENSOR_MEMORY_USAGE
 
-  // Lastly, set up and turn on the interrupts.
-  if (UsingHardwareTimer) {
+  // Lastly, start the acquisition, or set up and turn on the interrupts.
+  if (pAcquisition) {
+    if (!pAcquisition->begin(Sensors, SensorCount, SampleIntervalMicros)) {
+      Paused = true;
+      return false;
+    }
+  } else if (UsingHardwareTimer) {
     if (!setupInterrupt()) {
 			Paused = true;
       return false;
@@ -83,21 +220,21 @@ bool PulseSensorPlayground::PulseSensorPlayground::begin() {
 }
 
 void PulseSensorPlayground::analogInput(int inputPin, int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return; // out of range.
   }
   Sensors[sensorIndex].analogInput(inputPin);
 }
 
 void PulseSensorPlayground::blinkOnPulse(int blinkPin, int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return; // out of range.
   }
   Sensors[sensorIndex].blinkOnPulse(blinkPin);
 }
 
 void PulseSensorPlayground::fadeOnPulse(int fadePin, int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return; // out of range.
   }
   Sensors[sensorIndex].fadeOnPulse(fadePin);
@@ -115,26 +252,34 @@ bool PulseSensorPlayground::sawNewSample() {
   */
   bool result = false;
   if(!Paused){
-    if (UsingHardwareTimer) {
+    if (pAcquisition) {
+      result = processAcquiredBlocks();
+    } else if (UsingHardwareTimer) {
       // Disable interrupts to avoid a race with the ISR.
-      // DISABLE_PULSE_SENSOR_INTERRUPTS;
+      DISABLE_PULSE_SENSOR_INTERRUPTS;
       bool sawOne = SawNewSample;
       SawNewSample = false;
-      // ENABLE_PULSE_SENSOR_INTERRUPTS;
+      ENABLE_PULSE_SENSOR_INTERRUPTS;
 
       result = sawOne;
     } else { 
-// Sample PulseSensor as close as you can to 500Hz when not using hardware timer
+// Sample PulseSensor as close as you can to the sample rate when not using hardware timer
       unsigned long nowMicros = micros();
       if ((long) (NextSampleMicros - nowMicros) > 0L) {
-        result = false;  // not time yet.
+        return false;  // not time yet.
+      }
+      // Schedule from when this sample was due, not from now,
+      // so a slow loop() doesn't lower the average sample rate.
+      NextSampleMicros += SampleIntervalMicros;
+      if ((long) (nowMicros - NextSampleMicros) >= 0L) {
+        // More than a sample behind; start over rather than catch up in a burst.
+        NextSampleMicros = nowMicros + SampleIntervalMicros;
       }
-      NextSampleMicros = nowMicros + MICROS_PER_READ;
 
     #if PULSE_SENSOR_TIMING_ANALYSIS
-      if (pTiming->recordSampleTime() <= 0) {
+      if (pTiming->recordSampleTime() == 0) {
         pTiming->outputStatistics(SerialOutput.getSerial());
-        for (;;); // Hang because we've disturbed the timing.
+        pTiming->restart(); // printing disturbed the timing of this sample.
       }
     #endif // PULSE_SENSOR_TIMING_ANALYSIS
 
@@ -143,73 +288,558 @@ bool PulseSensorPlayground::sawNewSample() {
       result = true;
   	}
   }
+  if (result && DeferLEDs) {
+    updateLEDs();
+  }
+  dispatchBeatEvents();
   return result;
 }
 
+bool PulseSensorPlayground::setSampleRate(unsigned int samplesPerSecond) {
+  if (samplesPerSecond == 0 || samplesPerSecond > 10000) {
+    return false;
+  }
+  unsigned long intervalMicros = 1000000UL / samplesPerSecond;
+  for (int i = 0; i < SensorCount; ++i) {
+    PulseSensorFilter *filter = Sensors[i].getFilter();
+    if (filter && !filter->canFilterAt(intervalMicros)) {
+      return false;
+    }
+  }
+  SampleIntervalMicros = intervalMicros;
+  for (int i = 0; i < SensorCount; ++i) {
+    Sensors[i].setSampleIntervalMicros(SampleIntervalMicros);
+  }
+  return true;
+}
+
+unsigned int PulseSensorPlayground::getSampleRate() {
+  return (unsigned int) ((1000000UL + SampleIntervalMicros / 2) / SampleIntervalMicros);
+}
+
+unsigned long PulseSensorPlayground::getSampleIntervalMicros() {
+  return SampleIntervalMicros;
+}
+
+bool PulseSensorPlayground::setOversampling(byte ratio) {
+  byte shift = 0;
+  while (shift < 4 && (1 << shift) < ratio) {
+    ++shift;
+  }
+  if (ratio != (1 << shift) || (pAcquisition && shift > 0)) {
+    return false;
+  }
+  for (int i = 0; i < SensorCount; ++i) {
+    Sensors[i].setOversampling(shift);
+  }
+  return true;
+}
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+void PulseSensorPlayground::setSkewCompensation(bool compensate) {
+  CompensateSkew = compensate;
+}
+#endif
+
+void PulseSensorPlayground::deferLEDUpdates(bool defer) {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  DeferLEDs = defer;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+
+void PulseSensorPlayground::updateLEDs() {
+  for (int i = 0; i < SensorCount; ++i) {
+    Sensors[i].updateLEDs();
+  }
+}
+
 void PulseSensorPlayground::onSampleTime() {
-  // Typically called from the ISR at 500Hz
+  // Typically called from the ISR at the sample rate (500Hz by default)
   // digitalWrite(timingPin,HIGH); // optionally connect timingPin to oscilloscope to time algorithm run time
+#if PULSE_SENSOR_ADC_CHAIN
+  if (UsingHardwareTimer) {
+    if (!Converting) {
+      startSample();
+    } else if (!SampleDue) {
+      SampleDue = true;  // start it as soon as the last sample is processed.
+    } else {
+      // Already one behind; skip this one, but keep the clocks right.
+      if (SkippedSamples < 255) {
+        ++SkippedSamples;
+      }
+      ++SampleOverruns;
+    }
+    return; // onConversionComplete() does the rest.
+  }
+#endif // PULSE_SENSOR_ADC_CHAIN
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+  unsigned long startMicros = micros();
+  AcquiredMicros = startMicros;
+#endif
+
+  sampleSensors();
+  ++SampleCount;
+
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+  TimingHistogram.recordSample(startMicros, AcquiredMicros - startMicros,
+    micros() - startMicros);
+#endif
+  SawNewSample = true;  // for sawNewSample(), with the hardware timer.
+  // digitalWrite(timingPin,LOW); // optionally connect timingPin to oscilloscope to time algorithm run time
+}
+
+unsigned long PulseSensorPlayground::getSampleOverruns() {
+#if PULSE_SENSOR_ADC_CHAIN
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  unsigned long overruns = SampleOverruns;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return overruns;
+#else
+  return 0;
+#endif
+}
+
+#if PULSE_SENSOR_ADC_CHAIN
+void PulseSensorPlayground::startSample() {
+  Converting = true;
+#if PULSE_SENSOR_TIMING_HISTOGRAMS || PULSE_SENSOR_ACQUISITION_TIMES
+  SampleStartMicros = micros();
+#endif
+#if PULSE_SENSOR_ACQUISITION_TIMES
+  SensorStartMicros = SampleStartMicros;
+#endif
+  ConvertingSensor = 0;
+  ConversionsLeft = 1 << Sensors[0].getOversampling();
+  ConversionSum = 0;
+  startConversion(Sensors[0].getInputPin());
+}
+
+void PulseSensorPlayground::onConversionComplete(int reading) {
+  ConversionSum += reading;
+  if (--ConversionsLeft == 0) {
+    Sensors[ConvertingSensor].setReadingSum(ConversionSum);
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    unsigned long now = micros();
+    setAcquisitionOffset(ConvertingSensor, (word) ((SensorStartMicros - SampleStartMicros)
+      + (now - SensorStartMicros) / 2));
+    SensorStartMicros = now;
+#endif
+    if (++ConvertingSensor < SensorCount) {
+      ConversionsLeft = 1 << Sensors[ConvertingSensor].getOversampling();
+      ConversionSum = 0;
+    }
+  }
+  if (ConvertingSensor < SensorCount) {
+    startConversion(Sensors[ConvertingSensor].getInputPin());
+    return;
+  }
+  ADCSRA &= ~(1 << ADIE); // leave the ADC to analogRead() until the next sample.
+
+  /*
+     Every PulseSensor is read. Look for beats with interrupts on, so
+     the Sketch's interrupts wait no longer than a conversion does.
+     Converting keeps the sample timer from starting the next sample
+     until we're done; a tick that comes meanwhile sets SampleDue.
+  */
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+  AcquiredMicros = micros();
+#endif
+  byte skipped = SkippedSamples;
+  SkippedSamples = 0;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  if (skipped > 0) {
+    for (int i = 0; i < SensorCount; ++i) {
+      Sensors[i].skipSamples(skipped);
+    }
+  }
+  processSamples();
+  ++SampleCount;
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+  TimingHistogram.recordSample(SampleStartMicros, AcquiredMicros - SampleStartMicros,
+    micros() - SampleStartMicros);
+#endif
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  SawNewSample = true;
+  if (SampleDue) {
+    SampleDue = false;
+    startSample();
+  } else {
+    Converting = false;
+  }
+}
+#endif // PULSE_SENSOR_ADC_CHAIN
+
+void PulseSensorPlayground::sampleSensors() {
   /*
      Read the voltage from each PulseSensor.
      We do this separately from processing the samples
      to minimize jitter in acquiring the signal.
   */
   for (int i = 0; i < SensorCount; ++i) {
-    Sensors[i].readNextSample();
+    readSensor(Sensors[i], i);
   }
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+  AcquiredMicros = micros();
+#endif
+
+  processSamples();
+}
 
-  // Process those samples.
+void PulseSensorPlayground::processSamples() {
   for (int i = 0; i < SensorCount; ++i) {
-    Sensors[i].processLatestSample();
-    Sensors[i].updateLEDs();
+    byte found = Sensors[i].processLatestSample();
+    if (found & CallbackEvents) {
+      handleBeatEvents(i, found);
+    }
   }
+  if (!DeferLEDs) {
+    updateLEDs();
+  }
+}
 
-  // Set the flag that says we've read a sample since the Sketch checked.
-  // digitalWrite(timingPin,LOW); // optionally connect timingPin to oscilloscope to time algorithm run time
- }
+bool PulseSensorPlayground::processAcquiredBlocks() {
+  bool processed = false;
+  const int16_t *block;
+  while ((block = pAcquisition->readBlock()) != NULL) {
+    int frames = pAcquisition->getFramesPerBlock();
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    for (int i = 0; i < SensorCount; ++i) {
+      setAcquisitionOffset(i, pAcquisition->getOffsetMicros(i));
+    }
+#endif
+    const int16_t *pSample = block;
+    for (int f = 0; f < frames; ++f) {
+      for (int i = 0; i < SensorCount; ++i) {
+        Sensors[i].setReadingSum((word) *pSample++);
+      }
+      processSamples();
+      ++SampleCount;
+    }
+    pAcquisition->releaseBlock();
+    processed = true;
+  }
+  return processed;
+}
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+void PulseSensorPlayground::setAcquisitionOffset(int sensorIndex, word offsetMicros) {
+  if (sensorIndex == 0) {
+    FirstOffsetMicros = offsetMicros;
+  }
+  word skewMicros = CompensateSkew && offsetMicros > FirstOffsetMicros
+    ? offsetMicros - FirstOffsetMicros
+    : 0;
+  Sensors[sensorIndex].setAcquisitionTime(offsetMicros, skewMicros);
+}
+#endif
+
+void PulseSensorPlayground::handleBeatEvents(int sensorIndex, byte found) {
+  if (pTransitTimes) {
+    unsigned long beatMicros = Sensors[sensorIndex].getBeatMicros();
+    for (PulseSensorTransitTime *p = pTransitTimes; p; p = p->pNext) {
+      p->addBeat(sensorIndex, found, beatMicros);
+    }
+  }
+
+  PendingBeatEvent event;
+  Sensors[sensorIndex].getBeatEvent(event.beat);
+  event.beat.sampleIndex = SampleCount;
+  event.beat.sensorIndex = sensorIndex;
+
+  // In FOUND_* flag order, so a beat's end never comes before its start.
+  for (byte i = 0; i < 3; ++i) {
+    byte flag = 1 << i;
+    if ((found & CallbackFlags & flag) == 0) {
+      continue;
+    }
+    if (CallbackInISR & flag) {
+      BeatCallbacks[i](event.beat, BeatCallbackContexts[i]);
+    } else {
+      event.found = flag;
+      if (!EventQueue.put(event)) {
+        ++EventOverruns; // full, or no queue given.
+      }
+    }
+  }
+}
+
+void PulseSensorPlayground::onBeatStart(PulseSensorBeatCallback callback,
+  void *context, bool inISR) {
+  setBeatCallback(PulseSensor::FOUND_BEAT_START, callback, context, inISR);
+}
+
+void PulseSensorPlayground::onBeatEnd(PulseSensorBeatCallback callback,
+  void *context, bool inISR) {
+  setBeatCallback(PulseSensor::FOUND_BEAT_END, callback, context, inISR);
+}
+
+void PulseSensorPlayground::onSignalLost(PulseSensorBeatCallback callback,
+  void *context, bool inISR) {
+  setBeatCallback(PulseSensor::FOUND_SIGNAL_LOST, callback, context, inISR);
+}
+
+void PulseSensorPlayground::setBeatCallback(byte flag,
+  PulseSensorBeatCallback callback, void *context, bool inISR) {
+  byte i = flag == PulseSensor::FOUND_BEAT_START ? 0
+    : flag == PulseSensor::FOUND_BEAT_END ? 1 : 2;
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  BeatCallbacks[i] = callback;
+  BeatCallbackContexts[i] = context;
+  if (callback) {
+    CallbackFlags |= flag;
+  } else {
+    CallbackFlags &= ~flag;
+  }
+  CallbackEvents = CallbackFlags | (pTransitTimes ? TRANSIT_TIME_EVENTS : 0);
+  if (inISR) {
+    CallbackInISR |= flag;
+  } else {
+    CallbackInISR &= ~flag;
+  }
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+
+bool PulseSensorPlayground::setEventQueue(PendingBeatEvent *storage, int capacity) {
+  if (storage && (capacity <= 0 || (unsigned long) capacity > PULSE_SENSOR_RING_MAX_CAPACITY
+    || (capacity & (capacity - 1)) != 0)) {
+    return false; // not a size the ring can use.
+  }
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  EventQueue.begin(storage, storage ? (size_t) capacity : 0);
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return true;
+}
+
+void PulseSensorPlayground::dispatchBeatEvents() {
+  PendingBeatEvent event;
+  while (EventQueue.get(&event, 1) == 1) {
+    // The Sketch may have changed the callback since the event was queued.
+    DISABLE_PULSE_SENSOR_INTERRUPTS;
+    PulseSensorBeatCallback callback = NULL;
+    void *context = NULL;
+    if (event.found & CallbackFlags & ~CallbackInISR) {
+      byte i = event.found == PulseSensor::FOUND_BEAT_START ? 0
+        : event.found == PulseSensor::FOUND_BEAT_END ? 1 : 2;
+      callback = BeatCallbacks[i];
+      context = BeatCallbackContexts[i];
+    }
+    ENABLE_PULSE_SENSOR_INTERRUPTS;
+
+    if (callback) {
+      callback(event.beat, context);
+    }
+  }
+}
+
+unsigned long PulseSensorPlayground::getEventOverruns() {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  unsigned long overruns = EventOverruns;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return overruns;
+}
+
+bool PulseSensorPlayground::addTransitTime(PulseSensorTransitTime &transitTime) {
+  if (transitTime.getProximalIndex() >= SensorCount
+    || transitTime.getDistalIndex() >= SensorCount) {
+    return false; // out of range.
+  }
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  transitTime.pNext = pTransitTimes;
+  pTransitTimes = &transitTime;
+  CallbackEvents = CallbackFlags | TRANSIT_TIME_EVENTS;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return true;
+}
+
+long PulseSensorPlayground::getPulseTransitTimeMicros(int proximalIndex,
+  int distalIndex) {
+  for (PulseSensorTransitTime *p = pTransitTimes; p; p = p->pNext) {
+    if (p->getProximalIndex() == proximalIndex && p->getDistalIndex() == distalIndex) {
+      return p->getTransitTimeMicros();
+    }
+  }
+  return -1;
+}
+
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+void PulseSensorPlayground::getTimingHistogram(
+  PulseSensorTimingHistogram &histogram, bool reset) {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  histogram = TimingHistogram;
+  if (reset) {
+    TimingHistogram.reset();
+  }
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+#endif // PULSE_SENSOR_TIMING_HISTOGRAMS
 
 int PulseSensorPlayground::getLatestSample(int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return -1; // out of range.
   }
   return Sensors[sensorIndex].getLatestSample();
 }
 
+int PulseSensorPlayground::getOversampledSample(int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return -1; // out of range.
+  }
+  return Sensors[sensorIndex].getOversampledSample();
+}
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+word PulseSensorPlayground::getAcquisitionOffsetMicros(int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return 0; // out of range.
+  }
+  return Sensors[sensorIndex].getAcquisitionOffsetMicros();
+}
+#endif
+
 int PulseSensorPlayground::getBeatsPerMinute(int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return -1; // out of range.
   }
   return Sensors[sensorIndex].getBeatsPerMinute();
 }
 
 int PulseSensorPlayground::getInterBeatIntervalMs(int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return -1; // out of range.
   }
   return Sensors[sensorIndex].getInterBeatIntervalMs();
 }
 
 bool PulseSensorPlayground::sawStartOfBeat(int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return false; // out of range.
   }
   return Sensors[sensorIndex].sawStartOfBeat();
 }
 
 bool PulseSensorPlayground::isInsideBeat(int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return false; // out of range.
   }
   return Sensors[sensorIndex].isInsideBeat();
 }
 
 void PulseSensorPlayground::setThreshold(int threshold, int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return; // out of range.
   }
   Sensors[sensorIndex].setThreshold(threshold);
 }
 
+size_t PulseSensorPlayground::processBlock(const int16_t *samples,
+  size_t frameCount, BeatEvent *out, size_t outCap) {
+  if (SensorCount == 1) {
+    return Sensors[0].processBlock(samples, frameCount, out, outCap);
+  }
+
+  size_t beats = 0;
+  const int16_t *pSample = samples;
+  for (size_t frame = 0; frame < frameCount; ++frame) {
+    for (int i = 0; i < SensorCount; ++i) {
+      if ((Sensors[i].findBeat(*pSample++) & PulseSensor::FOUND_BEAT_START) == 0) {
+        continue;
+      }
+      if (out && beats < outCap) {
+        Sensors[i].getBeatEvent(out[beats]);
+        out[beats].sampleIndex = frame;
+        out[beats].sensorIndex = i;
+      }
+      ++beats;
+    }
+  }
+
+  if (frameCount > 0) {
+    const int16_t *lastFrame = samples + (frameCount - 1) * SensorCount;
+    for (int i = 0; i < SensorCount; ++i) {
+      Sensors[i].finishBlock(lastFrame[i]);
+    }
+  }
+  return beats;
+}
+
+bool PulseSensorPlayground::setBuffer(PulseSensorBuffer &buffer, int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return false; // out of range.
+  }
+  if (!buffer.isValid()) {
+    return false;
+  }
+  buffer.setSensorIndex(sensorIndex);
+  Sensors[sensorIndex].setBuffer(&buffer);
+  return true;
+}
+
+int PulseSensorPlayground::readSamples(int16_t *buf, int n, int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return 0; // out of range.
+  }
+  PulseSensorBuffer *pBuffer = Sensors[sensorIndex].getBuffer();
+  return pBuffer ? pBuffer->readSamples(buf, n) : 0;
+}
+
+int PulseSensorPlayground::readBeats(BeatEvent *buf, int n, int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return 0; // out of range.
+  }
+  PulseSensorBuffer *pBuffer = Sensors[sensorIndex].getBuffer();
+  return pBuffer ? pBuffer->readBeats(buf, n) : 0;
+}
+
+unsigned long PulseSensorPlayground::getSampleOverruns(int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return 0; // out of range.
+  }
+  PulseSensorBuffer *pBuffer = Sensors[sensorIndex].getBuffer();
+  return pBuffer ? pBuffer->getSampleOverruns() : 0;
+}
+
+unsigned long PulseSensorPlayground::getBeatOverruns(int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return 0; // out of range.
+  }
+  PulseSensorBuffer *pBuffer = Sensors[sensorIndex].getBuffer();
+  return pBuffer ? pBuffer->getBeatOverruns() : 0;
+}
+
+bool PulseSensorPlayground::setHRV(PulseSensorHRV &hrv, int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return false; // out of range.
+  }
+  if (!hrv.isValid()) {
+    return false;
+  }
+  Sensors[sensorIndex].setHRV(&hrv);
+  return true;
+}
+
+bool PulseSensorPlayground::getHRV(HRVMetrics &metrics, int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return false; // out of range.
+  }
+  PulseSensorHRV *pHRV = Sensors[sensorIndex].getHRV();
+  return pHRV ? pHRV->getMetrics(metrics) : false;
+}
+
+bool PulseSensorPlayground::setFilter(PulseSensorFilter &filter, int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return false; // out of range.
+  }
+  return Sensors[sensorIndex].setFilter(&filter);
+}
+
+void PulseSensorPlayground::setAcquisition(PulseSensorAcquisition &acquisition) {
+  pAcquisition = &acquisition;
+  // It takes one reading per sample; don't let setOversampling() pretend otherwise.
+  for (int i = 0; i < SensorCount; ++i) {
+    Sensors[i].setOversampling(0);
+  }
+}
+
 #if USE_SERIAL
 
   void PulseSensorPlayground::setSerial(Stream &output) {
@@ -232,33 +862,73 @@ void PulseSensorPlayground::setThreshold(int threshold, int sensorIndex) {
     SerialOutput.outputToSerial(s,d);
   }
 
+  void PulseSensorPlayground::setOutputQueue(byte *storage, int size) {
+    SerialOutput.setQueue(storage, size > 0 ? (word) size : 0);
+  }
+
+  unsigned long PulseSensorPlayground::getOutputDrops() {
+    return SerialOutput.getDrops();
+  }
+
+  void PulseSensorPlayground::drainOutputQueue() {
+    SerialOutput.drainQueue();
+  }
+
 #endif
 
 int PulseSensorPlayground::getPulseAmplitude(int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return -1; // out of range.
   }
   return Sensors[sensorIndex].getPulseAmplitude();
 }
 
 unsigned long PulseSensorPlayground::getLastBeatTime(int sensorIndex) {
-  if (sensorIndex != constrain(sensorIndex, 0, SensorCount)) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
     return -1; // out of range.
   }
   return Sensors[sensorIndex].getLastBeatTime();
 }
 
+unsigned long PulseSensorPlayground::getLastBeatTimeMicros(int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return -1; // out of range.
+  }
+  return Sensors[sensorIndex].getLastBeatTimeMicros();
+}
+
+unsigned long PulseSensorPlayground::getInterBeatIntervalMicros(int sensorIndex) {
+  if (sensorIndex != constrain(sensorIndex, 0, SensorCount - 1)) {
+    return -1; // out of range.
+  }
+  return Sensors[sensorIndex].getInterBeatIntervalMicros();
+}
+
 bool PulseSensorPlayground::isPaused() {
 	return Paused;
 }
 
 bool PulseSensorPlayground::pause() {
   bool result = true;
+  if (pAcquisition) {
+    pAcquisition->end();
+    for (int i = 0; i < SensorCount; i++) {
+      Sensors[i].resetVariables();
+    }
+    Paused = true;
+    return result;
+  }
 	if (UsingHardwareTimer) {
     if (!disableInterrupt()) {
       Paused = false;
       result = false;
     }else{
+#if PULSE_SENSOR_ADC_CHAIN
+      while (Converting) {
+        // let the ADC interrupt finish the sample it started.
+      }
+      SkippedSamples = 0;
+#endif
 			// DOING THIS HERE BECAUSE IT COULD GET CHOMPED IF WE DO IN resume() BELOW
 			for(int i=0; i<SensorCount; i++){
 				Sensors[i].resetVariables();
@@ -277,6 +947,18 @@ bool PulseSensorPlayground::pause() {
 
 bool PulseSensorPlayground::resume() {
   bool result = true;
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+  TimingHistogram.restart(); // the pause isn't jitter.
+#endif
+#if PULSE_SENSOR_TIMING_ANALYSIS
+  if (pTiming) {
+    pTiming->restart();
+  }
+#endif
+  if (pAcquisition) {
+    Paused = !pAcquisition->begin(Sensors, SensorCount, SampleIntervalMicros);
+    return !Paused;
+  }
 	if (UsingHardwareTimer) {
     if (!enableInterrupt()) {
       Paused = true;
@@ -344,52 +1026,56 @@ bool PulseSensorPlayground::setupInterrupt(){
   // This code sets up the sample timer interrupt
   // based on the type of Arduino platform.
 
+  #if defined(ARDUINO_ARCH_AVR)
+    unsigned long top;    // timer count for one sample interval, minus 1
+    byte clockSelect;     // the timer's prescaler (CS) bits, or 0 if none fits
+  #endif
+
   #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega16U4__)
 
     // check to see if the Servo library is in use
     #if __has_include (<Servo.h>)
-      // Initializes Timer2 to throw an interrupt every 2mS
-      // Interferes with PWM on pins 3 and 11
             #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
-          TCCR2A = 0x02;          // Disable PWM and go into CTC mode
-          TCCR2B = 0x05;          // don't force compare, 128 prescaler
-          #if F_CPU == 16000000L   // if using 16MHz crystal
-            OCR2A = 0XF9;         // set count to 249 for 2mS interrupt
-          #elif F_CPU == 8000000L // if using 8MHz crystal
-            OCR2A = 0X7C;         // set count to 124 for 2mS interrupt
-          #endif
-          TIMSK2 = 0x02;          // Enable OCR2A match interrupt DISABLE BY SETTING TO 0x00
-          ENABLE_PULSE_SENSOR_INTERRUPTS;
-          // #define _useTimer2
-          result = true;
+          // Initializes Timer2 to throw an interrupt every sample interval
+          // Interferes with PWM on pins 3 and 11
+          clockSelect = findTimerPrescale(SampleIntervalMicros,
+            TIMER2_PRESCALE_SHIFTS, sizeof(TIMER2_PRESCALE_SHIFTS), 256, top);
+          if (clockSelect) {
+            TCCR2A = 0x02;          // Disable PWM and go into CTC mode
+            TCCR2B = clockSelect;   // don't force compare, set prescaler
+            OCR2A = top;            // set count for one sample interval
+            TIMSK2 = 0x02;          // Enable OCR2A match interrupt DISABLE BY SETTING TO 0x00
+            ENABLE_PULSE_SENSOR_INTERRUPTS;
+            // #define _useTimer2
+            result = true;
+          }
             #elif defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega16U4__)
-                TCCR3A = 0x02;          // Disable PWM and go into CTC mode
-                TCCR3B = 0x05;          // don't force compare, 128 prescaler
-                #if F_CPU == 16000000L   // if using 16MHz crystal
-                    OCR3A = 0XF9;         // set count to 249 for 2mS interrupt
-                #elif F_CPU == 8000000L // if using 8MHz crystal
-                    OCR3A = 0X7C;         // set count to 124 for 2mS interrupt
-                #endif
-                TIMSK3 = 0x02;          // Enable OCR2A match interrupt DISABLE BY SETTING TO 0x00
-                ENABLE_PULSE_SENSOR_INTERRUPTS;
-                // #define _useTimer2
-                result = true;
+                // Initializes Timer3 to throw an interrupt every sample interval
+                clockSelect = findTimerPrescale(SampleIntervalMicros,
+                  TIMER16_PRESCALE_SHIFTS, sizeof(TIMER16_PRESCALE_SHIFTS), 65536UL, top);
+                if (clockSelect) {
+                    TCCR3A = 0x00;          // Disable PWM
+                    TCCR3B = 0x08 | clockSelect; // go into CTC mode, set prescaler
+                    OCR3A = top;            // set count for one sample interval
+                    TIMSK3 = 0x02;          // Enable OCR3A match interrupt DISABLE BY SETTING TO 0x00
+                    ENABLE_PULSE_SENSOR_INTERRUPTS;
+                    result = true;
+                }
             #endif
     #else
-      // Initializes Timer1 to throw an interrupt every 2mS.
+      // Initializes Timer1 to throw an interrupt every sample interval.
       // Interferes with PWM on pins 9 and 10
-      TCCR1A = 0x00;            // Disable PWM and go into CTC mode
-      TCCR1C = 0x00;            // don't force compare
-      #if F_CPU == 16000000L    // if using 16MHz crystal
-        TCCR1B = 0x0C;          // prescaler 256
-        OCR1A = 0x007C;         // count to 124 for 2mS interrupt
-      #elif F_CPU == 8000000L   // if using 8MHz crystal
-        TCCR1B = 0x0B;          // prescaler = 64
-        OCR1A = 0x00F9;         // count to 249 for 2mS interrupt
-      #endif
-      TIMSK1 = 0x02;            // Enable OCR1A match interrupt DISABLE BY SETTING TO 0x00
-      ENABLE_PULSE_SENSOR_INTERRUPTS;
-      result = true;
+      clockSelect = findTimerPrescale(SampleIntervalMicros,
+        TIMER16_PRESCALE_SHIFTS, sizeof(TIMER16_PRESCALE_SHIFTS), 65536UL, top);
+      if (clockSelect) {
+        TCCR1A = 0x00;            // Disable PWM and go into CTC mode
+        TCCR1C = 0x00;            // don't force compare
+        TCCR1B = 0x08 | clockSelect; // CTC mode, set prescaler
+        OCR1A = top;              // set count for one sample interval
+        TIMSK1 = 0x02;            // Enable OCR1A match interrupt DISABLE BY SETTING TO 0x00
+        ENABLE_PULSE_SENSOR_INTERRUPTS;
+        result = true;
+      }
     #endif
   #endif
 
@@ -397,53 +1083,50 @@ bool PulseSensorPlayground::setupInterrupt(){
 
     // check to see if the Servo library is in use
     #if __has_include (<Servo.h>) 
-        // Initializes Timer1 to throw an interrupt every 2mS.
+        // Initializes Timer1 to throw an interrupt every sample interval.
         // Interferes with PWM on pins 9 and 10
-        TCCR1A = 0x00;            // Disable PWM and go into CTC mode
-        TCCR1C = 0x00;            // don't force compare
-        #if F_CPU == 16000000L    // if using 16MHz crystal
-            TCCR1B = 0x0C;          // prescaler 256
-            OCR1A = 0x007C;         // count to 124 for 2mS interrupt
-        #elif F_CPU == 8000000L   // if using 8MHz crystal
-            TCCR1B = 0x0B;          // prescaler = 64
-            OCR1A = 0x00F9;         // count to 249 for 2mS interrupt
-        #endif
-        TIMSK1 = 0x02;            // Enable OCR1A match interrupt
-        ENABLE_PULSE_SENSOR_INTERRUPTS;
-        result = true;
+        clockSelect = findTimerPrescale(SampleIntervalMicros,
+          TIMER16_PRESCALE_SHIFTS, sizeof(TIMER16_PRESCALE_SHIFTS), 65536UL, top);
+        if (clockSelect) {
+            TCCR1A = 0x00;            // Disable PWM and go into CTC mode
+            TCCR1C = 0x00;            // don't force compare
+            TCCR1B = 0x08 | clockSelect; // CTC mode, set prescaler
+            OCR1A = top;              // set count for one sample interval
+            TIMSK1 = 0x02;            // Enable OCR1A match interrupt
+            ENABLE_PULSE_SENSOR_INTERRUPTS;
+            result = true;
+        }
 
     #else
-        // Initializes Timer2 to throw an interrupt every 2mS
+        // Initializes Timer2 to throw an interrupt every sample interval
         // Interferes with PWM on pins 3 and 11
+        clockSelect = findTimerPrescale(SampleIntervalMicros,
+          TIMER2_PRESCALE_SHIFTS, sizeof(TIMER2_PRESCALE_SHIFTS), 256, top);
+        if (clockSelect) {
             TCCR2A = 0x02;          // Disable PWM and go into CTC mode
-            TCCR2B = 0x05;          // don't force compare, 128 prescaler
-            #if F_CPU == 16000000L   // if using 16MHz crystal
-                OCR2A = 0XF9;         // set count to 249 for 2mS interrupt
-            #elif F_CPU == 8000000L // if using 8MHz crystal
-                OCR2A = 0X7C;         // set count to 124 for 2mS interrupt
-            #endif
+            TCCR2B = clockSelect;   // don't force compare, set prescaler
+            OCR2A = top;            // set count for one sample interval
             TIMSK2 = 0x02;          // Enable OCR2A match interrupt
             ENABLE_PULSE_SENSOR_INTERRUPTS;
             // #define _useTimer2
             result = true;
+        }
 
     #endif
  #endif
 
   #if defined(__AVR_ATtiny85__)
-    GTCCR = 0x00;     // Disable PWM, don't connect pins to events
-        OCR1A = 0x7D;           // Set top of count to 125. Timer match throws the interrupt
-    OCR1C = 0x7D;     // Set top of the count to 125. Timer match resets the counter
-    #if F_CPU == 16000000L
-      TCCR1 = 0x89;      // Clear Timer on Compare, Set Prescaler to 256
-    #elif F_CPU == 8000000L
-      TCCR1 = 0x88;      // Clear Timer on Compare, Set Prescaler to 128
-        #elif F_CPU == 1000000L
-            TCCR1 = 0x85            // Clear Timer on Compare, Set Prescaler to 16
-    #endif
-    bitSet(TIMSK,6);   // Enable interrupt on match between TCNT1 and OCR1A
-    ENABLE_PULSE_SENSOR_INTERRUPTS;
-    result = true;
+    clockSelect = findTimerPrescale(SampleIntervalMicros,
+      TINY_TIMER1_PRESCALE_SHIFTS, sizeof(TINY_TIMER1_PRESCALE_SHIFTS), 256, top);
+    if (clockSelect) {
+      GTCCR = 0x00;     // Disable PWM, don't connect pins to events
+      OCR1A = top;      // Set top of count. Timer match throws the interrupt
+      OCR1C = top;      // Set top of the count. Timer match resets the counter
+      TCCR1 = 0x80 | clockSelect; // Clear Timer on Compare, set prescaler
+      bitSet(TIMSK,6);   // Enable interrupt on match between TCNT1 and OCR1A
+      ENABLE_PULSE_SENSOR_INTERRUPTS;
+      result = true;
+    }
   #endif
 
   #if defined(ARDUINO_ARCH_RENESAS)
@@ -453,7 +1136,7 @@ bool PulseSensorPlayground::setupInterrupt(){
         FspTimer::force_use_of_pwm_reserved_timer();
         tindex = FspTimer::get_available_timer(timer_type);  
     }
-    sampleTimer.begin(TIMER_MODE_PERIODIC, timer_type, tindex, SAMPLE_RATE_500HZ, 0.0f, sampleTimerISR);
+    sampleTimer.begin(TIMER_MODE_PERIODIC, timer_type, tindex, 1000000.0f / SampleIntervalMicros, 0.0f, sampleTimerISR);
     sampleTimer.setup_overflow_irq();
     sampleTimer.open();
     sampleTimer.start();
@@ -462,7 +1145,7 @@ bool PulseSensorPlayground::setupInterrupt(){
 
   #if defined(ARDUINO_SAM_DUE)
     sampleTimer.attachInterrupt(sampleTimer_ISR);
-    sampleTimer.start(2000); // Calls every period microseconds
+    sampleTimer.start(SampleIntervalMicros); // Calls every period microseconds
     result = true;
   #endif
 
@@ -471,7 +1154,7 @@ bool PulseSensorPlayground::setupInterrupt(){
      *  Use pause() and resume() to start and stop sampling on the fly
      *  Check Resources folder in the library for more tools
      */
-    sampleTimer.attachInterruptInterval(SAMPLE_INTERVAL_US, sampleTimer_ISR);
+    sampleTimer.attachInterruptInterval(SampleIntervalMicros, sampleTimer_ISR);
     result = true;
   #endif
 
@@ -480,29 +1163,29 @@ bool PulseSensorPlayground::setupInterrupt(){
      *  Use pause() and resume() to start and stop sampling on the fly
      *  Check Resources folder in the library for more tools
      */
-    sampleTimer.attachInterruptInterval(TIMER3_INTERVAL_US, Timer3_ISR);
+    sampleTimer.attachInterruptInterval(SampleIntervalMicros, Timer3_ISR);
     result = true;
   #endif
 
   #if defined(ARDUINO_ARCH_ESP32)
     /*
         This will set up and start the timer interrupt on ESP32.
-        The interrupt will occur every 2000uS or 500Hz.
+        The interrupt will occur every SampleIntervalMicros (2000uS, 500Hz, by default).
     */
     sampleTimer = timerBegin(1000000); // 1MHz ticker, 1uS tick period                
     timerAttachInterrupt(sampleTimer, &onInterrupt);  
-    timerAlarm(sampleTimer, 2000, true, 0);    
+    timerAlarm(sampleTimer, SampleIntervalMicros, true, 0);    
     result = true;
   #endif
 
   #if defined(ARDUINO_ARCH_ESP8266)
         ESP8266Timer sampleTimer;
-    sampleTimer.setFrequency(500,onInterrupt);
+    sampleTimer.setInterval(SampleIntervalMicros,onInterrupt);
     sampleTimer.restartTimer();
   #endif
 
   #if defined(ARDUINO_SAMD_ZERO) || defined(ARDUINO_ARCH_SAMD)
-    sampleTimer.attachInterrupt(SAMPLE_RATE_500HZ, onInterrupt);
+    sampleTimer.attachInterruptInterval(SampleIntervalMicros, onInterrupt);
     result = true;
   #endif
 
@@ -586,7 +1269,7 @@ bool PulseSensorPlayground::enableInterrupt(){
   #endif
 
   #if defined(ARDUINO_ARCH_SAM)
-    sampleTimer.start(2000);
+    sampleTimer.start(SampleIntervalMicros);
     result = true;
   #endif
 
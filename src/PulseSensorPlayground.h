@@ -42,18 +42,28 @@
    Uncomment the line below: #define PULSE_SENSOR_TIMING_ANALYSIS true
    Compile and download your Sketch.
    Start the Arduino IDE Serial Monitor.
-   Wait about 30 seconds. The Sketch should then print 3 numbers and hang.
-   The three numbers are:
-     Minimum variation (microseconds) from the 2 millisecond sample time.
+   Every 30 seconds or so, the Sketch prints a line of 8 numbers,
+   for all the samples since it started:
+     Minimum variation (microseconds) from the sample time
+       (2 milliseconds, at the default 500 samples per second).
      Average variation in that number.
      Maximum variation in that number.
-   For example and output of -4 0 18 says that samples were made between
-   4 microseconds short of 2 milliseconds, and 18 microseconds longer,
-   with an average sample time right at 2 milliseconds (0 microseconds offset).
+     Standard deviation of that number.
+     Variation (either way) that half the samples were within.
+     Variation that 95% of the samples were within.
+     Variation that 99% of the samples were within.
+     Number of samples measured.
+   For example an output of -4 0 18 2 1 5 11 14999 says that samples were
+   made between 4 microseconds short of 2 milliseconds, and 18 microseconds
+   longer, with an average sample time right at 2 milliseconds
+   (0 microseconds offset), and that 99 samples in 100 were within
+   11 microseconds of 2 milliseconds.
+   The percentiles are rounded up, to within 25%.
 
    If the average number is larger than, say, 50 microseconds, your Sketch
    is taking too much time per loop(), causing inaccuracies in the
    measured signal, heart rate, and inter-beat interval.
+   If the 99% number is large, something in your Sketch is occasionally slow.
 
    You should aim for an average offset of under 50 microseconds.
 
@@ -104,6 +114,56 @@
 #define PULSE_SENSOR_MEMORY_USAGE false
 //#define PULSE_SENSOR_MEMORY_USAGE true
 
+/*
+   The Playground keeps histograms of sample timing jitter, of the time
+   spent reading and processing each sample, and of the time spent
+   reading alone, in both interrupt and non-interrupt Sketches.
+   See getTimingHistogram().
+   They cost about 220 bytes of RAM and three micros() calls per sample,
+   so they're off on AVR parts with 2K of RAM or less (Uno, Nano, ATtiny).
+
+   To change that, change the lines below to: #define PULSE_SENSOR_TIMING_HISTOGRAMS true (or false)
+*/
+#ifndef PULSE_SENSOR_TIMING_HISTOGRAMS
+#if defined(ARDUINO_ARCH_AVR) && defined(RAMEND) && RAMEND < 0x900
+#define PULSE_SENSOR_TIMING_HISTOGRAMS false
+#else
+#define PULSE_SENSOR_TIMING_HISTOGRAMS true
+#endif
+#endif
+
+/*
+   On AVR boards (Uno, Nano, Leonardo, Mega), analogRead() waits about
+   110 microseconds for each conversion, with interrupts off in the
+   sample timer's interrupt: 450 of every 2000 microseconds with 4
+   PulseSensors. To stop waiting, change the line below to:
+   #define PULSE_SENSOR_ADC_INTERRUPTS true
+
+   Then the sample timer only starts the first conversion. The ADC's
+   conversion complete interrupt stores each reading and starts the
+   next, and once every PulseSensor is read, looks for beats with
+   interrupts on, so millis(), Serial and the Sketch run meanwhile.
+   The Sketch must not call analogRead() while the Playground is
+   sampling; pause() first, and resume() afterwards.
+   A timer tick that arrives before the last sample is processed
+   starts the next sample as soon as it is; any more are skipped, the
+   beat finder's clock is moved on by them, and getSampleOverruns()
+   counts them.
+   Other boards, and the ATtiny85, use analogRead() either way.
+*/
+#ifndef PULSE_SENSOR_ADC_INTERRUPTS
+#define PULSE_SENSOR_ADC_INTERRUPTS false
+#endif
+
+#if PULSE_SENSOR_ADC_INTERRUPTS && USE_HARDWARE_TIMER \
+  && (defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) \
+  || defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega16U4__) \
+  || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__))
+#define PULSE_SENSOR_ADC_CHAIN true
+#else
+#define PULSE_SENSOR_ADC_CHAIN false
+#endif
+
 /*
     Tell the compiler not to include Serial related code.
     If you are coming up against issues with the Serial class,
@@ -125,21 +185,54 @@
 #endif
 #include <Arduino.h>
 #include "utility/PulseSensor.h"
+#include "utility/PulseSensorBuffer.h"
+#include "utility/PulseSensorChannels.h"
+#include "utility/PulseSensorRecorder.h"
+#include "utility/PulseSensorSampleEncoder.h"
+#include "utility/PulseSensorTransitTime.h"
+#include "utility/PulseSensorHRV.h"
+#include "utility/PulseSensorFilter.h"
+#include "utility/PulseSensorAcquisition.h"
 #if USE_SERIAL
 #include "utility/PulseSensorSerialOutput.h"
 #endif
 #include "utility/PulseSensorTimingStatistics.h"
+#include "utility/PulseSensorTimingHistogram.h"
 
+/*
+   Sample rates (samples per second) for setSampleRate().
+   Other rates work too; these are the ones we test.
+*/
+#define SAMPLE_RATE_100HZ 100
+#define SAMPLE_RATE_250HZ 250
 #define SAMPLE_RATE_500HZ 500
+#define SAMPLE_RATE_1000HZ 1000
 #define SAMPLES_PER_SERIAL_SAMPLE 10
 
+/*
+   A Sketch function to call on a beat event. See onBeatStart().
+   event = the beat's time, inter-beat interval, amplitude and PulseSensor.
+   context = the pointer given to onBeatStart(), for the Sketch's own use.
+*/
+typedef void (*PulseSensorBeatCallback)(const BeatEvent &event, void *context);
+
+/*
+   A beat event waiting for dispatchBeatEvents(). The Sketch provides
+   an array of them with setEventQueue(); each costs 17 bytes of RAM on an Uno.
+*/
+struct PendingBeatEvent {
+  BeatEvent beat;
+  byte found;   // the FOUND_* flag whose callback to call.
+};
+
 
 
 class PulseSensorPlayground {
   public:
     /*
-       The number of microseconds per sample of data from the PulseSensor.
+       The default number of microseconds per sample of data from the PulseSensor.
        1 millisecond is 1,000 microseconds.
+       Change it with setSampleRate(); read it with getSampleIntervalMicros().
 
        Refer to this value as PulseSensorPlayground::MICROS_PER_READ
     */
@@ -157,6 +250,8 @@ class PulseSensorPlayground {
          PulseSensorPlayground pulse();
        or
          PulseSensorPlayground pulse(2); // for 2 PulseSensors.
+
+       To save RAM and flash on small Arduinos, see PulseSensorPlaygroundT.
     */
     PulseSensorPlayground(int numberOfSensors = 1);
 
@@ -185,6 +280,71 @@ vvvvvvvv  THIS NEEDS MODIFICATION FOR V2 vvvvvvvv
     */
     bool sawNewSample();
 
+    /*
+       By default, the Playground reads each PulseSensor 500 times a second.
+
+       If you wish to sample more slowly, to save power,
+       or faster, for finer timing (for example Pulse Transit Time),
+       call pulse.setSampleRate(samplesPerSecond) before calling begin().
+       SAMPLE_RATE_100HZ, SAMPLE_RATE_250HZ, SAMPLE_RATE_500HZ and
+       SAMPLE_RATE_1000HZ are provided for convenience.
+
+       Sample timing is kept in microseconds, so the rate needn't divide
+       evenly into milliseconds. A hardware timer runs as close
+       to the rate as it can; AVR timers may be off by a fraction of a percent.
+
+       Returns false, and changes nothing, if samplesPerSecond is 0
+       or faster than 10000, or too fast for a PulseSensorFilter
+       given to setFilter() (see utility/PulseSensorFilter.h).
+    */
+    bool setSampleRate(unsigned int samplesPerSecond);
+
+    /*
+       Returns the sample rate, in samples per second.
+    */
+    unsigned int getSampleRate();
+
+    /*
+       Returns the time between samples, in microseconds.
+    */
+    unsigned long getSampleIntervalMicros();
+
+    /*
+       By default, the Playground reads each PulseSensor once a sample.
+       To lower ADC noise, have it read each one ratio times in a row
+       and average them: 2, 4, 8 or 16 times (1 to stop). Each doubling
+       halves the noise power, and 4 or 16 times give getOversampledSample()
+       one or two more bits. The beat finder still sees 0..1023.
+
+       Every reading takes time in the sample interrupt (about 110
+       microseconds each on an AVR board, much less on most 32-bit
+       boards), so check the acquisition times in getTimingHistogram():
+       readings for every PulseSensor must fit well within the sample
+       interval (2000 microseconds at 500 samples per second).
+       Call this before begin().
+
+       Returns false, and changes nothing, if ratio isn't 1, 2, 4, 8 or 16,
+       or isn't 1 with a setAcquisition(), which reads once a sample.
+    */
+    bool setOversampling(byte ratio);
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    /*
+       The Playground reads its PulseSensors one after another, so each
+       is read a little later than the one before (see
+       getAcquisitionOffsetMicros()): about 110 microseconds per reading
+       on an AVR board. Beats on a later PulseSensor are then found that
+       much late, which adds to a Pulse Transit Time between them.
+
+       Call setSkewCompensation(true) to have the Playground move each
+       later PulseSensor's samples back to when the first one was read,
+       by interpolating between each sample and the one before, before
+       looking for beats. getLatestSample() still returns the sample as read.
+       It costs a multiply per PulseSensor per sample.
+    */
+    void setSkewCompensation(bool compensate);
+#endif
+
     //---------- Per-PulseSensor functions
 
     /*
@@ -227,6 +387,26 @@ vvvvvvvv  THIS NEEDS MODIFICATION FOR V2 vvvvvvvv
     */
     void fadeOnPulse(int fadePin, int sensorIndex = 0);
 
+    /*
+       By default, the blink and fade LEDs are updated by the sample
+       Interrupt Service Routine, right after each sample is processed.
+
+       To keep the ISR as short as possible, call pulse.deferLEDUpdates(true).
+       The LEDs are then updated each time sawNewSample() returns true,
+       or when your Sketch calls pulse.updateLEDs().
+       Your Sketch must call one of these often (every few milliseconds)
+       or the LEDs will lag the heartbeat.
+
+       Either way, an LED pin is written only when the LED changes.
+    */
+    void deferLEDUpdates(bool defer);
+
+    /*
+       Update the blink and fade LEDs of every PulseSensor.
+       Only needed after deferLEDUpdates(true).
+    */
+    void updateLEDs();
+
     /*
        Perform all the processing necessary when it's time to
        read from all the PulseSensors and process their signals.
@@ -235,6 +415,22 @@ vvvvvvvv  THIS NEEDS MODIFICATION FOR V2 vvvvvvvv
     */
     void onSampleTime();
 
+#if PULSE_SENSOR_ADC_CHAIN
+    /*
+       (internal to the library) Store an ADC reading and start the next
+       conversion, or, after the last, process the sample.
+       Called by the ADC interrupt. See PULSE_SENSOR_ADC_INTERRUPTS.
+    */
+    void onConversionComplete(int reading);
+#endif
+
+    /*
+       Returns how many samples the sample timer has skipped since
+       begin() because the one before was still being read or processed.
+       Only PULSE_SENSOR_ADC_INTERRUPTS samples this way; otherwise 0.
+    */
+    unsigned long getSampleOverruns();
+
     /*
        Returns the most recently read analog value from the given PulseSensor
        (range: 0..1023).
@@ -243,6 +439,29 @@ vvvvvvvv  THIS NEEDS MODIFICATION FOR V2 vvvvvvvv
     */
     int getLatestSample(int sensorIndex = 0);
 
+    /*
+       Returns the most recently read value from the given PulseSensor,
+       with the extra resolution of oversampling: 0..2047 at 4 or 8 times,
+       0..4095 at 16 times, otherwise the same as getLatestSample().
+       See setOversampling().
+
+       sensorIndex = optional, index (0..numberOfSensors - 1).
+    */
+    int getOversampledSample(int sensorIndex = 0);
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    /*
+       Returns when the given PulseSensor's latest sample was read, in
+       microseconds after the Playground started reading the first
+       PulseSensor that sample: the middle of its readings, or with a
+       PulseSensorAcquisition, of its conversions. Subtract two PulseSensors'
+       offsets for the skew between them. See setSkewCompensation().
+
+       sensorIndex = optional, index (0..numberOfSensors - 1).
+    */
+    word getAcquisitionOffsetMicros(int sensorIndex = 0);
+#endif
+
     /*
        Returns the latest beats-per-minute measure for the given PulseSensor.
 
@@ -303,6 +522,229 @@ vvvvvvvv  THIS NEEDS MODIFICATION FOR V2 vvvvvvvv
     */
     void setThreshold(int threshold, int sensorIndex = 0);
 
+    /*
+       Find the beats in a recording of all the PulseSensors, much faster
+       than real time. Use this to process recorded data instead of
+       sampling: either don't call begin(), or call pause() first.
+
+       samples = the recording, one frame per sample period, oldest first.
+         A frame is one sample from each PulseSensor, in sensor index order,
+         so samples holds frameCount * numberOfSensors values.
+       frameCount = the number of frames in samples.
+       out = where to store the beats found, in time order. May be NULL.
+         Each BeatEvent's sampleIndex is its frame number in samples,
+         and its sensorIndex says which PulseSensor found it.
+       outCap = the number of BeatEvents out has room for.
+
+       Returns the number of beats found. If that's more than outCap,
+       only the first outCap beats are stored.
+       Calling this again continues where the previous recording left off.
+    */
+    size_t processBlock(const int16_t *samples, size_t frameCount,
+      BeatEvent *out, size_t outCap);
+
+    /*
+       By default, the Playground keeps only the latest sample and beat,
+       so a loop() that takes longer than 2 milliseconds misses samples,
+       and one that takes longer than a heartbeat misses beats.
+
+       If you wish to read every sample and beat, give the Playground
+       a PulseSensorBuffer (see utility/PulseSensorBuffer.h) to fill,
+       then read from it with readSamples() and readBeats().
+       Call this before begin().
+
+       buffer = the PulseSensorBuffer to fill.
+       sensorIndex = optional, index (0..numberOfSensors - 1).
+
+       Returns false if the buffer's storage sizes aren't usable.
+    */
+    bool setBuffer(PulseSensorBuffer &buffer, int sensorIndex = 0);
+
+    /*
+       Copy up to n of the oldest buffered samples into buf,
+       oldest first, and remove them from the buffer.
+       Returns the number of samples copied, or 0 if there's no buffer.
+
+       sensorIndex = optional, index (0..numberOfSensors - 1).
+    */
+    int readSamples(int16_t *buf, int n, int sensorIndex = 0);
+
+    /*
+       Copy up to n of the oldest buffered beats into buf,
+       oldest first, and remove them from the buffer.
+       Returns the number of beats copied, or 0 if there's no buffer.
+
+       sensorIndex = optional, index (0..numberOfSensors - 1).
+    */
+    int readBeats(BeatEvent *buf, int n, int sensorIndex = 0);
+
+    /*
+       Returns the number of samples, or beats, that were dropped
+       because the buffer was full: the Sketch didn't read them in time.
+
+       sensorIndex = optional, index (0..numberOfSensors - 1).
+    */
+    unsigned long getSampleOverruns(int sensorIndex = 0);
+    unsigned long getBeatOverruns(int sensorIndex = 0);
+
+    /*
+       Measure heart rate variability (RMSSD, SDNN and pNN50) over the
+       latest IBIs of a PulseSensor, beat by beat, in a PulseSensorHRV
+       (see utility/PulseSensorHRV.h) that holds the window of IBIs.
+       Call this before begin().
+
+       hrv = the PulseSensorHRV to give each IBI found.
+       sensorIndex = optional, index (0..numberOfSensors - 1).
+
+       Returns false if the PulseSensorHRV's storage isn't usable.
+    */
+    bool setHRV(PulseSensorHRV &hrv, int sensorIndex = 0);
+
+    /*
+       Copy the heart rate variability measures of a PulseSensor into
+       metrics. Returns false, leaving metrics alone, if there's no
+       PulseSensorHRV or it doesn't yet hold two successive IBIs.
+
+       sensorIndex = optional, index (0..numberOfSensors - 1).
+    */
+    bool getHRV(HRVMetrics &metrics, int sensorIndex = 0);
+
+    /*
+       Band-pass filter a PulseSensor's samples before looking for beats
+       in them, with a PulseSensorFilter (see utility/PulseSensorFilter.h),
+       to ignore baseline wander and mains hum. getLatestSample() still
+       returns the unfiltered sample. Call this before begin().
+
+       filter = the PulseSensorFilter to use; one per PulseSensor.
+       sensorIndex = optional, index (0..numberOfSensors - 1).
+
+       Returns false, and changes nothing, if sensorIndex is out of range
+       or the filter can't work at the sample rate: by default, faster
+       than 2000 samples per second.
+    */
+    bool setFilter(PulseSensorFilter &filter, int sensorIndex = 0);
+
+    /*
+       Read every PulseSensor with the given PulseSensorAcquisition
+       (see utility/PulseSensorAcquisition.h), for example a PulseSensorDMA,
+       instead of the sample timer and analogRead(). sawNewSample() then
+       looks for beats a block of samples at a time, so call it at least
+       once a block, and use onBeatStart() (or setBuffer()) rather than
+       sawStartOfBeat() to see every beat. Call this before begin().
+       It turns setOversampling() off, and setOversampling() then refuses
+       any ratio but 1. getTimingHistogram() doesn't apply.
+    */
+    void setAcquisition(PulseSensorAcquisition &acquisition);
+
+    /*
+       By default, a Sketch finds beats by calling sawStartOfBeat()
+       in loop(), and misses a beat if loop() takes longer than a heartbeat.
+
+       If you wish, the Playground will instead call a function of your
+       Sketch's on every beat of every PulseSensor:
+         void beatStarted(const BeatEvent &beat, void *context) {
+           // beat.beatTime, beat.interBeatIntervalMs, beat.pulseAmplitude
+           // and beat.sensorIndex describe the beat.
+         }
+         ...
+         pulse.onBeatStart(beatStarted);
+
+       onBeatStart() sets the function to call when a beat starts;
+       onBeatEnd() when the signal falls back below the threshold
+       (isInsideBeat() becomes false), and onSignalLost() when there has
+       been no beat for 2.5 seconds. The BeatEvent's sampleIndex is the
+       number of samples taken since begin(). At the end of a beat its
+       pulseAmplitude is that beat's amplitude; after the signal is lost,
+       its beatsPerMinute is 0.
+
+       callback = the function to call, or NULL to stop calling one.
+       context = passed to callback as-is; for example, a pointer to
+         an object of the Sketch's. May be NULL.
+       inISR = false (the default) to call callback from sawNewSample(),
+         which the Sketch must then call often. The events wait in
+         the queue given to setEventQueue(); any that don't fit, or
+         come without one, are dropped and counted by getEventOverruns().
+         true to call callback straight away, within one sample period
+         of the beat, from the sample Interrupt Service Routine
+         if there is one. callback must then be short: no Serial output
+         or delay(), and any variable it shares with loop() must be volatile.
+
+       No memory is allocated.
+    */
+    void onBeatStart(PulseSensorBeatCallback callback, void *context = NULL,
+      bool inISR = false);
+    void onBeatEnd(PulseSensorBeatCallback callback, void *context = NULL,
+      bool inISR = false);
+    void onSignalLost(PulseSensorBeatCallback callback, void *context = NULL,
+      bool inISR = false);
+
+    /*
+       Give the Playground somewhere to keep the beat events waiting for
+       sawNewSample() (see onBeatStart()), sometime before calling pulse.begin():
+         PendingBeatEvent beatEvents[4];
+         ...
+         pulse.setEventQueue(beatEvents, 4);
+       Only Sketches that call back outside the ISR need one.
+
+       capacity = the number of events storage holds: 2, 4, 8, 16...,
+         at most 128.
+       storage = NULL to stop queuing.
+
+       Returns false, and changes nothing, if capacity won't do.
+    */
+    bool setEventQueue(PendingBeatEvent *storage, int capacity);
+
+    /*
+       Call the onBeatStart(), onBeatEnd() and onSignalLost() functions
+       (those not called from the ISR) for the events waiting, oldest first.
+       sawNewSample() calls this. A Sketch that doesn't call sawNewSample()
+       should call this often instead.
+    */
+    void dispatchBeatEvents();
+
+    /*
+       Returns the number of beat events dropped because they waited
+       too long for dispatchBeatEvents(), or had no queue to wait in.
+    */
+    unsigned long getEventOverruns();
+
+    /*
+       Measure Pulse Transit Time between two PulseSensors as the
+       Playground finds their beats, instead of comparing getLastBeatTime()
+       values in loop(). See utility/PulseSensorTransitTime.h.
+       Call this before begin(), once for each pair of PulseSensors:
+         PulseSensorTransitTime heartToFinger(0, 1);
+         ...
+         pulse.addTransitTime(heartToFinger);
+
+       Returns false if either PulseSensor index is out of range.
+    */
+    bool addTransitTime(PulseSensorTransitTime &transitTime);
+
+    /*
+       Returns the latest Pulse Transit Time, in microseconds, from
+       PulseSensor proximalIndex to PulseSensor distalIndex, or -1
+       if there hasn't been one, or that pair wasn't given to addTransitTime().
+    */
+    long getPulseTransitTimeMicros(int proximalIndex, int distalIndex);
+
+
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+    /*
+       Copy the sample timing histograms into histogram.
+       See PulseSensorTimingHistogram.h for what they hold.
+       Safe to call while the Playground is sampling.
+
+       reset = true to clear the counts once they're copied,
+         so the next copy holds only samples taken after this call.
+
+       For example, to print them once a minute:
+         PulseSensorTimingHistogram histogram;
+         pulse.getTimingHistogram(histogram, true);
+         histogram.outputHistogram(&Serial);
+    */
+    void getTimingHistogram(PulseSensorTimingHistogram &histogram, bool reset = false);
+#endif // PULSE_SENSOR_TIMING_HISTOGRAMS
 
     //---------- Serial Output functions
 #if USE_SERIAL
@@ -331,6 +773,12 @@ vvvvvvvv  THIS NEEDS MODIFICATION FOR V2 vvvvvvvv
        outputType = SERIAL_PLOTTER to output to the Arduino Serial Plotter,
        PROCESSSING_VISUALIZER to output formatted to our data visualization 
        software written in Processing. See www.pulsesensor.com for tutorials.
+       BINARY_STREAM to output every sample of up to 8 PulseSensors
+       in compact, checked binary frames, for a program on the other end
+       to decode. Beats passed to outputBeat() go out in the next frame.
+       COMPRESSED_STREAM to do the same in a third to a half of the bytes,
+       by sending the difference between samples.
+       See PulseSensorSerialOutput.h for the frame formats.
     */
     void setOutputType(byte outputType);
 
@@ -362,6 +810,43 @@ vvvvvvvv  THIS NEEDS MODIFICATION FOR V2 vvvvvvvv
        Used exclusively with the Pulse Sensor Processing sketch.
     */
     void outputToSerial(char symbol, int data);
+
+    /*
+       By default, output waits whenever the Serial port's transmit
+       buffer is full. At high sample rates, or with several PulseSensors,
+       that can hold up loop() and make sampling late.
+
+       If you'd rather lose some output than wait, give the Playground
+       a queue for it, sometime before calling pulse.begin():
+         byte outputQueue[128];
+         ...
+         pulse.setOutputQueue(outputQueue, sizeof(outputQueue));
+
+       Output then goes into the queue, and the queue is written
+       to the Serial port only as fast as the port can take it
+       without waiting (see availableForWrite() in the Arduino reference).
+       Each outputSample(), outputBeat() or outputToSerial() that
+       doesn't fit is dropped whole and counted by getOutputDrops().
+
+       The queue is written each time one of those functions is called;
+       call pulse.drainOutputQueue() to write it at other times.
+       The Serial port must support availableForWrite();
+       SoftwareSerial doesn't.
+
+       storage = NULL to stop queuing.
+    */
+    void setOutputQueue(byte *storage, int size);
+
+    /*
+       Returns the number of outputs dropped because the output queue was full.
+    */
+    unsigned long getOutputDrops();
+
+    /*
+       Write as much of the output queue as the Serial port
+       can take without waiting.
+    */
+    void drainOutputQueue();
 #else
     #warning "PulseSensor Playground internal Serial commands not used"
 #endif
@@ -375,12 +860,29 @@ vvvvvvvv  THIS NEEDS MODIFICATION FOR V2 vvvvvvvv
     int getPulseAmplitude(int sensorIndex = 0);
 
     /*
-       Returns the sample number when the last beat was found. 2mS resolution.
-       The sample number will count up continually.
-       As an unsigned long variable, it will roll-over in approx 100 days free running.
+       Returns the time (milliseconds of sampling) when the last beat was found.
+       The resolution is one sample period: 2mS at the default sample rate.
+       The time will count up continually.
+       As an unsigned long variable, it will roll-over in approx 50 days free running.
     */
     unsigned long getLastBeatTime(int sensorIndex = 0);
 
+    /*
+       Returns the time (microseconds of sampling) when the last beat was
+       found, and the inter-beat interval (microseconds) ending at that beat.
+       Like micros(), the time rolls over after about 71 minutes,
+       but the difference of two times is still right.
+
+       By default, these are getLastBeatTime() and getInterBeatIntervalMs()
+       times 1000, so they change in whole sample periods.
+       To find the time between samples that the signal crossed the
+       threshold, about ten times more finely, change the
+       PULSE_SENSOR_INTERPOLATE_BEATS line in utility/PulseSensor.h to true.
+       Use that to measure Pulse Transit Time to better than a sample period.
+    */
+    unsigned long getLastBeatTimeMicros(int sensorIndex = 0);
+    unsigned long getInterBeatIntervalMicros(int sensorIndex = 0);
+
     
 
 	/*
@@ -411,7 +913,97 @@ vvvvvvvv  THIS NEEDS MODIFICATION FOR V2 vvvvvvvv
     byte samplesUntilReport = SAMPLES_PER_SERIAL_SAMPLE;
     bool UsingHardwareTimer;
 
+  protected:
+    /*
+       (internal to the library) Manage the given array of PulseSensors
+       instead of allocating one. Used by PulseSensorPlaygroundT.
+       The array is not used until begin() or other calls.
+    */
+    PulseSensorPlayground(PulseSensor *sensors, int numberOfSensors);
+
+    volatile bool DeferLEDs;       // if true, the ISR leaves the LEDs to updateLEDs().
+
+    /*
+       (internal to the library) Read and process a sample from every
+       PulseSensor, and update the LEDs. Called by onSampleTime().
+       This and processSamples() are virtual so the ISR runs
+       PulseSensorPlaygroundT's loops. That costs every Playground a
+       vtable pointer, and on AVR each class's vtable sits in RAM too:
+       about 10 bytes of RAM for a PulseSensorPlayground, 18 for a
+       PulseSensorPlaygroundT<N> (whose base class has one as well).
+    */
+    virtual void sampleSensors();
+
+    /*
+       (internal to the library) Process the sample just read from every
+       PulseSensor, and update the LEDs. Called by sampleSensors().
+    */
+    virtual void processSamples();
+
+    /*
+       (internal to the library) Read the given PulseSensor, number
+       sensorIndex in the order sampleSensors() reads them, and note when.
+    */
+    void readSensor(PulseSensor &sensor, int sensorIndex) {
+#if PULSE_SENSOR_ACQUISITION_TIMES
+      if (sensorIndex == 0) {
+        FirstReadMicros = micros();
+        ReadMicros = FirstReadMicros;
+      }
+#endif
+      sensor.readNextSample();
+#if PULSE_SENSOR_ACQUISITION_TIMES
+      unsigned long endMicros = micros();
+      setAcquisitionOffset(sensorIndex,
+        (word) ((ReadMicros - FirstReadMicros) + (endMicros - ReadMicros) / 2));
+      ReadMicros = endMicros;
+#else
+      (void) sensorIndex; // only needed to note when.
+#endif
+    }
+
+    volatile byte CallbackEvents;  // the FOUND_* flags handleBeatEvents() is needed for.
+    volatile unsigned long SampleCount; // samples taken since begin().
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+    unsigned long AcquiredMicros;   // micros() once sampleSensors() has read every PulseSensor.
+#endif
+
+    /*
+       (internal to the library) Call, or queue for dispatchBeatEvents(),
+       the callbacks for the FOUND_* flags the given PulseSensor just returned,
+       and pass its beats to the PulseSensorTransitTimes.
+       Called by sampleSensors() if (found & CallbackEvents) != 0.
+    */
+    void handleBeatEvents(int sensorIndex, byte found);
+
+    /*
+       (internal to the library) Look for beats in every block the
+       PulseSensorAcquisition has filled, a frame at a time.
+       Returns true if there were any. Called by sawNewSample().
+    */
+    bool processAcquiredBlocks();
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    /*
+       (internal to the library) Note that the given PulseSensor's latest
+       sample was read offsetMicros into the sample, with the skew to make
+       up for if setSkewCompensation() is on. Call for PulseSensor 0 first.
+    */
+    void setAcquisitionOffset(int sensorIndex, word offsetMicros);
+#endif
+
   private:
+    // Set the starting values shared by the constructors.
+    void initializeVariables();
+
+    // Set the callback for one FOUND_* flag. See onBeatStart().
+    void setBeatCallback(byte flag, PulseSensorBeatCallback callback,
+      void *context, bool inISR);
+
+#if PULSE_SENSOR_ADC_CHAIN
+    // Start the ADC converting PulseSensor 0 for a new sample.
+    void startSample();
+#endif
 
 /*
    Optionally use this (or a different) pin to toggle high
@@ -450,16 +1042,51 @@ bool enableInterrupt();
 	bool Paused;                // keeps track of whether the algorithm is running
     byte SensorCount;              // number of PulseSensors in Sensors[].
     PulseSensor *Sensors;          // use Sensors[idx] to access a sensor.
+    unsigned long SampleIntervalMicros; // time between samples. See setSampleRate().
     volatile unsigned long NextSampleMicros; // Desired time to sample next.
     volatile bool SawNewSample; // "A sample has arrived from the ISR"
+#if PULSE_SENSOR_ADC_CHAIN
+    volatile bool Converting;      // a sample is being read or processed by the ADC interrupt.
+    volatile bool SampleDue;       // a timer tick came while Converting; start it when done.
+    volatile byte SkippedSamples;  // timer ticks since skipped, not yet added to the clocks.
+    volatile unsigned long SampleOverruns; // see getSampleOverruns().
+    byte ConvertingSensor;         // the PulseSensor being read.
+    byte ConversionsLeft;          // readings still to take of it.
+    word ConversionSum;            // the sum of its readings so far.
+#if PULSE_SENSOR_TIMING_HISTOGRAMS || PULSE_SENSOR_ACQUISITION_TIMES
+    unsigned long SampleStartMicros; // micros() when the sample timer started the conversions.
+#endif
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    unsigned long SensorStartMicros; // micros() when ConvertingSensor's first conversion started.
+#endif
+#endif // PULSE_SENSOR_ADC_CHAIN
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    volatile bool CompensateSkew;  // see setSkewCompensation().
+    word FirstOffsetMicros;        // PulseSensor 0's acquisition offset this sample.
+    unsigned long FirstReadMicros; // micros() when readSensor() started on PulseSensor 0.
+    unsigned long ReadMicros;      // micros() when readSensor() last finished a read.
+#endif
 #if USE_SERIAL
     PulseSensorSerialOutput SerialOutput; // Serial Output manager.
 #endif // USE_SERIAL
+    // Beat callbacks, in FOUND_* flag order: beat start, beat end, signal lost.
+    PulseSensorBeatCallback BeatCallbacks[3];
+    void *BeatCallbackContexts[3];
+    byte CallbackFlags;            // the FOUND_* flags that have a callback.
+    byte CallbackInISR;            // the FOUND_* flags whose callback the ISR calls.
+    PulseSensorTransitTime *pTransitTimes; // list of those given to addTransitTime(), or NULL.
+    PulseSensorAcquisition *pAcquisition; // reads the PulseSensors instead of the timer, or NULL.
+    PulseSensorRing<PendingBeatEvent> EventQueue; // events waiting for dispatchBeatEvents().
+    volatile unsigned long EventOverruns; // see getEventOverruns().
 #if PULSE_SENSOR_TIMING_ANALYSIS   // Don't use ram and flash we don't need.
     PulseSensorTimingStatistics *pTiming;
 #endif // PULSE_SENSOR_TIMING_ANALYSIS
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+    PulseSensorTimingHistogram TimingHistogram; // written by onSampleTime().
+#endif // PULSE_SENSOR_TIMING_HISTOGRAMS
 
 };
 
+#include "PulseSensorPlaygroundT.h"
 
 #endif // PULSE_SENSOR_PLAYGROUND_H
@@ -0,0 +1,171 @@
+/*
+   A PulseSensor Playground for a number of PulseSensors
+   fixed when the Sketch is compiled.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_PLAYGROUND_T_H
+#define PULSE_SENSOR_PLAYGROUND_T_H
+
+#include "PulseSensorPlayground.h"
+
+/*
+   PulseSensorPlaygroundT<N> works like PulseSensorPlayground(N),
+   but its PulseSensors are part of the object instead of allocated
+   from the heap, and the sample ISR loops over a count the compiler knows.
+   On an ATtiny85 or Uno this saves the RAM and flash of the heap,
+   and shortens the ISR.
+
+   For example:
+     PulseSensorPlaygroundT<2> pulse;  // for 2 PulseSensors.
+
+   Every PulseSensorPlayground function works as usual. In addition,
+   each per-PulseSensor function can take the sensor index as a template
+   argument. The compiler then checks the index, and there is
+   no range check when the Sketch runs:
+     pulse.analogInput<1>(A1);
+     int bpm = pulse.getBeatsPerMinute<1>();
+*/
+template <int N>
+class PulseSensorPlaygroundT : public PulseSensorPlayground {
+  static_assert(N >= 1 && N <= 255, "PulseSensorPlaygroundT needs 1 to 255 PulseSensors");
+
+  public:
+    PulseSensorPlaygroundT() : PulseSensorPlayground(SensorArray, N) {
+    }
+
+    // The per-PulseSensor functions that take a run-time index.
+    using PulseSensorPlayground::analogInput;
+    using PulseSensorPlayground::blinkOnPulse;
+    using PulseSensorPlayground::fadeOnPulse;
+    using PulseSensorPlayground::setThreshold;
+    using PulseSensorPlayground::getLatestSample;
+    using PulseSensorPlayground::getOversampledSample;
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    using PulseSensorPlayground::getAcquisitionOffsetMicros;
+#endif
+    using PulseSensorPlayground::getBeatsPerMinute;
+    using PulseSensorPlayground::getInterBeatIntervalMs;
+    using PulseSensorPlayground::sawStartOfBeat;
+    using PulseSensorPlayground::isInsideBeat;
+    using PulseSensorPlayground::getPulseAmplitude;
+    using PulseSensorPlayground::getLastBeatTime;
+    using PulseSensorPlayground::getLastBeatTimeMicros;
+    using PulseSensorPlayground::getInterBeatIntervalMicros;
+    using PulseSensorPlayground::getHRV;
+
+    // The same functions, with the index checked by the compiler.
+    template <int I> void analogInput(int inputPin) {
+      sensor<I>().analogInput(inputPin);
+    }
+
+    template <int I> void blinkOnPulse(int blinkPin) {
+      sensor<I>().blinkOnPulse(blinkPin);
+    }
+
+    template <int I> void fadeOnPulse(int fadePin) {
+      sensor<I>().fadeOnPulse(fadePin);
+    }
+
+    template <int I> void setThreshold(int threshold) {
+      sensor<I>().setThreshold(threshold);
+    }
+
+    template <int I> int getLatestSample() {
+      return sensor<I>().getLatestSample();
+    }
+
+    template <int I> int getOversampledSample() {
+      return sensor<I>().getOversampledSample();
+    }
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    template <int I> word getAcquisitionOffsetMicros() {
+      return sensor<I>().getAcquisitionOffsetMicros();
+    }
+#endif
+
+    template <int I> int getBeatsPerMinute() {
+      return sensor<I>().getBeatsPerMinute();
+    }
+
+    template <int I> int getInterBeatIntervalMs() {
+      return sensor<I>().getInterBeatIntervalMs();
+    }
+
+    template <int I> bool sawStartOfBeat() {
+      return sensor<I>().sawStartOfBeat();
+    }
+
+    template <int I> bool isInsideBeat() {
+      return sensor<I>().isInsideBeat();
+    }
+
+    template <int I> int getPulseAmplitude() {
+      return sensor<I>().getPulseAmplitude();
+    }
+
+    template <int I> unsigned long getLastBeatTime() {
+      return sensor<I>().getLastBeatTime();
+    }
+
+    template <int I> unsigned long getLastBeatTimeMicros() {
+      return sensor<I>().getLastBeatTimeMicros();
+    }
+
+    template <int I> unsigned long getInterBeatIntervalMicros() {
+      return sensor<I>().getInterBeatIntervalMicros();
+    }
+
+    template <int I> bool getHRV(HRVMetrics &metrics) {
+      PulseSensorHRV *pHRV = sensor<I>().getHRV();
+      return pHRV ? pHRV->getMetrics(metrics) : false;
+    }
+
+  protected:
+    // (internal to the library) The same as PulseSensorPlayground::sampleSensors().
+    void sampleSensors() {
+      for (int i = 0; i < N; ++i) {
+        readSensor(SensorArray[i], i);
+      }
+#if PULSE_SENSOR_TIMING_HISTOGRAMS
+      AcquiredMicros = micros();
+#endif
+      PulseSensorPlaygroundT::processSamples();
+    }
+
+    // (internal to the library) The same as PulseSensorPlayground::processSamples().
+    void processSamples() {
+      for (int i = 0; i < N; ++i) {
+        byte found = SensorArray[i].processLatestSample();
+        if (found & CallbackEvents) {
+          handleBeatEvents(i, found);
+        }
+      }
+      if (!DeferLEDs) {
+        for (int i = 0; i < N; ++i) {
+          SensorArray[i].updateLEDs();
+        }
+      }
+    }
+
+  private:
+    template <int I> PulseSensor &sensor() {
+      static_assert(I >= 0 && I < N, "PulseSensor index out of range");
+      return SensorArray[I];
+    }
+
+    PulseSensor SensorArray[N];
+};
+
+#endif // PULSE_SENSOR_PLAYGROUND_T_H
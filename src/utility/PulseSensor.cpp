@@ -19,16 +19,49 @@
    Internal constants controlling the rate of fading for the FadePin.
 
    FADE_SCALE = FadeLevel / FADE_SCALE is the corresponding PWM value.
-   FADE_LEVEL_PER_SAMPLE = amount to decrease FadeLevel per sample.
+   FADE_LEVEL_PER_SAMPLE = amount to decrease FadeLevel per 2ms sample.
+     Scaled to the actual sample interval by setSampleIntervalMicros().
    MAX_FADE_LEVEL = maximum FadeLevel value.
 
    The time (milliseconds) to fade to black =
-     (MAX_FADE_LEVEL / FADE_LEVEL_PER_SAMPLE) * sample time (2ms)
+     (MAX_FADE_LEVEL / FADE_LEVEL_PER_SAMPLE) * 2ms
 */
 #define FADE_SCALE 10
 #define FADE_LEVEL_PER_SAMPLE 12
 #define MAX_FADE_LEVEL (255 * FADE_SCALE)
 
+/*
+   Beats per minute for an average IBI, without dividing.
+   BPM_IBI_LIMIT[i] = 60000 / (i + BPM_LOOKUP_MIN), the longest average IBI
+   (milliseconds) that gives i + BPM_LOOKUP_MIN beats per minute or more.
+*/
+#if PULSE_SENSOR_BPM_LOOKUP
+#define BPM_LOOKUP_MIN 20
+#define BPM_LOOKUP_MAX 250
+static const word BPM_IBI_LIMIT[BPM_LOOKUP_MAX - BPM_LOOKUP_MIN + 1] PROGMEM = {
+  3000, 2857, 2727, 2608, 2500, 2400, 2307, 2222, 2142, 2068, 2000, 1935,
+  1875, 1818, 1764, 1714, 1666, 1621, 1578, 1538, 1500, 1463, 1428, 1395,
+  1363, 1333, 1304, 1276, 1250, 1224, 1200, 1176, 1153, 1132, 1111, 1090,
+  1071, 1052, 1034, 1016, 1000, 983, 967, 952, 937, 923, 909, 895,
+  882, 869, 857, 845, 833, 821, 810, 800, 789, 779, 769, 759,
+  750, 740, 731, 722, 714, 705, 697, 689, 681, 674, 666, 659,
+  652, 645, 638, 631, 625, 618, 612, 606, 600, 594, 588, 582,
+  576, 571, 566, 560, 555, 550, 545, 540, 535, 530, 526, 521,
+  517, 512, 508, 504, 500, 495, 491, 487, 483, 480, 476, 472,
+  468, 465, 461, 458, 454, 451, 447, 444, 441, 437, 434, 431,
+  428, 425, 422, 419, 416, 413, 410, 408, 405, 402, 400, 397,
+  394, 392, 389, 387, 384, 382, 379, 377, 375, 372, 370, 368,
+  365, 363, 361, 359, 357, 355, 352, 350, 348, 346, 344, 342,
+  340, 338, 337, 335, 333, 331, 329, 327, 326, 324, 322, 320,
+  319, 317, 315, 314, 312, 310, 309, 307, 306, 304, 303, 301,
+  300, 298, 297, 295, 294, 292, 291, 289, 288, 287, 285, 284,
+  283, 281, 280, 279, 277, 276, 275, 273, 272, 271, 270, 269,
+  267, 266, 265, 264, 263, 262, 260, 259, 258, 257, 256, 255,
+  254, 253, 252, 251, 250, 248, 247, 246, 245, 244, 243, 242,
+  241, 240, 240,
+};
+#endif
+
 /*
    Constructs a Pulse detector that will process PulseSensor voltages
    that the caller reads from the PulseSensor.
@@ -38,29 +71,61 @@ PulseSensor::PulseSensor() {
   InputPin = A0;
   BlinkPin = -1;
   FadePin = -1;
+#if defined(ARDUINO_ARCH_AVR)
+  BlinkPort = NULL;
+  BlinkMask = 0;
+#endif
+  BlinkWritten = LOW;
+  FadeWrittenLevel = -1;
+  pBuffer = NULL;
+  pHRV = NULL;
+  pFilter = NULL;
+  OversampleShift = 0;
+  OversampledSignal = 512;
+#if PULSE_SENSOR_ACQUISITION_TIMES
+  AcquisitionOffsetMicros = 0;
+  SkewMicros = 0;
+  SkewFraction = 0;
+#endif
+  threshSetting = 550;        // default until the Sketch calls setThreshold()
 
   // Initialize (seed) the pulse detector
-  sampleIntervalMs = PulseSensorPlayground::MICROS_PER_READ / 1000;
+  setSampleIntervalMicros(PulseSensorPlayground::MICROS_PER_READ);
 	resetVariables();
 }
 
 void PulseSensor::resetVariables(){
-	for (int i = 0; i < 10; ++i) {
+	for (int i = 0; i < PULSE_SENSOR_IBI_WINDOW; ++i) {
     rate[i] = 0;
   }
+  rateIndex = 0;
+  rateTotal = 0;
+  sampleFractionMicros = 0;
   QS = false;
-  BPM = 0;
-  IBI = 750;                  // 750ms per beat = 80 Beats Per Minute (BPM)
-  Pulse = false;
+  bpm = 0;
+  ibi = 750;                  // 750ms per beat = 80 Beats Per Minute (BPM)
+  pulse = false;
   sampleCounter = 0;
-  lastBeatTime = 0;
+  beatTime = 0;
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+  beatMicros = 0;
+  ibiMicros = ibi * 1000UL;
+  previousSignal = 512;
+#endif
+#if PULSE_SENSOR_ACQUISITION_TIMES
+  PreviousSample = 512;
+#endif
   P = 512;                    // peak at 1/2 the input range of 0..1023
   T = 512;                    // trough at 1/2 the input range.
   thresh = threshSetting;     // reset the thresh variable with user defined THRESHOLD
-  amp = 100;                  // beat amplitude 1/10 of input range.
+  pulseAmp = 100;             // beat amplitude 1/10 of input range.
   firstBeat = true;           // looking for the first beat
   secondBeat = false;         // not yet looking for the second beat in a row
   FadeLevel = 0; // LED is dark.
+  if (pFilter) {
+    pFilter->reset();
+  }
+  publishBeat();
 }
 
 void PulseSensor::analogInput(int inputPin) {
@@ -69,6 +134,9 @@ void PulseSensor::analogInput(int inputPin) {
 
 void PulseSensor::blinkOnPulse(int blinkPin) {
   BlinkPin = blinkPin;
+#if defined(ARDUINO_ARCH_AVR)
+  BlinkPort = NULL; // found again by initializeLEDs().
+#endif
 }
 
 void PulseSensor::fadeOnPulse(int fadePin) {
@@ -82,10 +150,83 @@ void PulseSensor::setThreshold(int threshold) {
   ENABLE_PULSE_SENSOR_INTERRUPTS;
 }
 
+bool PulseSensor::setSampleIntervalMicros(unsigned long intervalMicros) {
+  if (pFilter && !pFilter->canFilterAt(intervalMicros)) {
+    return false;
+  }
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  // Whole milliseconds, plus microseconds carried into sampleCounter as they add up.
+  sampleIntervalMs = intervalMicros / 1000;
+  sampleIntervalFractionMicros = intervalMicros % 1000;
+  sampleFractionMicros = 0;
+  // Keep the fade time the same at any sample rate.
+  FadeLevelPerSample = (FADE_LEVEL_PER_SAMPLE * intervalMicros + 1000) / 2000;
+  if (FadeLevelPerSample < 1) {
+    FadeLevelPerSample = 1;
+  }
+  if (pFilter) {
+    pFilter->setSampleIntervalMicros(intervalMicros);
+  }
+#if PULSE_SENSOR_ACQUISITION_TIMES
+  SkewMicros = 0;  // found again, for this interval, by setAcquisitionTime().
+  SkewFraction = 0;
+#endif
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return true;
+}
+
+void PulseSensor::setBuffer(PulseSensorBuffer *buffer) {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  pBuffer = buffer;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+
+PulseSensorBuffer *PulseSensor::getBuffer() {
+  return pBuffer;
+}
+
+void PulseSensor::setHRV(PulseSensorHRV *hrv) {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  pHRV = hrv;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+
+PulseSensorHRV *PulseSensor::getHRV() {
+  return pHRV;
+}
+
+bool PulseSensor::setFilter(PulseSensorFilter *filter) {
+  if (filter
+    && !filter->setSampleIntervalMicros(sampleIntervalMs * 1000UL + sampleIntervalFractionMicros)) {
+    return false;
+  }
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  pFilter = filter;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return true;
+}
+
+PulseSensorFilter *PulseSensor::getFilter() {
+  return pFilter;
+}
+
 int PulseSensor::getLatestSample() {
   return Signal;
 }
 
+int PulseSensor::getOversampledSample() {
+  return OversampleShift == 0 ? Signal : OversampledSignal;
+}
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+word PulseSensor::getAcquisitionOffsetMicros() {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  word offsetMicros = AcquisitionOffsetMicros;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return offsetMicros;
+}
+#endif
+
 int PulseSensor::getBeatsPerMinute() {
   return BPM;
 }
@@ -102,6 +243,28 @@ unsigned long PulseSensor::getLastBeatTime() {
   return lastBeatTime;
 }
 
+unsigned long PulseSensor::getLastBeatTimeMicros() {
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  unsigned long beatMicros = lastBeatMicros;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return beatMicros;
+#else
+  return lastBeatTime * 1000UL;
+#endif
+}
+
+unsigned long PulseSensor::getInterBeatIntervalMicros() {
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  unsigned long intervalMicros = IBIMicros;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return intervalMicros;
+#else
+  return (unsigned long) IBI * 1000UL;
+#endif
+}
+
 bool PulseSensor::sawStartOfBeat() {
   // Disable interrupts to avoid a race with the ISR.
   DISABLE_PULSE_SENSOR_INTERRUPTS;
@@ -117,115 +280,384 @@ bool PulseSensor::isInsideBeat() {
 }
 
 void PulseSensor::readNextSample() {
-  // We assume assigning to an int is atomic.
-  Signal = analogRead(InputPin);
+  if (OversampleShift == 0) {
+    // We assume assigning to an int is atomic.
+    Signal = analogRead(InputPin);
+    return;
+  }
+
+  /*
+     Average (box-car filter and decimate) 2^OversampleShift readings,
+     one straight after another. Uncorrelated ADC noise falls by the
+     square root of their number: half a bit for each doubling.
+     16 readings of 0..1023 still fit in a word.
+  */
+  word sum = 0;
+  for (byte i = 1 << OversampleShift; i > 0; --i) {
+    sum += analogRead(InputPin);
+  }
+  setReadingSum(sum);
 }
 
-void PulseSensor::processLatestSample() {
-  sampleCounter += sampleIntervalMs;         // keep track of the time in mS with this variable
-  N = sampleCounter - lastBeatTime;      // monitor the time since the last beat to avoid noise
+void PulseSensor::setReadingSum(word sum) {
+  if (OversampleShift == 0) {
+    Signal = sum;
+    return;
+  }
+  byte fineShift = OversampleShift - OversampleShift / 2;
+  OversampledSignal = (sum + (1 << (fineShift - 1))) >> fineShift;
+  Signal = (sum + (1 << (OversampleShift - 1))) >> OversampleShift;
+}
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+void PulseSensor::setAcquisitionTime(word offsetMicros, word skewMicros) {
+  AcquisitionOffsetMicros = offsetMicros;
+  if (skewMicros == SkewMicros) {
+    return; // the usual case: no division.
+  }
+  SkewMicros = skewMicros;
+  unsigned long intervalMicros = sampleIntervalMs * 1000UL + sampleIntervalFractionMicros;
+  SkewFraction = skewMicros < intervalMicros
+    ? (word) (((unsigned long) skewMicros << 16) / intervalMicros)
+    : 0;  // read a whole sample late: nothing to interpolate between.
+}
+#endif
+
+void PulseSensor::setOversampling(byte shift) {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  OversampleShift = shift;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+
+byte PulseSensor::getOversampling() {
+  return OversampleShift;
+}
+
+int PulseSensor::getInputPin() {
+  return InputPin;
+}
+
+byte PulseSensor::processLatestSample() {
   // Fade the Fading LED
-  FadeLevel = FadeLevel - FADE_LEVEL_PER_SAMPLE;
+  FadeLevel = FadeLevel - FadeLevelPerSample;
   FadeLevel = constrain(FadeLevel, 0, MAX_FADE_LEVEL);
 
+  int signal = Signal;
+#if PULSE_SENSOR_ACQUISITION_TIMES
+  if (SkewFraction) {
+    /*
+       Move the sample back SkewMicros, along the straight line from
+       the one before, to when the first PulseSensor was read, so every
+       PulseSensor's beats are timed from the same instants.
+    */
+    signal -= (int) (((long) (signal - PreviousSample) * SkewFraction + 0x8000L) >> 16);
+  }
+  PreviousSample = Signal;
+#endif
+
+  byte found = findBeat(signal);
+  if (found) {
+    if (found & FOUND_BEAT_START) {
+      QS = true;                            // set Quantified Self flag (we detected a beat)
+      FadeLevel = MAX_FADE_LEVEL;           // If we're fading, re-light that LED.
+    }
+    if (found & FOUND_SIGNAL_LOST) {
+      QS = false;
+    }
+    publishBeat();
+  }
+
+  if (pBuffer) {
+    pBuffer->putSample(Signal);
+    if (found & FOUND_BEAT_START) {
+      BeatEvent beat;
+      getBeatEvent(beat);
+      pBuffer->putBeat(beat);
+    }
+  }
+  if (pHRV && (found & (FOUND_BEAT_START | FOUND_SIGNAL_LOST))) {
+    pHRV->addBeat(found, getIntervalMicros());
+  }
+  return found;
+}
+
+size_t PulseSensor::processBlock(const int16_t *samples, size_t n,
+  BeatEvent *out, size_t outCap) {
+  size_t beats = 0;
+
+  for (size_t i = 0; i < n; ++i) {
+    if ((findBeat(samples[i]) & FOUND_BEAT_START) == 0) {
+      continue;
+    }
+    if (out && beats < outCap) {
+      getBeatEvent(out[beats]);
+      out[beats].sampleIndex = i;
+      out[beats].sensorIndex = 0;
+    }
+    ++beats;
+  }
+
+  finishBlock(n > 0 ? samples[n - 1] : Signal);
+  return beats;
+}
+
+void PulseSensor::skipSamples(byte count) {
+  unsigned long fractionMicros = sampleFractionMicros
+    + (unsigned long) count * sampleIntervalFractionMicros;
+  sampleCounter += (unsigned long) count * sampleIntervalMs + fractionMicros / 1000;
+  sampleFractionMicros = fractionMicros % 1000;
+}
+
+byte PulseSensor::findBeat(int signal) {
+  byte found = 0;
+
+  if (pFilter) {
+    signal = pFilter->filter(signal);
+  }
+
+  sampleCounter += sampleIntervalMs;         // keep track of the time in mS with this variable
+  sampleFractionMicros += sampleIntervalFractionMicros;
+  if (sampleFractionMicros >= 1000) {        // sample intervals that aren't whole milliseconds
+    sampleFractionMicros -= 1000;
+    ++sampleCounter;
+  }
+  N = sampleCounter - beatTime;              // monitor the time since the last beat to avoid noise
+
   //  find the peak and trough of the pulse wave
-  if (Signal < thresh && N > (IBI / 5) * 3) { // avoid dichrotic noise by waiting 3/5 of last IBI
-    if (Signal < T) {                        // T is the trough
-      T = Signal;                            // keep track of lowest point in pulse wave
+  if (signal < thresh && N > (ibi / 5) * 3) { // avoid dichrotic noise by waiting 3/5 of last IBI
+    if (signal < T) {                        // T is the trough
+      T = signal;                            // keep track of lowest point in pulse wave
     }
   }
 
-  if (Signal > thresh && Signal > P) {       // thresh condition helps avoid noise
-    P = Signal;                              // P is the peak
+  if (signal > thresh && signal > P) {       // thresh condition helps avoid noise
+    P = signal;                              // P is the peak
   }                                          // keep track of highest point in pulse wave
 
   //  NOW IT'S TIME TO LOOK FOR THE HEART BEAT
   // signal surges up in value every time there is a pulse
   if (N > 250) {                             // avoid high frequency noise
-    if ( (Signal > thresh) && (Pulse == false) && (N > (IBI / 5) * 3) ) {
-      Pulse = true;                          // set the Pulse flag when we think there is a pulse
-      IBI = sampleCounter - lastBeatTime;    // measure time between beats in mS
-      lastBeatTime = sampleCounter;          // keep track of time for next pulse
+    if ( (signal > thresh) && (pulse == false) && (N > (ibi / 5) * 3) ) {
+      pulse = true;                          // set the Pulse flag when we think there is a pulse
+      ibi = sampleCounter - beatTime;        // measure time between beats in mS
+      beatTime = sampleCounter;              // keep track of time for next pulse
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+      unsigned long crossing = crossingMicros(signal);
+      ibiMicros = crossing - beatMicros;
+      beatMicros = crossing;
+#endif
 
       if (secondBeat) {                      // if this is the second beat, if secondBeat == TRUE
         secondBeat = false;                  // clear secondBeat flag
-        for (int i = 0; i <= 9; i++) {       // seed the running total to get a realisitic BPM at startup
-          rate[i] = IBI;
+        for (int i = 0; i < PULSE_SENSOR_IBI_WINDOW; i++) { // seed the running total to get a realisitic BPM at startup
+          rate[i] = ibi;
         }
+        rateIndex = 0;
+        rateTotal = (unsigned long) ibi * PULSE_SENSOR_IBI_WINDOW;
       }
 
       if (firstBeat) {                       // if it's the first time we found a beat, if firstBeat == TRUE
         firstBeat = false;                   // clear firstBeat flag
         secondBeat = true;                   // set the second beat flag
         // IBI value is unreliable so discard it
-        return;
+        return FOUND_FIRST_BEAT;
       }
 
-
-      // keep a running total of the last 10 IBI values
-      word runningTotal = 0;                  // clear the runningTotal variable
-
-      for (int i = 0; i <= 8; i++) {          // shift data in the rate array
-        rate[i] = rate[i + 1];                // and drop the oldest IBI value
-        runningTotal += rate[i];              // add up the 9 oldest IBI values
-      }
-
-      rate[9] = IBI;                          // add the latest IBI to the rate array
-      runningTotal += rate[9];                // add the latest IBI to runningTotal
-      runningTotal /= 10;                     // average the last 10 IBI values
-      BPM = 60000 / runningTotal;             // how many beats can fit into a minute? that's BPM!
-      QS = true;                              // set Quantified Self flag (we detected a beat)
-      FadeLevel = MAX_FADE_LEVEL;             // If we're fading, re-light that LED.
+      // keep a running total of the last PULSE_SENSOR_IBI_WINDOW IBI values,
+      // and find how many beats can fit into a minute: that's BPM!
+      bpm = addIBI(rate, rateIndex, rateTotal, ibi);
+      found |= FOUND_BEAT_START;              // we detected a beat
     }
   }
 
-  if (Signal < thresh && Pulse == true) {  // when the values are going down, the beat is over
-    Pulse = false;                         // reset the Pulse flag so we can do it again
-    amp = P - T;                           // get amplitude of the pulse wave
-    thresh = amp / 2 + T;                  // set thresh at 50% of the amplitude
+  if (signal < thresh && pulse == true) {  // when the values are going down, the beat is over
+    pulse = false;                         // reset the Pulse flag so we can do it again
+    pulseAmp = P - T;                      // get amplitude of the pulse wave
+    thresh = pulseAmp / 2 + T;             // set thresh at 50% of the amplitude
     P = thresh;                            // reset these for next time
     T = thresh;
+    found |= FOUND_BEAT_END;
   }
 
   if (N > 2500) {                          // if 2.5 seconds go by without a beat
     thresh = threshSetting;                // set thresh default
     P = 512;                               // set P default
     T = 512;                               // set T default
-    lastBeatTime = sampleCounter;          // bring the lastBeatTime up to date
+    beatTime = sampleCounter;              // bring the lastBeatTime up to date
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+    beatMicros = sampleCounter * 1000UL + sampleFractionMicros;
+    ibiMicros = 600000UL;
+#endif
     firstBeat = true;                      // set these to avoid noise
     secondBeat = false;                    // when we get the heartbeat back
-    QS = false;
-    BPM = 0;
-    IBI = 600;                  // 600ms per beat = 100 Beats Per Minute (BPM)
-    Pulse = false;
-    amp = 100;                  // beat amplitude 1/10 of input range.
+    bpm = 0;
+    ibi = 600;                  // 600ms per beat = 100 Beats Per Minute (BPM)
+    pulse = false;
+    pulseAmp = 100;             // beat amplitude 1/10 of input range.
+    found |= FOUND_SIGNAL_LOST;
+  }
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+  previousSignal = signal;
+#endif
+  return found;
+}
 
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+unsigned long PulseSensor::crossingMicros(int signal) {
+  unsigned long nowMicros = sampleCounter * 1000UL + sampleFractionMicros;
+  if (previousSignal > thresh) {
+    return nowMicros; // the signal was already above thresh; no crossing to find.
+  }
+  /*
+     signal > thresh >= previousSignal, so thresh was crossed between
+     the two samples. Find where, in 1/4096ths of the sample interval.
+     A sample difference is at most 65535, so this fits in 32 bits,
+     and so does interval * 4096 for any rate setSampleRate() allows.
+  */
+  unsigned long intervalMicros = sampleIntervalMs * 1000UL + sampleIntervalFractionMicros;
+  unsigned long above = ((unsigned long) (signal - thresh) << 12)
+    / (unsigned long) (signal - previousSignal);
+  return nowMicros - ((intervalMicros * above) >> 12);
+}
+#endif // PULSE_SENSOR_INTERPOLATE_BEATS
+
+int PulseSensor::addIBI(int *rate, byte &rateIndex, unsigned long &rateTotal, int ibi) {
+  rateTotal -= rate[rateIndex];           // drop the oldest IBI value
+  rate[rateIndex] = ibi;                  // and put the latest in its place
+  rateTotal += ibi;
+  if (++rateIndex >= PULSE_SENSOR_IBI_WINDOW) {
+    rateIndex = 0;
   }
+  return ibiTotalToBPM(rateTotal);
+}
+
+int PulseSensor::ibiTotalToBPM(unsigned long ibiTotal) {
+#if PULSE_SENSOR_BPM_LOOKUP
+  /*
+     The average IBI, ibiTotal / PULSE_SENSOR_IBI_WINDOW, is at most
+     BPM_IBI_LIMIT[i] exactly when ibiTotal < PULSE_SENSOR_IBI_WINDOW * (BPM_IBI_LIMIT[i] + 1).
+     Binary search for the last i where that's true.
+  */
+  const byte last = BPM_LOOKUP_MAX - BPM_LOOKUP_MIN;
+  if (ibiTotal < PULSE_SENSOR_IBI_WINDOW * (pgm_read_word(&BPM_IBI_LIMIT[0]) + 1UL)
+    && ibiTotal >= PULSE_SENSOR_IBI_WINDOW * (pgm_read_word(&BPM_IBI_LIMIT[last]) + 1UL)) {
+    byte lo = 0;     // true at lo
+    byte hi = last;  // false at hi
+    while (hi - lo > 1) {
+      byte mid = (lo + hi) / 2;
+      if (ibiTotal < PULSE_SENSOR_IBI_WINDOW * (pgm_read_word(&BPM_IBI_LIMIT[mid]) + 1UL)) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo + BPM_LOOKUP_MIN;
+  }
+  // Outside the table: slower than BPM_LOOKUP_MIN or faster than BPM_LOOKUP_MAX.
+#endif
+  unsigned long average = ibiTotal / PULSE_SENSOR_IBI_WINDOW; // average the IBI values
+  if (average == 0) {
+    return 0;
+  }
+  return 60000UL / average;
+}
+
+void PulseSensor::publishBeat() {
+  BPM = bpm;
+  IBI = ibi;
+  Pulse = pulse;
+  amp = pulseAmp;
+  lastBeatTime = beatTime;
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+  lastBeatMicros = beatMicros;
+  IBIMicros = ibiMicros;
+#endif
+}
+
+void PulseSensor::finishBlock(int lastSample) {
+  Signal = lastSample;
+  publishBeat();
+}
+
+unsigned long PulseSensor::getBeatMicros() {
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+  return beatMicros;
+#else
+  return beatTime * 1000UL;
+#endif
+}
+
+unsigned long PulseSensor::getIntervalMicros() {
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+  return ibiMicros;
+#else
+  return (unsigned long) ibi * 1000UL;
+#endif
+}
+
+void PulseSensor::getBeatEvent(BeatEvent &event) {
+  event.beatTime = beatTime;
+  event.beatsPerMinute = bpm;
+  event.interBeatIntervalMs = ibi;
+  event.pulseAmplitude = pulseAmp;
 }
 
 void PulseSensor::initializeLEDs() {
   if (BlinkPin >= 0) {
     pinMode(BlinkPin, OUTPUT);
     digitalWrite(BlinkPin, LOW);
+    BlinkWritten = LOW;
+#if defined(ARDUINO_ARCH_AVR)
+    // Find the pin's port now, so updateLEDs() needn't look it up every time.
+    uint8_t port = digitalPinToPort(BlinkPin);
+    BlinkPort = port == NOT_A_PIN ? NULL : portOutputRegister(port);
+    BlinkMask = digitalPinToBitMask(BlinkPin);
+#endif
   }
   if (FadePin >= 0) {
     pinMode(FadePin, OUTPUT);
     analogWrite(FadePin, 0); // turn off the LED.
+    FadeWrittenLevel = 0;
   }
 }
 
 void PulseSensor::updateLEDs() {
+  /*
+     The LEDs change only on the start and end of a beat,
+     and while fading, so most calls write nothing.
+  */
   if (BlinkPin >= 0) {
-		if(Pulse){
-    	digitalWrite(BlinkPin, HIGH);
-  	}else{
-			digitalWrite(BlinkPin,LOW);
-		}
-	}
+    byte state = Pulse ? HIGH : LOW;
+    if (state != BlinkWritten) {
+      BlinkWritten = state;
+#if defined(ARDUINO_ARCH_AVR)
+      if (BlinkPort) {
+        // Same as digitalWrite(), without the pin lookups.
+        uint8_t oldSREG = SREG;
+        cli();
+        if (state == HIGH) {
+          *BlinkPort |= BlinkMask;
+        } else {
+          *BlinkPort &= ~BlinkMask;
+        }
+        SREG = oldSREG;
+      } else
+#endif
+      {
+        digitalWrite(BlinkPin, state);
+      }
+    }
+  }
 
   if (FadePin >= 0) {
 		#ifndef NO_ANALOG_WRITE
-	    analogWrite(FadePin, FadeLevel / FADE_SCALE);
+      int level = FadeLevel;
+      // Divide only when the level has left the PWM value last written.
+      if (level < FadeWrittenLevel || level >= FadeWrittenLevel + FADE_SCALE) {
+        int pwm = level / FADE_SCALE;
+        FadeWrittenLevel = pwm * FADE_SCALE;
+	      analogWrite(FadePin, pwm);
+      }
 		#endif
   }
 }
@@ -17,6 +17,69 @@
 #define PULSE_SENSOR_H
 #include <Arduino.h>
 
+/*
+   The number of inter-beat intervals (IBIs) averaged into beats per minute.
+   Heart rate variability work may want 32 or 64. Each IBI costs 2 bytes
+   of RAM per PulseSensor, but processing time doesn't grow with the window.
+   Powers of 2 (8, 16, 32, 64) let the average be taken with a shift.
+   Must be 1..255.
+*/
+#ifndef PULSE_SENSOR_IBI_WINDOW
+#define PULSE_SENSOR_IBI_WINDOW 10
+#endif
+
+/*
+   If true, beats per minute is looked up in a 462 byte table in flash
+   instead of computed with a long division. AVR chips have no divide
+   instruction, so it may pay there, but the division is done once a
+   beat, not once a sample, and the saving hasn't been measured on an
+   AVR board yet; so it's off everywhere until it has been.
+*/
+#ifndef PULSE_SENSOR_BPM_LOOKUP
+#define PULSE_SENSOR_BPM_LOOKUP false
+#endif
+
+/*
+   If true, each beat's time is found to a fraction of a sample period,
+   by finding where a straight line between the samples either side of
+   the threshold crosses it, instead of taking the time of the first
+   sample above it. getLastBeatTimeMicros() and getInterBeatIntervalMicros()
+   are then about ten times finer than a sample period, which helps
+   Pulse Transit Time and heart rate variability measures.
+   It costs 18 bytes of RAM per PulseSensor, and a division per beat.
+   BPM and the millisecond times are the same either way.
+*/
+#ifndef PULSE_SENSOR_INTERPOLATE_BEATS
+#define PULSE_SENSOR_INTERPOLATE_BEATS false
+#endif
+
+/*
+   If true, the Playground notes when, within each sample period, it
+   read each PulseSensor (see getAcquisitionOffsetMicros()), and can
+   make up for reading them one after another (see setSkewCompensation()).
+   It costs 8 bytes of RAM per PulseSensor and a micros() call per
+   PulseSensor per sample, so it's off unless you need it.
+*/
+#ifndef PULSE_SENSOR_ACQUISITION_TIMES
+#define PULSE_SENSOR_ACQUISITION_TIMES false
+#endif
+
+/*
+   One beat found by processBlock(), or passed to a beat callback.
+*/
+struct BeatEvent {
+  unsigned long sampleIndex;  // index of the sample (or frame) the beat was found on.
+  unsigned long beatTime;     // time of the beat (ms), the same as getLastBeatTime().
+  int beatsPerMinute;         // beats per minute, including this beat.
+  int interBeatIntervalMs;    // inter-beat interval ending at this beat (ms).
+  int pulseAmplitude;         // amplitude of the previous pulse wave.
+  word sensorIndex;           // the PulseSensor (or PulseSensorChannels channel) that found the beat.
+};
+
+class PulseSensorBuffer;
+class PulseSensorHRV;
+class PulseSensorFilter;
+
 class PulseSensor {
   public:
     // Constructs a PulseSensor manager using a default configuration.
@@ -37,6 +100,21 @@ class PulseSensor {
     // Returns the sample most recently-read from this PulseSensor.
     int getLatestSample();
 
+    /*
+       Returns the latest sample with the extra resolution oversampling
+       gives (see setOversampling()): 0..2047 at 4 or 8 times,
+       0..4095 at 16 times, otherwise the same as getLatestSample().
+    */
+    int getOversampledSample();
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    /*
+       Returns when the latest sample was read, in microseconds after
+       the Playground started reading the first PulseSensor that sample.
+    */
+    word getAcquisitionOffsetMicros();
+#endif
+
     // Returns the latest beats-per-minute measurement on this PulseSensor.
     int getBeatsPerMinute();
 
@@ -52,48 +130,202 @@ class PulseSensor {
     // Returns the latest amp value.
     int getPulseAmplitude();
 
-    // Returns the sample number of the most recent detected pulse.
+    // Returns the time (ms) of the most recent detected pulse.
     unsigned long getLastBeatTime();
 
+    // Returns the time (microseconds) of the most recent detected pulse.
+    // See PULSE_SENSOR_INTERPOLATE_BEATS.
+    unsigned long getLastBeatTimeMicros();
+
+    // Returns the latest inter-beat interval (microseconds) on this PulseSensor.
+    unsigned long getInterBeatIntervalMicros();
+
     //COULD move these to private by having a single public function the ISR calls.
     // (internal to the library) Read a sample from this PulseSensor.
     void readNextSample();
 
     // (internal to the library) Process the latest sample.
-    void processLatestSample();
+    // Returns the FOUND_* flags of findBeat().
+    byte processLatestSample();
 
     // (internal to the library) Set up any LEDs the user wishes.
     void initializeLEDs();
 
     // (internal to the library) Update the Blink and Fade LED states.
+    // Writes a pin only when its LED has changed.
     void updateLEDs();
 
     // (internal to the library) Updtate the thresh variables.
     void setThreshold(int threshold);
 
+    // (internal to the library) Set the time between calls to processLatestSample().
+    // Returns false, and changes nothing, if the filter (see setFilter()) can't work at that rate.
+    bool setSampleIntervalMicros(unsigned long intervalMicros);
+
+    // (internal to the library) Move the beat finder's clock on by count samples that weren't read.
+    void skipSamples(byte count);
+
+    // (internal to the library) Average 2^shift analogRead()s into each sample.
+    void setOversampling(byte shift);
+
+    // (internal to the library) Returns the shift given to setOversampling().
+    byte getOversampling();
+
+    // (internal to the library) Returns the pin given to analogInput().
+    int getInputPin();
+
+    /*
+       (internal to the library) Set the latest sample from the sum of
+       2^shift readings (see setOversampling()) taken some other way
+       than readNextSample(), for example by the ADC interrupt.
+    */
+    void setReadingSum(word sum);
+
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    /*
+       (internal to the library) Note when the latest sample was read
+       (see getAcquisitionOffsetMicros()), and have processLatestSample()
+       give the beat finder the signal as it was skewMicros earlier,
+       or as read if skewMicros is 0.
+    */
+    void setAcquisitionTime(word offsetMicros, word skewMicros);
+#endif
+
+    // Queue every sample and beat in the given buffer, or stop if NULL.
+    void setBuffer(PulseSensorBuffer *buffer);
+
+    // Returns the buffer set by setBuffer(), or NULL.
+    PulseSensorBuffer *getBuffer();
+
+    // Give each IBI found to the given HRV measure, or stop if NULL.
+    void setHRV(PulseSensorHRV *hrv);
+
+    // Returns the HRV measure set by setHRV(), or NULL.
+    PulseSensorHRV *getHRV();
+
+    // Filter each sample before the beat finder sees it, or stop if NULL.
+    // Returns false, and changes nothing, if filter can't work at the sample rate.
+    bool setFilter(PulseSensorFilter *filter);
+
+    // Returns the filter set by setFilter(), or NULL.
+    PulseSensorFilter *getFilter();
+
+    /*
+       Run the beat finder over a recorded block of samples, as if each
+       sample had been read by readNextSample(), one sample period apart.
+       Used to process recordings much faster than real time.
+       Don't call this while the Playground is sampling this PulseSensor.
+
+       samples = the signal, oldest first (range: 0..1023).
+       n = the number of samples.
+       out = where to store the beats found, in order. May be NULL.
+       outCap = the number of BeatEvents out has room for.
+
+       Returns the number of beats found. If that's more than outCap,
+       only the first outCap beats are stored.
+    */
+    size_t processBlock(const int16_t *samples, size_t n,
+      BeatEvent *out, size_t outCap);
+
+    // (internal to the library) Run the beat finder on one sample.
+    // Returns the FOUND_* flags; results stay private until publishBeat().
+    byte findBeat(int signal);
+
+    // (internal to the library) Make the beat finder results visible to the Sketch.
+    void publishBeat();
+
+    // (internal to the library) publishBeat() after findBeat() calls on a block,
+    // and make lastSample the latest sample.
+    void finishBlock(int lastSample);
+
+    // (internal to the library) Convert the sum of PULSE_SENSOR_IBI_WINDOW IBIs to BPM.
+    static int ibiTotalToBPM(unsigned long ibiTotal);
+
+    /*
+       (internal to the library) Put ibi in place of the oldest of the
+       PULSE_SENSOR_IBI_WINDOW IBIs in the ring rate[], keeping rateIndex
+       (where the next goes) and rateTotal (their sum) up to date.
+       Returns the BPM of the new total. Used by findBeat().
+    */
+    static int addIBI(int *rate, byte &rateIndex, unsigned long &rateTotal, int ibi);
+
+    // (internal to the library) Describe the beat findBeat() just found.
+    void getBeatEvent(BeatEvent &event);
+
+    // (internal to the library) The time (microseconds) of the beat findBeat() just found.
+    unsigned long getBeatMicros();
+
+    // (internal to the library) The IBI (microseconds) of the beat findBeat() just found.
+    unsigned long getIntervalMicros();
+
+    // findBeat() flags.
+    static const byte FOUND_BEAT_START = 0x01;  // a new beat was counted.
+    static const byte FOUND_BEAT_END = 0x02;    // the signal fell below thresh.
+    static const byte FOUND_SIGNAL_LOST = 0x04; // no beat for 2.5 seconds.
+    static const byte FOUND_FIRST_BEAT = 0x08;  // a first beat, too early to count.
+
 
   private:
     // Configuration
     int InputPin;           // Analog input pin for PulseSensor.
     int BlinkPin;           // pin to blink in beat, or -1.
     int FadePin;            // pin to fade on beat, or -1.
+#if defined(ARDUINO_ARCH_AVR)
+    volatile uint8_t *BlinkPort; // output register of BlinkPin, or NULL to use digitalWrite().
+    uint8_t BlinkMask;           // BlinkPin's bit in BlinkPort.
+#endif
+    PulseSensorBuffer *pBuffer; // where to queue samples and beats, or NULL.
+    PulseSensorHRV *pHRV;       // where to measure heart rate variability, or NULL.
+    PulseSensorFilter *pFilter; // filter for the beat finder's input, or NULL.
+    byte OversampleShift;       // readNextSample() averages 2^OversampleShift reads.
+#if PULSE_SENSOR_ACQUISITION_TIMES
+    volatile word AcquisitionOffsetMicros; // when the latest sample was read. See setAcquisitionTime().
+    word SkewMicros;            // how much earlier the beat finder's signal should be,
+    word SkewFraction;          // as a fraction of the sample interval, times 2^16.
+    int PreviousSample;         // the sample before the latest, as read.
+#endif
 
-    // Pulse detection output variables.
+    // Pulse detection output variables, copied from the variables below by publishBeat().
     // Volatile because our pulse detection code could be called from an Interrupt
     volatile int BPM;                // int that holds raw Analog in 0. updated every call to readSensor()
     volatile int Signal;             // holds the latest incoming raw data (0..1023)
+    volatile int OversampledSignal;  // Signal, with the bits oversampling gained.
     volatile int IBI;                // int that holds the time interval (ms) between beats! Must be seeded!
     volatile bool Pulse;          // "True" when User's live heartbeat is detected. "False" when not a "live beat".
     volatile bool QS;             // The start of beat has been detected and not read by the Sketch.
     volatile int FadeLevel;          // brightness of the FadePin, in scaled PWM units. See FADE_SCALE
+    byte BlinkWritten;               // the value last written to BlinkPin.
+    int FadeWrittenLevel;            // the PWM value last written to FadePin, times FADE_SCALE; -1 until initializeLEDs().
     volatile int threshSetting;      // used to seed and reset the thresh variable
     volatile int amp;                         // used to hold amplitude of pulse waveform, seeded (sample value)
     volatile unsigned long lastBeatTime;      // used to find IBI. Time (sampleCounter) of the previous detected beat start.
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+    volatile unsigned long lastBeatMicros;    // lastBeatTime, in microseconds, between samples.
+    volatile unsigned long IBIMicros;         // IBI, in microseconds.
+#endif
 
     // Variables internal to the pulse detection algorithm.
     // Not volatile because we use them only internally to the pulse detection.
-    unsigned long sampleIntervalMs;  // expected time between calls to readSensor(), in milliseconds.
-    int rate[10];                    // array to hold last ten IBI values (ms)
+    int bpm;                         // working copy of BPM.
+    int ibi;                         // working copy of IBI.
+    bool pulse;                      // working copy of Pulse.
+    int pulseAmp;                    // working copy of amp.
+    unsigned long beatTime;          // working copy of lastBeatTime.
+#if PULSE_SENSOR_INTERPOLATE_BEATS
+    unsigned long beatMicros;        // working copy of lastBeatMicros.
+    unsigned long ibiMicros;         // working copy of IBIMicros.
+    int previousSignal;              // the sample before this one.
+
+    // (internal to the library) The time (microseconds) signal crossed thresh.
+    unsigned long crossingMicros(int signal);
+#endif
+    unsigned long sampleIntervalMs;  // expected time between calls to readSensor(), whole milliseconds.
+    word sampleIntervalFractionMicros; // and the microseconds left over (0..999).
+    word sampleFractionMicros;       // leftover microseconds not yet added to sampleCounter.
+    int FadeLevelPerSample;          // amount to dim the FadePin each sample.
+    int rate[PULSE_SENSOR_IBI_WINDOW]; // ring of the latest IBI values (ms)
+    byte rateIndex;                  // where in rate[] the next IBI goes, replacing the oldest.
+    unsigned long rateTotal;         // sum of rate[].
     unsigned long sampleCounter;     // used to determine pulse timing. Milliseconds since we started.
     int N;                           // used to monitor duration between beats
     int P;                           // used to find peak in pulse wave, seeded (sample value)
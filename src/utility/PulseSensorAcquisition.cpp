@@ -0,0 +1,403 @@
+/*
+   Hardware-timed, DMA-driven reading of every PulseSensor at once.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+PulseSensorAcquisition::PulseSensorAcquisition(int16_t *storage, int framesPerBlock) {
+  Storage = storage;
+  FramesPerBlock = framesPerBlock;
+  SensorCount = 0;
+  SampleShift = 0;
+  Conversions = 1;
+  ConversionNanos = 0;
+  Rounds = 1;
+  Full[0] = false;
+  Full[1] = false;
+  LastCompleted = 1;
+  Reading = 0;
+  Overruns = 0;
+}
+
+bool PulseSensorAcquisition::begin(PulseSensor *sensors, byte sensorCount,
+  unsigned long intervalMicros) {
+  if (!Storage || FramesPerBlock <= 0 || sensorCount == 0) {
+    return false;
+  }
+  SensorCount = sensorCount;
+  SampleShift = 0;
+  Conversions = 1;
+  ConversionNanos = 0;
+  Rounds = 1;
+  Full[0] = false;
+  Full[1] = false;
+  LastCompleted = 1;  // so block 0 is read first.
+  if (!startScan(sensors, sensorCount, intervalMicros)) {
+    return false;
+  }
+  return getFramesPerBlock() > 0;
+}
+
+void PulseSensorAcquisition::end() {
+  stopScan();
+}
+
+const int16_t *PulseSensorAcquisition::readBlock() {
+  poll();
+
+  // If both are full, the one that didn't fill last is older.
+  byte last = LastCompleted;
+  if (Full[last ^ 1]) {
+    Reading = last ^ 1;
+  } else if (Full[last]) {
+    Reading = last;
+  } else {
+    return NULL;
+  }
+
+  int16_t *block = getBlock(Reading);
+  if (Conversions > 1 || SampleShift > 0) {
+    /*
+       Average each PulseSensor's conversions in a frame, and scale to
+       0..1023, in place: frame f's samples land at or before where
+       its first round of conversions was.
+    */
+    long divisor = (long) Conversions << SampleShift;
+    int frames = getFramesPerBlock();
+    const int16_t *pConversion = block;
+    int16_t *pSample = block;
+    for (int f = 0; f < frames; ++f) {
+      for (byte s = 0; s < SensorCount; ++s) {
+        long sum = 0;
+        for (byte c = 0; c < Conversions; ++c) {
+          sum += pConversion[c * SensorCount + s];
+        }
+        pSample[s] = (int16_t) ((sum + divisor / 2) / divisor);
+      }
+      pConversion += SensorCount * Conversions;
+      pSample += SensorCount;
+    }
+  }
+  return block;
+}
+
+void PulseSensorAcquisition::releaseBlock() {
+  Full[Reading] = false;
+}
+
+int PulseSensorAcquisition::getFramesPerBlock() {
+  return FramesPerBlock / Conversions;
+}
+
+unsigned long PulseSensorAcquisition::getOverruns() {
+  return Overruns;
+}
+
+word PulseSensorAcquisition::getOffsetMicros(byte sensor) {
+  /*
+     In half conversion periods: sensor's place in a round, plus the
+     middle of the rounds, (Rounds - 1) / 2 rounds of SensorCount each.
+  */
+  unsigned long halves = 2UL * sensor + (unsigned long) SensorCount * (Rounds - 1);
+  return (word) ((halves * ConversionNanos / 2 + 500) / 1000);
+}
+
+int16_t *PulseSensorAcquisition::getBlock(byte block) {
+  return Storage + (long) block * FramesPerBlock * SensorCount;
+}
+
+int PulseSensorAcquisition::getBlockSamples() {
+  return getFramesPerBlock() * SensorCount * Conversions;
+}
+
+void PulseSensorAcquisition::blockComplete(byte block) {
+  if (Full[block]) {
+    ++Overruns; // the Sketch didn't read it in time; it's been written over.
+  }
+  Full[block] = true;
+  LastCompleted = block;
+}
+
+#if PULSE_SENSOR_DMA_SUPPORTED && defined(ARDUINO_ARCH_RP2040)
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#define RP2040_ADC_CLOCK_MHZ 48      // clk_adc, from the USB PLL.
+#define RP2040_ADC_MIN_CYCLES 96     // a conversion takes 96 ADC clocks.
+#define RP2040_ADC_MAX_CYCLES 65536  // the clock divider's integer part is 16 bits.
+#define RP2040_FIRST_ADC_PIN 26      // A0 is GPIO 26, ADC input 0.
+
+PulseSensorDMA *PulseSensorDMA::OurThis;
+
+PulseSensorDMA::PulseSensorDMA(int16_t *storage, int framesPerBlock)
+  : PulseSensorAcquisition(storage, framesPerBlock) {
+  Channels[0] = -1;
+  Channels[1] = -1;
+}
+
+bool PulseSensorDMA::startScan(PulseSensor *sensors, byte sensorCount,
+  unsigned long intervalMicros) {
+  // The round robin converts its inputs in increasing order.
+  byte mask = 0;
+  int first = -1;
+  int previous = -1;
+  for (byte i = 0; i < sensorCount; ++i) {
+    int input = sensors[i].getInputPin() - RP2040_FIRST_ADC_PIN;
+    if (input <= previous || input > 3) {
+      return false;
+    }
+    if (first < 0) {
+      first = input;
+    }
+    mask |= 1 << input;
+    previous = input;
+  }
+
+  /*
+     One conversion every (1 + divider) ADC clocks, every PulseSensor
+     each round. If a round per frame would need too slow a clock,
+     take several rounds a frame, and let readBlock() average them.
+  */
+  unsigned long frameCycles = RP2040_ADC_CLOCK_MHZ * intervalMicros;
+  Conversions = 1;
+  while ((frameCycles + sensorCount * Conversions - 1) / (sensorCount * Conversions)
+    > RP2040_ADC_MAX_CYCLES) {
+    ++Conversions;
+  }
+  float cycles = (float) frameCycles / (sensorCount * Conversions);
+  if (cycles < RP2040_ADC_MIN_CYCLES || getFramesPerBlock() == 0) {
+    return false;
+  }
+  SampleShift = 2;  // 12-bit conversions.
+  ConversionNanos = (unsigned long) (cycles * 1000.0 / RP2040_ADC_CLOCK_MHZ);
+  Rounds = Conversions;
+
+  Channels[0] = dma_claim_unused_channel(false);
+  Channels[1] = dma_claim_unused_channel(false);
+  if (Channels[0] < 0 || Channels[1] < 0) {
+    stopScan();
+    return false;
+  }
+
+  adc_init();
+  for (byte i = 0; i < sensorCount; ++i) {
+    adc_gpio_init(sensors[i].getInputPin());
+  }
+  adc_select_input(first);
+  adc_set_round_robin(mask);
+  adc_fifo_setup(true, true, 1, false, false); // FIFO and DMA request on, 16-bit samples.
+  adc_set_clkdiv(cycles - 1.0);
+
+  // Each channel fills its block, then starts the other.
+  for (byte b = 0; b < 2; ++b) {
+    dma_channel_config config = dma_channel_get_default_config(Channels[b]);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_dreq(&config, DREQ_ADC);
+    channel_config_set_chain_to(&config, Channels[b ^ 1]);
+    dma_channel_configure(Channels[b], &config, getBlock(b), &adc_hw->fifo,
+      getBlockSamples(), false);
+    dma_channel_set_irq0_enabled(Channels[b], true);
+  }
+  OurThis = this;
+  irq_add_shared_handler(DMA_IRQ_0, onTransferComplete, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_0, true);
+
+  adc_fifo_drain();
+  dma_channel_start(Channels[0]);
+  adc_run(true);
+  return true;
+}
+
+void PulseSensorDMA::stopScan() {
+  adc_run(false);
+  adc_set_round_robin(0);
+  for (byte b = 0; b < 2; ++b) {
+    if (Channels[b] < 0) {
+      continue;
+    }
+    dma_channel_set_irq0_enabled(Channels[b], false);
+    // Unchain before aborting, or the abort can start the other channel.
+    hw_clear_bits(&dma_hw->ch[Channels[b]].al1_ctrl, DMA_CH0_CTRL_TRIG_EN_BITS);
+  }
+  for (byte b = 0; b < 2; ++b) {
+    if (Channels[b] < 0) {
+      continue;
+    }
+    dma_channel_abort(Channels[b]);
+    dma_channel_acknowledge_irq0(Channels[b]);
+    dma_channel_unclaim(Channels[b]);
+    Channels[b] = -1;
+  }
+  if (OurThis == this) {
+    irq_remove_handler(DMA_IRQ_0, onTransferComplete);
+    OurThis = NULL;
+  }
+  adc_fifo_drain();
+}
+
+void PulseSensorDMA::onTransferComplete() {
+  PulseSensorDMA *pThis = OurThis;
+  if (!pThis) {
+    return;
+  }
+  for (byte b = 0; b < 2; ++b) {
+    int channel = pThis->Channels[b];
+    if (channel < 0 || !dma_channel_get_irq0_status(channel)) {
+      continue;
+    }
+    dma_channel_acknowledge_irq0(channel);
+    // Ready for when the other channel chains back to this one.
+    dma_channel_set_write_addr(channel, pThis->getBlock(b), false);
+    pThis->blockComplete(b);
+  }
+}
+#endif // PULSE_SENSOR_DMA_SUPPORTED && ARDUINO_ARCH_RP2040
+
+#if PULSE_SENSOR_DMA_SUPPORTED && defined(ARDUINO_ARCH_ESP32)
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ESP32_ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ESP32_ADC_CHANNEL(p) ((p)->type1.channel)
+#define ESP32_ADC_DATA(p) ((p)->type1.data)
+#else
+#define ESP32_ADC_OUTPUT_FORMAT ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ESP32_ADC_CHANNEL(p) ((p)->type2.channel)
+#define ESP32_ADC_DATA(p) ((p)->type2.data)
+#endif
+#define ESP32_READ_BYTES 256        // conversion results poll() reads at a time.
+
+PulseSensorDMA::PulseSensorDMA(int16_t *storage, int framesPerBlock)
+  : PulseSensorAcquisition(storage, framesPerBlock) {
+  Handle = NULL;
+}
+
+bool PulseSensorDMA::startScan(PulseSensor *sensors, byte sensorCount,
+  unsigned long intervalMicros) {
+  if (sensorCount > PULSE_SENSOR_DMA_MAX_SENSORS) {
+    return false;
+  }
+  adc_digi_pattern_config_t pattern[PULSE_SENSOR_DMA_MAX_SENSORS];
+  for (byte i = 0; i < sensorCount; ++i) {
+    adc_unit_t unit;
+    adc_channel_t channel;
+    if (adc_continuous_io_to_channel(sensors[i].getInputPin(), &unit, &channel) != ESP_OK
+      || unit != ADC_UNIT_1) {
+      return false;
+    }
+    AdcChannels[i] = (byte) channel;
+    pattern[i].atten = ADC_ATTEN_DB_12;   // as analogRead(): the full 0..3.3V.
+    pattern[i].channel = (uint8_t) channel;
+    pattern[i].unit = ADC_UNIT_1;
+    pattern[i].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+  }
+
+  // Convert each pin as many times a frame as the driver's slowest rate needs.
+  unsigned long frameRate = 1000000UL / intervalMicros;
+  unsigned long perPin = frameRate * sensorCount;
+  unsigned long conversions = (SOC_ADC_SAMPLE_FREQ_THRES_LOW + perPin - 1) / perPin;
+  if (conversions == 0) {
+    conversions = 1;
+  }
+  if (conversions > 255 || perPin * conversions > SOC_ADC_SAMPLE_FREQ_THRES_HIGH) {
+    return false;
+  }
+  PinConversions = (byte) conversions;
+  SampleShift = SOC_ADC_DIGI_MAX_BITWIDTH - 10;
+  ConversionNanos = 1000000000UL / (perPin * PinConversions);
+  Rounds = PinConversions;
+
+  // Room in the driver for two blocks of conversions, between calls to poll().
+  unsigned long frameBytes = (unsigned long) SOC_ADC_DIGI_DATA_BYTES_PER_CONV
+    * sensorCount * PinConversions;
+  adc_continuous_handle_cfg_t handleConfig = {};
+  handleConfig.max_store_buf_size = frameBytes * getFramesPerBlock() * 2;
+  handleConfig.conv_frame_size = frameBytes;
+  if (adc_continuous_new_handle(&handleConfig, &Handle) != ESP_OK) {
+    Handle = NULL;
+    return false;
+  }
+  adc_continuous_config_t config = {};
+  config.pattern_num = sensorCount;
+  config.adc_pattern = pattern;
+  config.sample_freq_hz = perPin * PinConversions;
+  config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+  config.format = ESP32_ADC_OUTPUT_FORMAT;
+  if (adc_continuous_config(Handle, &config) != ESP_OK) {
+    stopScan();
+    return false;
+  }
+
+  for (byte i = 0; i < sensorCount; ++i) {
+    Sums[i] = 0;
+    Counts[i] = 0;
+  }
+  Filling = 0;
+  FrameIndex = 0;
+  if (adc_continuous_start(Handle) != ESP_OK) {
+    stopScan();
+    return false;
+  }
+  return true;
+}
+
+void PulseSensorDMA::stopScan() {
+  if (!Handle) {
+    return;
+  }
+  adc_continuous_stop(Handle);
+  adc_continuous_deinit(Handle);
+  Handle = NULL;
+}
+
+void PulseSensorDMA::poll() {
+  if (!Handle) {
+    return;
+  }
+  uint8_t results[ESP32_READ_BYTES];
+  uint32_t length = 0;
+  byte last = SensorCount - 1;
+  while (adc_continuous_read(Handle, results, sizeof(results), &length, 0) == ESP_OK) {
+    for (uint32_t r = 0; r + SOC_ADC_DIGI_RESULT_BYTES <= length; r += SOC_ADC_DIGI_RESULT_BYTES) {
+      adc_digi_output_data_t *pResult = (adc_digi_output_data_t *) &results[r];
+      byte channel = ESP32_ADC_CHANNEL(pResult);
+      for (byte i = 0; i < SensorCount; ++i) {
+        if (AdcChannels[i] == channel && Counts[i] < PinConversions) {
+          Sums[i] += ESP32_ADC_DATA(pResult);
+          ++Counts[i];
+          break;
+        }
+      }
+      if (Counts[last] < PinConversions) {
+        continue;
+      }
+
+      // The pattern ends with the last PulseSensor: the frame is done.
+      int16_t *pFrame = getBlock(Filling) + FrameIndex * SensorCount;
+      for (byte i = 0; i < SensorCount; ++i) {
+        pFrame[i] = Counts[i] ? (int16_t) ((Sums[i] + Counts[i] / 2) / Counts[i]) : 0;
+        Sums[i] = 0;
+        Counts[i] = 0;
+      }
+      if (++FrameIndex >= getFramesPerBlock()) {
+        blockComplete(Filling);
+        Filling ^= 1;
+        FrameIndex = 0;
+      }
+    }
+  }
+}
+#endif // PULSE_SENSOR_DMA_SUPPORTED && ARDUINO_ARCH_ESP32
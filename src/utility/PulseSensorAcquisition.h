@@ -0,0 +1,211 @@
+/*
+   Hardware-timed, DMA-driven reading of every PulseSensor at once.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_ACQUISITION_H
+#define PULSE_SENSOR_ACQUISITION_H
+
+#include <Arduino.h>
+
+class PulseSensor;
+
+/*
+   Reads the PulseSensors instead of the sample timer and analogRead().
+   The ADC's own clock times the samples and DMA stores them, so no
+   sample is early or late, and the processor does nothing per sample
+   until the Sketch's loop() processes them a block at a time.
+
+   Samples go into two blocks in turn: while one fills, the
+   Playground looks for beats in the other. A block is framesPerBlock
+   frames (fewer on some boards; see getFramesPerBlock()) of one
+   sample per PulseSensor, in PulseSensor order.
+   The Sketch owns the storage, 2 * framesPerBlock * (number of
+   PulseSensors) int16_ts. For example, 4 PulseSensors in blocks
+   of 50 samples (100 ms at 500 samples per second):
+
+     int16_t dmaStorage[2 * 50 * 4];
+     PulseSensorDMA dma(dmaStorage, 50);
+     ...
+     pulseSensor.setAcquisition(dma);  // before begin().
+
+   loop() must call sawNewSample() at least once a block; a block not
+   read by the time the next one fills is overwritten, and counted by
+   getOverruns().
+
+   This is the common part. PulseSensorDMA is the one for the board
+   being compiled for, where there is one (PULSE_SENSOR_DMA_SUPPORTED);
+   extras/host has a simulated one.
+*/
+class PulseSensorAcquisition {
+  public:
+    /*
+       storage = where to keep the two blocks.
+       framesPerBlock = samples of each PulseSensor in a block.
+    */
+    PulseSensorAcquisition(int16_t *storage, int framesPerBlock);
+
+    virtual ~PulseSensorAcquisition() {}
+
+    /*
+       (internal to the library) Start reading the given PulseSensors'
+       pins, a frame every intervalMicros.
+       Returns false if the hardware can't.
+    */
+    bool begin(PulseSensor *sensors, byte sensorCount, unsigned long intervalMicros);
+
+    // (internal to the library) Stop reading.
+    void end();
+
+    /*
+       (internal to the library) Returns the oldest full block,
+       its samples 0..1023, or NULL if there is none yet.
+       Call releaseBlock() when done with it.
+    */
+    const int16_t *readBlock();
+
+    // (internal to the library) Let the block from readBlock() be filled again.
+    void releaseBlock();
+
+    /*
+       Returns the number of frames in a block: framesPerBlock, or, where the
+       ADC can't convert slowly enough (one PulseSensor at 500 samples per
+       second on an RP2040), a half or less of it. Valid after begin().
+    */
+    int getFramesPerBlock();
+
+    // Returns the number of blocks overwritten before they were read.
+    unsigned long getOverruns();
+
+    /*
+       (internal to the library) Returns when the given PulseSensor
+       (0..sensorCount - 1) is read, in microseconds after the frame's
+       first conversion: the middle of its conversions in the frame.
+    */
+    word getOffsetMicros(byte sensor);
+
+  protected:
+    /*
+       Start the hardware writing frames into getBlock(0), then getBlock(1),
+       and so on, calling blockComplete() as each one fills.
+       Returns false if it can't.
+    */
+    virtual bool startScan(PulseSensor *sensors, byte sensorCount,
+      unsigned long intervalMicros) = 0;
+
+    // Stop the hardware.
+    virtual void stopScan() = 0;
+
+    /*
+       For hardware that has to be asked for its samples:
+       move them into the blocks. Called by readBlock().
+    */
+    virtual void poll() {}
+
+    // Returns where block 0 or 1 starts.
+    int16_t *getBlock(byte block);
+
+    // Returns the number of conversions the hardware writes into a block.
+    int getBlockSamples();
+
+    // Call, from an interrupt if need be, when the given block is full.
+    void blockComplete(byte block);
+
+    byte SensorCount;             // PulseSensors in a frame.
+    byte SampleShift;             // bits readBlock() drops to make samples 0..1023.
+    /*
+       Conversions of each PulseSensor in a frame, one round of all of them
+       after another; readBlock() averages them into one sample. For hardware
+       that can't convert as slowly as a frame needs. A block then holds
+       framesPerBlock / Conversions frames.
+    */
+    byte Conversions;
+    /*
+       For getOffsetMicros(): nanoseconds from one conversion to the next,
+       and rounds of conversions of every PulseSensor in a frame (Conversions,
+       or however many the hardware averages itself). Set by startScan().
+    */
+    unsigned long ConversionNanos;
+    byte Rounds;
+
+  private:
+    int16_t *Storage;
+    int FramesPerBlock;
+    volatile bool Full[2];        // the block is full and not yet released.
+    volatile byte LastCompleted;  // the block that filled most recently.
+    byte Reading;                 // the block readBlock() returned.
+    volatile unsigned long Overruns;
+};
+
+/*
+   PulseSensorDMA, on the boards that have one:
+     RP2040    the ADC's round robin reads A0..A3 into its FIFO, timed by
+               its clock divider, and two chained DMA channels move the
+               FIFO into the blocks. PulseSensors must be on different
+               pins of A0..A3, in increasing order.
+     ESP32     the ESP-IDF continuous ADC driver (arduino-esp32 3.0 and up)
+               reads ADC1 pins by DMA, fast enough for the driver
+               (20 kHz on the ESP32), averaging the conversions of each
+               pin into one sample per frame.
+*/
+#if defined(ARDUINO_ARCH_RP2040) && !defined(ARDUINO_ARCH_MBED)
+#define PULSE_SENSOR_DMA_SUPPORTED true
+#elif defined(ARDUINO_ARCH_ESP32) && __has_include(<esp_adc/adc_continuous.h>)
+#define PULSE_SENSOR_DMA_SUPPORTED true
+#else
+#define PULSE_SENSOR_DMA_SUPPORTED false
+#endif
+
+/*
+   The most PulseSensors a PulseSensorDMA can read.
+*/
+#ifndef PULSE_SENSOR_DMA_MAX_SENSORS
+#define PULSE_SENSOR_DMA_MAX_SENSORS 8
+#endif
+
+#if PULSE_SENSOR_DMA_SUPPORTED
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_adc/adc_continuous.h>
+#endif
+
+class PulseSensorDMA : public PulseSensorAcquisition {
+  public:
+    PulseSensorDMA(int16_t *storage, int framesPerBlock);
+
+  protected:
+    bool startScan(PulseSensor *sensors, byte sensorCount, unsigned long intervalMicros);
+    void stopScan();
+#if defined(ARDUINO_ARCH_ESP32)
+    void poll();
+#endif
+
+  private:
+#if defined(ARDUINO_ARCH_RP2040)
+    // The DMA interrupt: restart the channel that finished on its block.
+    static void onTransferComplete();
+
+    static PulseSensorDMA *OurThis;
+    int Channels[2];              // the DMA channel filling each block.
+#elif defined(ARDUINO_ARCH_ESP32)
+    adc_continuous_handle_t Handle;
+    byte PinConversions;          // conversions of each pin averaged into a sample.
+    byte AdcChannels[PULSE_SENSOR_DMA_MAX_SENSORS]; // each PulseSensor's ADC1 channel.
+    long Sums[PULSE_SENSOR_DMA_MAX_SENSORS];        // its conversions so far this frame.
+    byte Counts[PULSE_SENSOR_DMA_MAX_SENSORS];
+    byte Filling;                 // the block poll() is filling,
+    int FrameIndex;               // and the next frame in it.
+#endif
+};
+#endif // PULSE_SENSOR_DMA_SUPPORTED
+
+#endif // PULSE_SENSOR_ACQUISITION_H
@@ -0,0 +1,74 @@
+/*
+   Buffered PulseSensor samples and beats.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include "PulseSensorBuffer.h"
+
+PulseSensorBuffer::PulseSensorBuffer(int16_t *sampleStorage,
+  size_t sampleCapacity, BeatEvent *beatStorage,
+  size_t beatCapacity) {
+  bool samplesOk = Samples.begin(sampleStorage, sampleCapacity);
+  bool beatsOk = Beats.begin(beatStorage, beatCapacity);
+  Valid = samplesOk && beatsOk;
+  SensorIndex = 0;
+  SampleCount = 0;
+}
+
+bool PulseSensorBuffer::isValid() {
+  return Valid;
+}
+
+void PulseSensorBuffer::setSensorIndex(byte sensorIndex) {
+  SensorIndex = sensorIndex;
+}
+
+void PulseSensorBuffer::putSample(int sample) {
+  Samples.put((int16_t) sample);
+  ++SampleCount;
+}
+
+void PulseSensorBuffer::putBeat(BeatEvent &beat) {
+  beat.sampleIndex = SampleCount - 1; // the sample just put.
+  beat.sensorIndex = SensorIndex;
+  Beats.put(beat);
+}
+
+int PulseSensorBuffer::readSamples(int16_t *buf, int n) {
+  if (n <= 0) {
+    return 0;
+  }
+  if ((unsigned long) n > PULSE_SENSOR_RING_MAX_CAPACITY) {
+    n = PULSE_SENSOR_RING_MAX_CAPACITY;
+  }
+  return Samples.get(buf, (PulseSensorRingIndex) n);
+}
+
+int PulseSensorBuffer::readBeats(BeatEvent *buf, int n) {
+  if (n <= 0) {
+    return 0;
+  }
+  if ((unsigned long) n > PULSE_SENSOR_RING_MAX_CAPACITY) {
+    n = PULSE_SENSOR_RING_MAX_CAPACITY;
+  }
+  return Beats.get(buf, (PulseSensorRingIndex) n);
+}
+
+unsigned long PulseSensorBuffer::getSampleOverruns() {
+  return Samples.getOverruns();
+}
+
+unsigned long PulseSensorBuffer::getBeatOverruns() {
+  return Beats.getOverruns();
+}
@@ -0,0 +1,81 @@
+/*
+   Buffered PulseSensor samples and beats, so a Sketch's loop() can
+   take longer than a sample period without losing data.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_BUFFER_H
+#define PULSE_SENSOR_BUFFER_H
+
+#include <Arduino.h>
+#include "PulseSensor.h"
+#include "PulseSensorRing.h"
+
+/*
+   Every sample read from one PulseSensor, and every beat found on it,
+   queued until the Sketch reads them.
+
+   The Sketch owns the storage, so it decides how much RAM to spend.
+   For example, to hold 1/4 second of samples and 4 beats:
+
+     int16_t sampleStorage[128];
+     BeatEvent beatStorage[4];
+     PulseSensorBuffer buffer(sampleStorage, 128, beatStorage, 4);
+     ...
+     pulseSensor.setBuffer(buffer);
+
+   Sizes must be powers of 2, no larger than 128 on AVR boards.
+*/
+class PulseSensorBuffer {
+  public:
+    PulseSensorBuffer(int16_t *sampleStorage, size_t sampleCapacity,
+      BeatEvent *beatStorage, size_t beatCapacity);
+
+    // Returns true if both storage sizes are usable.
+    bool isValid();
+
+    // (internal to the library) Queue the latest sample.
+    void putSample(int sample);
+
+    // (internal to the library) Queue a beat found on the latest sample.
+    void putBeat(BeatEvent &beat);
+
+    // (internal to the library) Which PulseSensor fills this buffer.
+    void setSensorIndex(byte sensorIndex);
+
+    /*
+       Copy up to n of the oldest queued samples into buf, oldest first.
+       Returns the number copied.
+    */
+    int readSamples(int16_t *buf, int n);
+
+    /*
+       Copy up to n of the oldest queued beats into buf, oldest first.
+       A BeatEvent's sampleIndex counts samples put in this buffer,
+       including any dropped, so it lines up with readSamples() data.
+       Returns the number copied.
+    */
+    int readBeats(BeatEvent *buf, int n);
+
+    // Number of samples, or beats, dropped because the Sketch didn't read them in time.
+    unsigned long getSampleOverruns();
+    unsigned long getBeatOverruns();
+
+  private:
+    PulseSensorRing<int16_t> Samples;
+    PulseSensorRing<BeatEvent> Beats;
+    bool Valid;                   // both rings are usable.
+    byte SensorIndex;             // stamped on each BeatEvent.
+    unsigned long SampleCount;    // samples offered to putSample(), including dropped.
+};
+#endif // PULSE_SENSOR_BUFFER_H
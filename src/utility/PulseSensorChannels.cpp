@@ -0,0 +1,308 @@
+/*
+   Beat finding for many PulseSensor signals sampled together.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+/*
+   beatState flags: PulseSensor's firstBeat and secondBeat.
+*/
+#define BEAT_STATE_FIRST 0x01
+#define BEAT_STATE_SECOND 0x02
+
+PulseSensorChannels::PulseSensorChannels(int channelCount) {
+  Count = channelCount > 0 ? channelCount : 0;
+  P = new int16_t[Count];
+  T = new int16_t[Count];
+  thresh = new int16_t[Count];
+  threshSetting = new int16_t[Count];
+  sinceBeat = new int16_t[Count];
+  quietMs = new int16_t[Count];
+  pulse = new int16_t[Count];
+  ibi = new int16_t[Count];
+  bpm = new int16_t[Count];
+  pulseAmp = new int16_t[Count];
+  found = new byte[Count];
+  beatState = new byte[Count];
+  beatTime = new unsigned long[Count];
+  rate = new int16_t[(long) Count * PULSE_SENSOR_IBI_WINDOW];
+  rateIndex = new byte[Count];
+  rateTotal = new unsigned long[Count];
+  if (!P || !T || !thresh || !threshSetting || !sinceBeat || !quietMs
+    || !pulse || !ibi || !bpm || !pulseAmp || !found || !beatState
+    || !beatTime || !rate || !rateIndex || !rateTotal) {
+    Count = 0; // out of memory.
+  }
+
+  for (int c = 0; c < Count; ++c) {
+    threshSetting[c] = 550; // default until the Sketch calls setThreshold()
+  }
+  setSampleIntervalMicros(PulseSensorPlayground::MICROS_PER_READ);
+  resetVariables();
+}
+
+PulseSensorChannels::~PulseSensorChannels() {
+  delete[] P;
+  delete[] T;
+  delete[] thresh;
+  delete[] threshSetting;
+  delete[] sinceBeat;
+  delete[] quietMs;
+  delete[] pulse;
+  delete[] ibi;
+  delete[] bpm;
+  delete[] pulseAmp;
+  delete[] found;
+  delete[] beatState;
+  delete[] beatTime;
+  delete[] rate;
+  delete[] rateIndex;
+  delete[] rateTotal;
+}
+
+int PulseSensorChannels::getChannelCount() {
+  return Count;
+}
+
+void PulseSensorChannels::resetVariables() {
+  sampleCounter = 0;
+  sampleFractionMicros = 0;
+  for (int c = 0; c < Count; ++c) {
+    P[c] = 512;
+    T[c] = 512;
+    thresh[c] = threshSetting[c];
+    sinceBeat[c] = 0;
+    ibi[c] = 750;
+    quietMs[c] = (750 / 5) * 3;
+    pulse[c] = 0;
+    bpm[c] = 0;
+    pulseAmp[c] = 100;
+    found[c] = 0;
+    beatState[c] = BEAT_STATE_FIRST;
+    beatTime[c] = 0;
+    rateIndex[c] = 0;
+    rateTotal[c] = 0;
+  }
+  for (long i = 0; i < (long) Count * PULSE_SENSOR_IBI_WINDOW; ++i) {
+    rate[i] = 0;
+  }
+}
+
+void PulseSensorChannels::setSampleIntervalMicros(unsigned long intervalMicros) {
+  sampleIntervalMs = intervalMicros / 1000;
+  sampleIntervalFractionMicros = intervalMicros % 1000;
+  sampleFractionMicros = 0;
+}
+
+void PulseSensorChannels::setThreshold(int channel, int threshold) {
+  if (channel != constrain(channel, 0, Count - 1)) {
+    return; // out of range.
+  }
+  threshold = constrain(threshold, -32767, 32767);
+  threshSetting[channel] = threshold;
+  thresh[channel] = threshold;
+}
+
+/*
+   PulseSensor::findBeat()'s work for every sample, for all channels,
+   with no branches (& rather than &&), so the compiler can vectorize it.
+   The beat start, beat end and signal lost conditions are tested
+   here, and acted on by finishBeat(), for just the channels
+   they're true for. A beat can't start and end on the same sample.
+
+   __restrict__ promises the compiler that the arrays don't overlap.
+   Returns the FOUND_* flags of all channels, ORed together.
+*/
+static byte findInFrame(int count, int16_t step,
+  const int16_t *__restrict__ frame, const int16_t *__restrict__ thresh,
+  const int16_t *__restrict__ quietMs, const int16_t *__restrict__ pulse,
+  int16_t *__restrict__ sinceBeat, int16_t *__restrict__ P,
+  int16_t *__restrict__ T, byte *__restrict__ found) {
+  byte any = 0;
+  for (int c = 0; c < count; ++c) {
+    int16_t signal = frame[c];
+    int16_t th = thresh[c];
+    int16_t n = sinceBeat[c] + step;
+    sinceBeat[c] = n;
+    bool quiet = n > quietMs[c];            // avoid dichrotic noise by waiting 3/5 of last IBI
+    bool below = signal < th;
+    bool above = signal > th;
+
+    int16_t t = T[c];
+    T[c] = (below & quiet & (signal < t)) ? signal : t;
+    int16_t p = P[c];
+    P[c] = (above & (signal > p)) ? signal : p;
+
+    byte f = ((n > 250) & above & (pulse[c] == 0) & quiet) * PulseSensor::FOUND_BEAT_START
+      | (below & (pulse[c] != 0)) * PulseSensor::FOUND_BEAT_END
+      | (n > 2500) * PulseSensor::FOUND_SIGNAL_LOST;
+    found[c] = f;
+    any |= f;
+  }
+  return any;
+}
+
+bool PulseSensorChannels::processFrame(const int16_t *frame) {
+  // The clock is the same for every channel.
+  int16_t step = (int16_t) sampleIntervalMs;
+  sampleFractionMicros += sampleIntervalFractionMicros;
+  if (sampleFractionMicros >= 1000) {
+    sampleFractionMicros -= 1000;
+    ++step;
+  }
+  sampleCounter += step;
+
+  byte any = findInFrame(Count, step, frame, thresh, quietMs, pulse,
+    sinceBeat, P, T, found);
+
+  if (!any) {
+    return false;
+  }
+  for (int c = 0; c < Count; ++c) {
+    if (found[c]) {
+      finishBeat(c);
+    }
+  }
+  return true;
+}
+
+void PulseSensorChannels::finishBeat(int c) {
+  byte f = found[c];
+  found[c] = 0;
+
+  if (f & PulseSensor::FOUND_BEAT_START) {
+    pulse[c] = 1;                          // set the Pulse flag when we think there is a pulse
+    ibi[c] = sinceBeat[c];                 // measure time between beats in mS
+    quietMs[c] = (ibi[c] / 5) * 3;
+    beatTime[c] = sampleCounter;           // keep track of time for next pulse
+    sinceBeat[c] = 0;
+    int16_t *ring = rate + (long) c * PULSE_SENSOR_IBI_WINDOW;
+
+    if (beatState[c] & BEAT_STATE_SECOND) { // seed the running total to get a realisitic BPM at startup
+      beatState[c] &= ~BEAT_STATE_SECOND;
+      for (int i = 0; i < PULSE_SENSOR_IBI_WINDOW; i++) {
+        ring[i] = ibi[c];
+      }
+      rateIndex[c] = 0;
+      rateTotal[c] = (unsigned long) ibi[c] * PULSE_SENSOR_IBI_WINDOW;
+    }
+
+    if (beatState[c] & BEAT_STATE_FIRST) {  // IBI value is unreliable so discard it
+      beatState[c] = BEAT_STATE_SECOND;
+      found[c] = PulseSensor::FOUND_FIRST_BEAT;
+      return;
+    }
+
+    // keep a running total of the last PULSE_SENSOR_IBI_WINDOW IBI values
+    byte i = rateIndex[c];
+    rateTotal[c] -= ring[i];
+    ring[i] = ibi[c];
+    rateTotal[c] += ibi[c];
+    rateIndex[c] = (i + 1 >= PULSE_SENSOR_IBI_WINDOW) ? 0 : i + 1;
+    bpm[c] = PulseSensor::ibiTotalToBPM(rateTotal[c]);
+    found[c] |= PulseSensor::FOUND_BEAT_START;
+  }
+
+  if (f & PulseSensor::FOUND_BEAT_END) {   // when the values are going down, the beat is over
+    pulse[c] = 0;
+    pulseAmp[c] = P[c] - T[c];             // get amplitude of the pulse wave
+    thresh[c] = pulseAmp[c] / 2 + T[c];    // set thresh at 50% of the amplitude
+    P[c] = thresh[c];                      // reset these for next time
+    T[c] = thresh[c];
+    found[c] |= PulseSensor::FOUND_BEAT_END;
+  }
+
+  if (f & PulseSensor::FOUND_SIGNAL_LOST) { // if 2.5 seconds go by without a beat
+    thresh[c] = threshSetting[c];
+    P[c] = 512;
+    T[c] = 512;
+    beatTime[c] = sampleCounter;           // bring the lastBeatTime up to date
+    sinceBeat[c] = 0;
+    beatState[c] = BEAT_STATE_FIRST;
+    bpm[c] = 0;
+    ibi[c] = 600;                          // 600ms per beat = 100 Beats Per Minute (BPM)
+    quietMs[c] = (600 / 5) * 3;
+    pulse[c] = 0;
+    pulseAmp[c] = 100;
+    found[c] |= PulseSensor::FOUND_SIGNAL_LOST;
+  }
+}
+
+byte PulseSensorChannels::getFound(int channel) {
+  if (channel != constrain(channel, 0, Count - 1)) {
+    return 0; // out of range.
+  }
+  return found[channel];
+}
+
+size_t PulseSensorChannels::processBlock(const int16_t *frames, size_t frameCount,
+  BeatEvent *out, size_t outCap) {
+  size_t beats = 0;
+  for (size_t frame = 0; frame < frameCount; ++frame, frames += Count) {
+    if (!processFrame(frames)) {
+      continue;
+    }
+    for (int c = 0; c < Count; ++c) {
+      if ((found[c] & PulseSensor::FOUND_BEAT_START) == 0) {
+        continue;
+      }
+      if (out && beats < outCap) {
+        out[beats].sampleIndex = frame;
+        out[beats].beatTime = beatTime[c];
+        out[beats].beatsPerMinute = bpm[c];
+        out[beats].interBeatIntervalMs = ibi[c];
+        out[beats].pulseAmplitude = pulseAmp[c];
+        out[beats].sensorIndex = c;
+      }
+      ++beats;
+    }
+  }
+  return beats;
+}
+
+int PulseSensorChannels::getBeatsPerMinute(int channel) {
+  if (channel != constrain(channel, 0, Count - 1)) {
+    return -1; // out of range.
+  }
+  return bpm[channel];
+}
+
+int PulseSensorChannels::getInterBeatIntervalMs(int channel) {
+  if (channel != constrain(channel, 0, Count - 1)) {
+    return -1; // out of range.
+  }
+  return ibi[channel];
+}
+
+int PulseSensorChannels::getPulseAmplitude(int channel) {
+  if (channel != constrain(channel, 0, Count - 1)) {
+    return -1; // out of range.
+  }
+  return pulseAmp[channel];
+}
+
+unsigned long PulseSensorChannels::getLastBeatTime(int channel) {
+  if (channel != constrain(channel, 0, Count - 1)) {
+    return 0; // out of range.
+  }
+  return beatTime[channel];
+}
+
+bool PulseSensorChannels::isInsideBeat(int channel) {
+  if (channel != constrain(channel, 0, Count - 1)) {
+    return false; // out of range.
+  }
+  return pulse[channel] != 0;
+}
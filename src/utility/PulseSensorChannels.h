@@ -0,0 +1,144 @@
+/*
+   Beat finding for many PulseSensor signals sampled together.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_CHANNELS_H
+#define PULSE_SENSOR_CHANNELS_H
+
+#include <Arduino.h>
+#include "PulseSensor.h"
+
+/*
+   PulseSensorChannels finds beats in any number of channels (PulseSensor
+   signals) that are sampled at the same time, with the same beat finder
+   as PulseSensor, giving the same beats, BPM and IBI for each channel.
+
+   Where PulseSensor keeps each channel's beat finder variables together,
+   PulseSensorChannels keeps each variable for all the channels together,
+   in an array of 16-bit values, and updates every channel for each sample
+   in one short loop without branches. The clock is kept once for all
+   channels, and the work done only on a beat (updating the BPM, say)
+   is done only for the channels that found one.
+   On a 32-bit board that's less work per channel; on a desktop computer
+   the compiler turns the loop into SIMD instructions (SSE, AVX, NEON)
+   that handle 8 to 32 channels at a time.
+
+   Use it when a Sketch reads more PulseSensors than the Playground is
+   comfortable with, or to process recordings of many channels.
+   It doesn't read the analog inputs, drive LEDs, or print: the caller
+   hands it a frame (one sample from each channel) at a time:
+
+     PulseSensorChannels channels(16);
+     ...
+     int16_t frame[16];    // read at the sample rate (500 per second).
+     ...
+     if (channels.processFrame(frame)) {
+       for (int c = 0; c < 16; ++c) {
+         if (channels.getFound(c) & PulseSensor::FOUND_BEAT_START) {
+           ... channels.getBeatsPerMinute(c) ...
+         }
+       }
+     }
+
+   Call its functions from one place (for example, loop()), not from
+   an interrupt and loop() at once.
+*/
+class PulseSensorChannels {
+  public:
+    /*
+       Constructs a beat finder for the given number of channels
+       (1 or more), sampled every 2 milliseconds (500 samples per second)
+       unless setSampleIntervalMicros() says otherwise.
+       getChannelCount() returns 0 if there wasn't enough memory.
+    */
+    PulseSensorChannels(int channelCount);
+    ~PulseSensorChannels();
+
+    // Returns the number of channels.
+    int getChannelCount();
+
+    // Start over on every channel, as if no samples had been seen.
+    void resetVariables();
+
+    // Set the time between frames, in microseconds.
+    void setSampleIntervalMicros(unsigned long intervalMicros);
+
+    // Set the threshold of the given channel, as PulseSensor::setThreshold().
+    void setThreshold(int channel, int threshold);
+
+    /*
+       Run the beat finder on one frame: frame[c] is the latest sample
+       (0..1023) of channel c.
+       Returns true if any channel found something; getFound() says what.
+    */
+    bool processFrame(const int16_t *frame);
+
+    /*
+       Returns the PulseSensor::FOUND_* flags the given channel found
+       in the latest frame: FOUND_BEAT_START, FOUND_BEAT_END,
+       FOUND_SIGNAL_LOST, or FOUND_FIRST_BEAT.
+    */
+    byte getFound(int channel);
+
+    /*
+       Run the beat finder over a recorded block of frames,
+       frameCount * getChannelCount() samples, one frame after another.
+       Stores the beats found in out, in order, as PulseSensor::processBlock()
+       does, with sensorIndex set to the channel.
+       Returns the number of beats found.
+    */
+    size_t processBlock(const int16_t *frames, size_t frameCount,
+      BeatEvent *out, size_t outCap);
+
+    // The latest results for the given channel, as from PulseSensor.
+    int getBeatsPerMinute(int channel);
+    int getInterBeatIntervalMs(int channel);
+    int getPulseAmplitude(int channel);
+    unsigned long getLastBeatTime(int channel);
+    bool isInsideBeat(int channel);
+
+  private:
+    PulseSensorChannels(const PulseSensorChannels &);            // not copyable.
+    PulseSensorChannels &operator=(const PulseSensorChannels &);
+
+    // (internal) The beat finder's work for a channel that found something.
+    void finishBeat(int channel);
+
+    int Count;                      // number of channels, or 0.
+
+    // For all channels.
+    unsigned long sampleIntervalMs; // whole milliseconds between frames.
+    word sampleIntervalFractionMicros; // and the microseconds left over (0..999).
+    word sampleFractionMicros;      // leftover microseconds not yet added to sampleCounter.
+    unsigned long sampleCounter;    // milliseconds since we started.
+
+    // One of each per channel. The names follow PulseSensor.
+    int16_t *P;                     // peak.
+    int16_t *T;                     // trough.
+    int16_t *thresh;                // threshold.
+    int16_t *threshSetting;         // threshold to return to when the signal is lost.
+    int16_t *sinceBeat;             // ms since the previous beat: PulseSensor's N.
+    int16_t *quietMs;               // ibi * 3 / 5: no new beat or trough until then.
+    int16_t *pulse;                 // 1 inside a beat, 0 outside.
+    int16_t *ibi;                   // inter-beat interval (ms).
+    int16_t *bpm;                   // beats per minute.
+    int16_t *pulseAmp;              // amplitude of the latest pulse wave.
+    byte *found;                    // FOUND_* flags from the latest frame.
+    byte *beatState;                // first beat and second beat flags.
+    unsigned long *beatTime;        // sampleCounter of the latest beat.
+    int16_t *rate;                  // ring of the latest IBIs, PULSE_SENSOR_IBI_WINDOW per channel.
+    byte *rateIndex;                // where in the ring the next IBI goes.
+    unsigned long *rateTotal;       // sum of the ring.
+};
+#endif // PULSE_SENSOR_CHANNELS_H
@@ -0,0 +1,128 @@
+/*
+   Band-pass filter for a PulseSensor's signal, ahead of the beat finder.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+#define FILTER_PI 3.14159265
+#define FILTER_COEFFICIENT_ONE 16384.0  // 1.0 in the low-pass coefficients (2^14).
+#define FILTER_HIGH_PASS_BITS 8         // extra bits of the high-pass output.
+#define FILTER_MAX_SHIFT 14
+#define FILTER_MIN_GAIN 4               // the least low-pass gain that keeps its corner in place.
+
+PulseSensorFilter::PulseSensorFilter(float lowHz, float highHz) {
+  LowHz = lowHz;
+  HighHz = highHz;
+  setCoefficients(PulseSensorPlayground::MICROS_PER_READ);
+}
+
+bool PulseSensorFilter::setSampleIntervalMicros(unsigned long intervalMicros) {
+  if (!canFilterAt(intervalMicros)) {
+    return false;
+  }
+  setCoefficients(intervalMicros);
+  return true;
+}
+
+bool PulseSensorFilter::canFilterAt(unsigned long intervalMicros) {
+  if (intervalMicros == 0) {
+    return false;
+  }
+  int16_t feedback1;
+  int16_t feedback2;
+  int16_t gain;
+  lowPass(1000000.0 / intervalMicros, feedback1, feedback2, gain);
+  return gain >= FILTER_MIN_GAIN;
+}
+
+void PulseSensorFilter::setCoefficients(unsigned long intervalMicros) {
+  SampleRate = 1000000.0 / intervalMicros;
+
+  // High-pass: the corner of y += x - x' - y / 2^k is about rate / (2 pi 2^k).
+  float perShift = SampleRate / (2.0 * FILTER_PI * LowHz);
+  Shift = 1;
+  while (Shift < FILTER_MAX_SHIFT && (float) (1UL << Shift) * 1.414 < perShift) {
+    ++Shift;
+  }
+
+  lowPass(SampleRate, Feedback1, Feedback2, Gain);
+  reset();
+}
+
+void PulseSensorFilter::lowPass(float sampleRate, int16_t &feedback1,
+  int16_t &feedback2, int16_t &gain) {
+  /*
+     Low-pass: a Butterworth biquad by the bilinear transform.
+     Above a tenth of the sample rate the 16-bit gain would overflow.
+     K = tan(pi * high / rate), from the first two terms of its series
+     (within 0.2% up to a tenth of the sample rate), so no tan() on AVR.
+     Below about 1/400 of the sample rate, the gain, 2^14 (1 + a1 + a2),
+     is under FILTER_MIN_GAIN: rounding a1 and a2 to 2^14 then moves the
+     corner a long way, and at 0 the output stops. canFilterAt() checks.
+  */
+  float high = HighHz < sampleRate / 10.0 ? HighHz : sampleRate / 10.0;
+  float w = FILTER_PI * high / sampleRate;
+  float k = w * (1.0 + w * w / 3.0);
+  float norm = 1.0 / (1.0 + 1.41421356 * k + k * k);
+  feedback1 = (int16_t) lround(2.0 * (k * k - 1.0) * norm * FILTER_COEFFICIENT_ONE);
+  feedback2 = (int16_t) lround((1.0 - 1.41421356 * k + k * k) * norm * FILTER_COEFFICIENT_ONE);
+  // From the rounded a1 and a2, so the gain at 0 Hz is exactly 1.
+  gain = (int16_t) ((long) FILTER_COEFFICIENT_ONE + feedback1 + feedback2);
+}
+
+void PulseSensorFilter::reset() {
+  Primed = false;
+  PreviousInput = 0;
+  HighPass = 0;
+  In1 = 0;
+  In2 = 0;
+  Out1 = 0;
+  Out2 = 0;
+  Residual = 0;
+}
+
+int PulseSensorFilter::filter(int sample) {
+  if (!Primed) {
+    // Start from the first sample, not from a step up to it.
+    PreviousInput = sample;
+    Primed = true;
+  }
+
+  HighPass += ((long) (sample - PreviousInput) << FILTER_HIGH_PASS_BITS)
+    - (HighPass >> Shift);
+  PreviousInput = sample;
+  long wave = (HighPass + (1L << (FILTER_HIGH_PASS_BITS - 1))) >> FILTER_HIGH_PASS_BITS;
+  int16_t in = (int16_t) (constrain(wave, -1023L, 1023L) * 4);
+
+  /*
+     out * 2^16 = gain * (in + 2 in' + in'') - 4 (a1 out' + a2 out''),
+     plus what was rounded off last time.
+  */
+  long sum = (long) Gain * (int16_t) (in + 2 * In1 + In2)
+    - 4 * ((long) Feedback1 * Out1 + (long) Feedback2 * Out2) + Residual;
+  int16_t out = (int16_t) (sum >> 16);
+  Residual = (word) (sum & 0xFFFF);
+  In2 = In1;
+  In1 = in;
+  Out2 = Out1;
+  Out1 = out;
+
+  int filtered = 512 + ((out + 2) >> 2);
+  return constrain(filtered, 0, 1023);
+}
+
+float PulseSensorFilter::getLowHz() {
+  return SampleRate / (2.0 * FILTER_PI * (1UL << Shift));
+}
@@ -0,0 +1,123 @@
+/*
+   Band-pass filter for a PulseSensor's signal, ahead of the beat finder.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_FILTER_H
+#define PULSE_SENSOR_FILTER_H
+
+#include <Arduino.h>
+
+/*
+   Default pass band, in Hz: a heart rate of 30 to 300 BPM, with room
+   for the harmonics that give the pulse its sharp upstroke.
+*/
+#ifndef PULSE_SENSOR_FILTER_LOW_HZ
+#define PULSE_SENSOR_FILTER_LOW_HZ 0.5
+#endif
+#ifndef PULSE_SENSOR_FILTER_HIGH_HZ
+#define PULSE_SENSOR_FILTER_HIGH_HZ 5.0
+#endif
+
+/*
+   Removes baseline wander (breathing, movement, the PulseSensor
+   settling) and mains hum from a PulseSensor's signal before the beat
+   finder sees it, so neither makes false beats, and a drifting signal
+   doesn't sit outside the threshold until the beat finder gives up.
+   For example:
+
+     PulseSensorFilter filter;
+     ...
+     pulseSensor.setFilter(filter);  // before begin().
+
+   Two stages, all in integer math, cheap enough for the sample ISR
+   on an AVR board: three 16-bit multiplies per sample.
+     high-pass  a first-order DC blocker, y += x - x' - y / 2^k, with its
+                corner at the power of 2 (k) nearest the low frequency.
+                A biquad high-pass at 0.5 Hz needs more than 16-bit
+                coefficients to stay stable; this needs none.
+     low-pass   a second-order Butterworth biquad at the high frequency,
+                16-bit coefficients, with the rounding error carried into
+                the next sample so the output doesn't creep or hum.
+
+   The low-pass needs its corner to be more than about 1/400 of the
+   sample rate: slower, and its 16-bit gain rounds to almost nothing,
+   moving the corner, then to 0, silencing the output. So the default
+   5 Hz works up to 2000 samples per second, and 3 Hz up to 1240.
+   setFilter() and setSampleRate() refuse rates the filter can't work at.
+
+   The output is centered on 512, so the threshold (550 by default)
+   works as before. getLatestSample() still returns the unfiltered
+   sample. The low-pass delays beats by about 30 ms at 5 Hz, the same
+   for every PulseSensor, so IBIs and Pulse Transit Times don't change.
+   A PulseSensorFilter holds the state for one PulseSensor.
+*/
+class PulseSensorFilter {
+  public:
+    /*
+       lowHz = the high-pass corner: wander below this is removed.
+       highHz = the low-pass corner: noise above this is removed.
+    */
+    PulseSensorFilter(float lowHz = PULSE_SENSOR_FILTER_LOW_HZ,
+      float highHz = PULSE_SENSOR_FILTER_HIGH_HZ);
+
+    /*
+       (internal to the library) Work out the coefficients for
+       a sample period of intervalMicros, and start again.
+       Returns false, and changes nothing, if the filter can't work
+       at that rate (see canFilterAt()).
+    */
+    bool setSampleIntervalMicros(unsigned long intervalMicros);
+
+    /*
+       Returns true if the low-pass works at a sample period of
+       intervalMicros: its corner isn't too small a fraction of the rate.
+    */
+    bool canFilterAt(unsigned long intervalMicros);
+
+    // (internal to the library) Forget the signal so far.
+    void reset();
+
+    /*
+       (internal to the library) Filter the next sample (0..1023).
+       Returns the filtered sample, centered on 512 (0..1023).
+    */
+    int filter(int sample);
+
+    // Returns the high-pass corner actually used, in Hz.
+    float getLowHz();
+
+  private:
+    // Set the coefficients for intervalMicros (not 0), whether or not they work.
+    void setCoefficients(unsigned long intervalMicros);
+
+    // Work out the low-pass coefficients for sampleRate.
+    void lowPass(float sampleRate, int16_t &feedback1, int16_t &feedback2, int16_t &gain);
+
+    float LowHz;                  // corners asked for.
+    float HighHz;
+    float SampleRate;             // samples per second.
+    byte Shift;                   // high-pass: k.
+    int16_t Feedback1;            // low-pass: a1 and a2, times 2^14.
+    int16_t Feedback2;
+    int16_t Gain;                 // low-pass: 4 * b0, times 2^14 (1 + a1 + a2), for a gain of 1.
+    bool Primed;                  // PreviousInput holds a sample.
+    int PreviousInput;            // high-pass: the last sample.
+    long HighPass;                // high-pass: the output, times 2^8.
+    int16_t In1;                  // low-pass: its last two inputs, times 4,
+    int16_t In2;
+    int16_t Out1;                 // and its last two outputs, times 4.
+    int16_t Out2;
+    word Residual;                // low-pass: rounding error carried to the next sample.
+};
+#endif // PULSE_SENSOR_FILTER_H
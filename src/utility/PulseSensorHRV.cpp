@@ -0,0 +1,167 @@
+/*
+   Heart rate variability (HRV) of a PulseSensor's beats,
+   updated beat by beat on the Arduino.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+/*
+   Each entry of pIBIs[] is an IBI in 0.1 ms (at most 2.5 seconds,
+   so 25000), with the top bit set if it directly follows the
+   entry before it, so the difference between them counts.
+*/
+#define HRV_IBI_MASK 0x7FFF
+#define HRV_SUCCESSIVE 0x8000
+#define HRV_MAX_IBI 25000
+#define HRV_NN50 500
+
+PulseSensorHRV::PulseSensorHRV(word *storage, byte capacity) {
+  pIBIs = storage;
+  Capacity = capacity;
+  ArtifactPercent = PULSE_SENSOR_HRV_ARTIFACT_PERCENT;
+  reset();
+}
+
+bool PulseSensorHRV::isValid() {
+  return pIBIs != NULL && Capacity >= 2;
+}
+
+void PulseSensorHRV::setArtifactLimit(byte percent) {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  ArtifactPercent = percent;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+
+void PulseSensorHRV::reset() {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  Count = 0;
+  Next = 0;
+  Successive = false;
+  PreviousIBI = 0;
+  Sum = 0;
+  SumSquares = 0;
+  DifferenceSquares = 0;
+  DifferenceCount = 0;
+  NN50Count = 0;
+  Rejected = 0;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+
+void PulseSensorHRV::removeOldest() {
+  // Once the window is full, the oldest entry is the one about to be replaced.
+  word oldest = pIBIs[Next] & HRV_IBI_MASK;
+  byte second = Next + 1 < Capacity ? Next + 1 : 0;
+  if (pIBIs[second] & HRV_SUCCESSIVE) {
+    long difference = (long) (pIBIs[second] & HRV_IBI_MASK) - oldest;
+    DifferenceSquares -= (unsigned long) (difference * difference);
+    --DifferenceCount;
+    if (abs(difference) > HRV_NN50) {
+      --NN50Count;
+    }
+    // The second is now the oldest: there's nothing before it.
+    pIBIs[second] &= HRV_IBI_MASK;
+  }
+  Sum -= oldest;
+  SumSquares -= (unsigned long) oldest * oldest;
+  --Count;
+}
+
+void PulseSensorHRV::addBeat(byte found, unsigned long ibiMicros) {
+  if (!isValid()) {
+    return;
+  }
+  if (found & PulseSensor::FOUND_SIGNAL_LOST) {
+    // The next IBI will be from the first beat after the gap.
+    Successive = false;
+    PreviousIBI = 0;
+    return;
+  }
+  if ((found & PulseSensor::FOUND_BEAT_START) == 0) {
+    return;
+  }
+
+  word ibi = (word) constrain((ibiMicros + 50) / 100, 1UL, (unsigned long) HRV_MAX_IBI);
+
+  // Compare with the previous IBI found, kept or not, so that
+  // a real change in heart rate costs one beat, not all the rest.
+  bool artifact = false;
+  if (PreviousIBI != 0 && ArtifactPercent != 0) {
+    long change = (long) ibi - PreviousIBI;
+    artifact = (unsigned long) abs(change) * 100 > (unsigned long) PreviousIBI * ArtifactPercent;
+  }
+  PreviousIBI = ibi;
+  if (artifact) {
+    ++Rejected;
+    Successive = false;
+    return;
+  }
+
+  if (Count >= Capacity) {
+    removeOldest();
+  }
+  word entry = ibi;
+  if (Successive && Count > 0) {
+    byte newest = Next > 0 ? Next - 1 : Capacity - 1;
+    long difference = (long) ibi - (pIBIs[newest] & HRV_IBI_MASK);
+    DifferenceSquares += (unsigned long) (difference * difference);
+    ++DifferenceCount;
+    if (abs(difference) > HRV_NN50) {
+      ++NN50Count;
+    }
+    entry |= HRV_SUCCESSIVE;
+  }
+  pIBIs[Next] = entry;
+  if (++Next >= Capacity) {
+    Next = 0;
+  }
+  ++Count;
+  Sum += ibi;
+  SumSquares += (unsigned long) ibi * ibi;
+  Successive = true;
+}
+
+bool PulseSensorHRV::getMetrics(HRVMetrics &metrics) {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  byte count = Count;
+  byte differences = DifferenceCount;
+  byte nn50 = NN50Count;
+  unsigned long sum = Sum;
+  unsigned long long sumSquares = SumSquares;
+  unsigned long long differenceSquares = DifferenceSquares;
+  unsigned long rejected = Rejected;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+
+  if (differences == 0) {
+    return false;
+  }
+
+  /*
+     The sums are exact integers, so the variance can be taken
+     from them without the rounding error adding up beat by beat:
+     (n * sum of squares - sum * sum) / (n * (n - 1)), in 0.01 ms^2.
+  */
+  unsigned long long spread = (unsigned long long) count * sumSquares
+    - (unsigned long long) sum * sum;
+  float variance = (float) spread / ((float) count * (count - 1));
+
+  metrics.intervals = count;
+  metrics.differences = differences;
+  metrics.meanIBIMs = (float) sum / count / 10.0;
+  metrics.sdnnMs = sqrt(variance) / 10.0;
+  metrics.rmssdMs = sqrt((float) differenceSquares / differences) / 10.0;
+  metrics.pnn50Percent = 100.0 * nn50 / differences;
+  metrics.rejected = rejected;
+  return true;
+}
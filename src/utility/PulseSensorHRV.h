@@ -0,0 +1,119 @@
+/*
+   Heart rate variability (HRV) of a PulseSensor's beats,
+   updated beat by beat on the Arduino.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_HRV_H
+#define PULSE_SENSOR_HRV_H
+
+#include <Arduino.h>
+
+/*
+   By default, an IBI that differs from the one before it by more
+   than this percent is taken to be a missed or extra beat, not
+   heart rate variability, and left out. See setArtifactLimit().
+*/
+#ifndef PULSE_SENSOR_HRV_ARTIFACT_PERCENT
+#define PULSE_SENSOR_HRV_ARTIFACT_PERCENT 30
+#endif
+
+/*
+   HRV measures over a PulseSensorHRV's window. See getHRV().
+*/
+struct HRVMetrics {
+  byte intervals;          // IBIs in the window.
+  byte differences;        // differences between successive IBIs in the window.
+  float meanIBIMs;         // average IBI (ms).
+  float sdnnMs;            // SDNN: standard deviation of the IBIs (ms).
+  float rmssdMs;           // RMSSD: root mean square of the successive differences (ms).
+  float pnn50Percent;      // pNN50: percent of successive differences over 50 ms.
+  unsigned long rejected;  // IBIs left out as artifacts, since reset().
+};
+
+/*
+   Keeps the latest IBIs of one PulseSensor, and running sums of them,
+   so each beat costs the same few additions however long the window,
+   and HRV can be read at any time without going through the window.
+
+   The Sketch owns the storage, one word per IBI, so it decides the
+   window and how much RAM to spend. For example, for the last 64 beats
+   (about a minute):
+
+     word ibiStorage[64];
+     PulseSensorHRV hrv(ibiStorage, 64);
+     ...
+     pulseSensor.setHRV(hrv);  // before begin().
+     ...
+     HRVMetrics metrics;
+     if (pulseSensor.getHRV(metrics)) {
+       Serial.println(metrics.rmssdMs);
+     }
+
+   IBIs are kept to 0.1 ms: set PULSE_SENSOR_INTERPOLATE_BEATS to true
+   (in PulseSensor.h) so they're measured more finely than a sample period.
+   When the PulseSensor loses the signal, the IBIs so far stay in
+   the window, but the next IBI isn't taken as following the last one.
+*/
+class PulseSensorHRV {
+  public:
+    /*
+       storage = where to keep the window of IBIs.
+       capacity = the number of IBIs in the window: 2..255.
+    */
+    PulseSensorHRV(word *storage, byte capacity);
+
+    // Returns true if the storage is usable.
+    bool isValid();
+
+    /*
+       Set how much an IBI may differ from the one before it,
+       in percent, before it's left out. 0 keeps every IBI.
+    */
+    void setArtifactLimit(byte percent);
+
+    // Empty the window.
+    void reset();
+
+    /*
+       Copy the HRV measures of the window into metrics.
+       Returns false, leaving metrics alone, if the window
+       doesn't yet hold two successive IBIs.
+    */
+    bool getMetrics(HRVMetrics &metrics);
+
+    /*
+       (internal to the library) The PulseSensor found something.
+       found = its FOUND_* flags; ibiMicros = the IBI (us) of a new beat.
+    */
+    void addBeat(byte found, unsigned long ibiMicros);
+
+  private:
+    // (internal to the library) Take the oldest IBI out of the window.
+    void removeOldest();
+
+    word *pIBIs;                  // the window: IBIs in 0.1 ms, oldest at Next once full.
+    byte Capacity;                // room in pIBIs[].
+    volatile byte Count;          // IBIs in the window.
+    byte Next;                    // where in pIBIs[] the next IBI goes.
+    byte ArtifactPercent;         // see setArtifactLimit().
+    bool Successive;              // the next IBI follows the newest in the window.
+    word PreviousIBI;             // the last IBI found, whether kept or not; 0 if none.
+    unsigned long Sum;            // sum of the IBIs in the window.
+    unsigned long long SumSquares; // sum of their squares.
+    unsigned long long DifferenceSquares; // sum of the squared successive differences.
+    volatile byte DifferenceCount; // successive differences in the window.
+    byte NN50Count;               // those over 50 ms.
+    unsigned long Rejected;       // IBIs left out as artifacts.
+};
+#endif // PULSE_SENSOR_HRV_H
@@ -0,0 +1,117 @@
+/*
+   Serial output queue for the PulseSensor Playground.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include "PulseSensorOutputQueue.h"
+
+PulseSensorOutputQueue::PulseSensorOutputQueue() {
+  begin(NULL, 0);
+}
+
+void PulseSensorOutputQueue::begin(byte *storage, word size) {
+  pStorage = size > 0 ? storage : NULL;
+  Size = pStorage ? size : 0;
+  Head = 0;
+  Tail = 0;
+  Count = 0;
+  MessageHead = 0;
+  MessageCount = 0;
+  Overflowed = false;
+  Drops = 0;
+}
+
+bool PulseSensorOutputQueue::isActive() {
+  return pStorage != NULL;
+}
+
+void PulseSensorOutputQueue::beginMessage() {
+  MessageHead = Head;
+  MessageCount = Count;
+  Overflowed = false;
+}
+
+bool PulseSensorOutputQueue::endMessage() {
+  if (!Overflowed) {
+    return true;
+  }
+  // Take back the part that fit.
+  Head = MessageHead;
+  Count = MessageCount;
+  Overflowed = false;
+  ++Drops;
+  return false;
+}
+
+size_t PulseSensorOutputQueue::write(uint8_t c) {
+  if (Overflowed || Count >= Size) {
+    Overflowed = true;
+    return 0;
+  }
+  pStorage[Head] = c;
+  if (++Head >= Size) {
+    Head = 0;
+  }
+  ++Count;
+  return 1;
+}
+
+size_t PulseSensorOutputQueue::write(const uint8_t *buffer, size_t size) {
+  if (Overflowed || size > (size_t) (Size - Count)) {
+    Overflowed = true;
+    return 0;
+  }
+  for (size_t i = 0; i < size; ++i) {
+    pStorage[Head] = buffer[i];
+    if (++Head >= Size) {
+      Head = 0;
+    }
+  }
+  Count += size;
+  return size;
+}
+
+void PulseSensorOutputQueue::drain(Print &output) {
+  while (Count > 0) {
+    int room = output.availableForWrite();
+    if (room <= 0) {
+      return;
+    }
+    // Write up to the end of the storage; wrap on the next pass.
+    word n = Size - Tail;
+    if (n > Count) {
+      n = Count;
+    }
+    if (n > (word) room) {
+      n = (word) room;
+    }
+    n = output.write(pStorage + Tail, n);
+    if (n == 0) {
+      return;
+    }
+    Tail += n;
+    if (Tail >= Size) {
+      Tail = 0;
+    }
+    Count -= n;
+  }
+}
+
+word PulseSensorOutputQueue::getQueued() {
+  return Count;
+}
+
+unsigned long PulseSensorOutputQueue::getDrops() {
+  return Drops;
+}
@@ -0,0 +1,81 @@
+/*
+   Serial output queue for the PulseSensor Playground.
+   Holds formatted output until the Serial port has room for it,
+   so that printing never waits for the port.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_OUTPUT_QUEUE_H
+#define PULSE_SENSOR_OUTPUT_QUEUE_H
+
+#include <Arduino.h>
+
+/*
+   A Print that stores what's printed to it, a message at a time.
+   A message that doesn't fit is dropped whole and counted,
+   so the other end never sees part of one.
+
+   Used by the Sketch's loop() only; not by the sample ISR.
+*/
+class PulseSensorOutputQueue : public Print {
+  public:
+    PulseSensorOutputQueue();
+
+    /*
+       Use the given storage for the queue, or stop queuing if NULL.
+       Any size works.
+    */
+    void begin(byte *storage, word size);
+
+    // Returns true if begin() was given storage.
+    bool isActive();
+
+    // Start a message. Everything printed until endMessage() is kept or dropped together.
+    void beginMessage();
+
+    /*
+       End a message.
+       Returns true if it was queued; false if it was dropped for lack of room.
+    */
+    bool endMessage();
+
+    /*
+       Write as much of the queue to output as output can take
+       without waiting, according to its availableForWrite().
+       Call between messages, not during one.
+    */
+    void drain(Print &output);
+
+    // Returns the number of bytes waiting to be written.
+    word getQueued();
+
+    // Returns the number of messages dropped because the queue was full.
+    unsigned long getDrops();
+
+    // Print interface.
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+
+  private:
+    byte *pStorage;             // the caller's storage, or NULL.
+    word Size;                  // bytes in pStorage.
+    word Head;                  // where the next byte goes.
+    word Tail;                  // the oldest byte not yet written.
+    word Count;                 // bytes queued, including the current message.
+    word MessageHead;           // Head when the current message began.
+    word MessageCount;          // Count when the current message began.
+    bool Overflowed;            // the current message didn't fit.
+    unsigned long Drops;        // messages dropped.
+};
+#endif // PULSE_SENSOR_OUTPUT_QUEUE_H
@@ -0,0 +1,179 @@
+/*
+   Writes PulseSensor samples and beats in a compact binary recording
+   format, for example to an SD card file.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+/*
+   The most bytes a frame can take: a sample difference is -65535..65535,
+   which zigzag encodes to 17 bits, or 3 bytes.
+   Room for a beat from every PulseSensor is kept free too.
+*/
+#define MAX_SAMPLE_BYTES 3
+
+PulseSensorRecorder::PulseSensorRecorder() {
+  pOut = NULL;
+  pStorage = NULL;
+  StorageSize = 0;
+  SensorCount = 0;
+  FrameCount = 0;
+}
+
+bool PulseSensorRecorder::begin(Print &out, byte *storage, word storageSize,
+  byte sensorCount, unsigned long sampleIntervalMicros, const int *thresholds) {
+  pOut = NULL;
+  if (!storage || sensorCount == 0 || storageSize < 16 * (word) sensorCount) {
+    return false;
+  }
+  pStorage = storage;
+  StorageSize = storageSize;
+  SensorCount = sensorCount;
+  ChunkStart = 2 * sensorCount; // after the previous samples.
+  SampleEnd = ChunkStart;
+  BeatStart = StorageSize;
+  ChunkFrames = 0;
+  ChunkBeats = 0;
+  FrameCount = 0;
+  ChunkFirstFrame = 0;
+  WriteFailed = false;
+  pOut = &out;
+
+  byte magic[4] = { 'P', 'S', 'R', '1' };
+  writeBytes(magic, 4);
+  writeWord(PULSE_SENSOR_RECORDING_HEADER_BYTES + 2 * sensorCount);
+  byte version[2] = { PULSE_SENSOR_RECORDING_VERSION, sensorCount };
+  writeBytes(version, 2);
+  writeLong(sampleIntervalMicros);
+  writeLong(0);
+  for (int i = 0; i < sensorCount; ++i) {
+    writeWord(thresholds ? (word) (int16_t) thresholds[i] : 0);
+  }
+  return !WriteFailed;
+}
+
+bool PulseSensorRecorder::addFrame(const int16_t *samples) {
+  if (!pOut) {
+    return false; // no begin().
+  }
+  word worstCase = (MAX_SAMPLE_BYTES + PULSE_SENSOR_RECORDING_BEAT_BYTES) * SensorCount;
+  if (BeatStart - SampleEnd < worstCase) {
+    flush();
+  }
+
+  if (ChunkFrames == 0) {
+    // The chunk's first frame, as-is, so the chunk can be decoded on its own.
+    ChunkFirstFrame = FrameCount;
+    for (int i = 0; i < SensorCount; ++i) {
+      word sample = (word) samples[i];
+      pStorage[SampleEnd++] = sample & 0xFF;
+      pStorage[SampleEnd++] = sample >> 8;
+    }
+  } else {
+    for (int i = 0; i < SensorCount; ++i) {
+      int16_t previous = (int16_t) (pStorage[2 * i] | (pStorage[2 * i + 1] << 8));
+      long difference = (long) samples[i] - previous;
+      unsigned long zigzag = difference < 0
+        ? ((unsigned long) (-difference) << 1) - 1
+        : (unsigned long) difference << 1;
+      while (zigzag >= 0x80) {
+        pStorage[SampleEnd++] = (zigzag & 0x7F) | 0x80;
+        zigzag >>= 7;
+      }
+      pStorage[SampleEnd++] = zigzag;
+    }
+  }
+  for (int i = 0; i < SensorCount; ++i) {
+    word sample = (word) samples[i];
+    pStorage[2 * i] = sample & 0xFF;
+    pStorage[2 * i + 1] = sample >> 8;
+  }
+  ++ChunkFrames;
+  ++FrameCount;
+  return !WriteFailed;
+}
+
+bool PulseSensorRecorder::addBeat(byte sensorIndex, int beatsPerMinute,
+  int interBeatIntervalMs) {
+  if (!pOut || ChunkFrames == 0
+    || BeatStart - SampleEnd < PULSE_SENSOR_RECORDING_BEAT_BYTES) {
+    return false;
+  }
+  // Beats are stored from the end of storage down, and written in the order added.
+  BeatStart -= PULSE_SENSOR_RECORDING_BEAT_BYTES;
+  byte *pBeat = pStorage + BeatStart;
+  word frame = ChunkFrames - 1;
+  word bpm = constrain(beatsPerMinute, 0, 65535);
+  word ibi = constrain(interBeatIntervalMs, 0, 65535);
+  pBeat[0] = frame & 0xFF;
+  pBeat[1] = frame >> 8;
+  pBeat[2] = sensorIndex;
+  pBeat[3] = 0;
+  pBeat[4] = bpm & 0xFF;
+  pBeat[5] = bpm >> 8;
+  pBeat[6] = ibi & 0xFF;
+  pBeat[7] = ibi >> 8;
+  ++ChunkBeats;
+  return !WriteFailed;
+}
+
+bool PulseSensorRecorder::flush() {
+  if (!pOut) {
+    return false;
+  }
+  if (ChunkFrames == 0) {
+    return !WriteFailed;
+  }
+
+  word sampleBytes = SampleEnd - ChunkStart;
+  byte magic[2] = { 'C', 'K' };
+  writeBytes(magic, 2);
+  writeWord(sampleBytes + ChunkBeats * PULSE_SENSOR_RECORDING_BEAT_BYTES);
+  writeLong(ChunkFirstFrame);
+  writeWord(ChunkFrames);
+  writeWord(ChunkBeats);
+  writeBytes(pStorage + ChunkStart, sampleBytes);
+  for (word b = 0; b < ChunkBeats; ++b) {
+    writeBytes(pStorage + StorageSize - (b + 1) * PULSE_SENSOR_RECORDING_BEAT_BYTES,
+      PULSE_SENSOR_RECORDING_BEAT_BYTES);
+  }
+
+  SampleEnd = ChunkStart;
+  BeatStart = StorageSize;
+  ChunkFrames = 0;
+  ChunkBeats = 0;
+  return !WriteFailed;
+}
+
+unsigned long PulseSensorRecorder::getFrameCount() {
+  return FrameCount;
+}
+
+void PulseSensorRecorder::writeBytes(const byte *data, word count) {
+  if (count > 0 && pOut->write(data, count) != count) {
+    WriteFailed = true;
+  }
+}
+
+void PulseSensorRecorder::writeWord(word value) {
+  byte bytes[2] = { (byte) (value & 0xFF), (byte) (value >> 8) };
+  writeBytes(bytes, 2);
+}
+
+void PulseSensorRecorder::writeLong(unsigned long value) {
+  byte bytes[4] = { (byte) (value & 0xFF), (byte) ((value >> 8) & 0xFF),
+    (byte) ((value >> 16) & 0xFF), (byte) ((value >> 24) & 0xFF) };
+  writeBytes(bytes, 4);
+}
@@ -0,0 +1,156 @@
+/*
+   Writes PulseSensor samples and beats in a compact binary recording
+   format, for example to an SD card file.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_RECORDER_H
+#define PULSE_SENSOR_RECORDER_H
+
+#include <Arduino.h>
+
+/*
+   The recording format. All numbers are little-endian.
+
+   Header:
+     'P' 'S' 'R' '1'
+     word   header size, in bytes (16 + 2 per PulseSensor)
+     byte   format version (1)
+     byte   number of PulseSensors
+     4 bytes sample interval (microseconds)
+     4 bytes reserved (0)
+     int16  threshold of each PulseSensor
+
+   Then any number of chunks. Each chunk can be decoded on its own:
+     'C' 'K'
+     word   payload size, in bytes (everything after this 12-byte header)
+     4 bytes number of the chunk's first frame, counting from 0
+     word   number of frames in the chunk
+     word   number of beats in the chunk
+     payload:
+       samples: the first frame as an int16 per PulseSensor, then each
+         later sample as the difference from the PulseSensor's previous
+         sample, zigzag encoded (0, -1, 1, -2, 2... as 0, 1, 2, 3, 4...)
+         7 bits a byte, low bits first, the top bit set on all but the last.
+         Most differences fit in 1 byte.
+       beats: 8 bytes per beat, in order:
+         word  frame, from the chunk's first frame
+         byte  PulseSensor
+         byte  reserved (0)
+         word  beats per minute
+         word  inter-beat interval (ms)
+
+   A frame is a sample from every PulseSensor; frame n was sampled
+   n sample intervals after the recording began.
+
+   Tools on a computer may end the file with an index of the chunks,
+   so a reader can find any time without reading the whole recording:
+     per chunk: 4 bytes first frame, 8 bytes file offset of the chunk.
+     'P' 'S' 'R' 'X'
+     4 bytes number of chunks
+     8 bytes file offset of the index
+   Recordings made by PulseSensorRecorder don't have an index.
+*/
+#define PULSE_SENSOR_RECORDING_VERSION 1
+#define PULSE_SENSOR_RECORDING_HEADER_BYTES 16
+#define PULSE_SENSOR_RECORDING_CHUNK_HEADER_BYTES 12
+#define PULSE_SENSOR_RECORDING_BEAT_BYTES 8
+#define PULSE_SENSOR_RECORDING_INDEX_ENTRY_BYTES 12
+#define PULSE_SENSOR_RECORDING_FOOTER_BYTES 16
+
+/*
+   Writes a recording to a Print, a chunk at a time.
+   A chunk is collected in storage the Sketch provides; the bigger
+   the storage, the bigger (and fewer) the chunks. 256 bytes per
+   PulseSensor holds about 200 sample periods at a time.
+
+   For example, with an SD card file:
+     byte recordStorage[512];
+     PulseSensorRecorder recorder;
+     ...
+     recorder.begin(file, recordStorage, sizeof(recordStorage),
+       1, pulseSensor.getSampleIntervalMicros());
+     ...
+     if (pulseSensor.sawNewSample()) {
+       int16_t sample = pulseSensor.getLatestSample();
+       recorder.addFrame(&sample);
+       if (pulseSensor.sawStartOfBeat()) {
+         recorder.addBeat(0, pulseSensor.getBeatsPerMinute(),
+           pulseSensor.getInterBeatIntervalMs());
+       }
+     }
+     ...
+     recorder.flush(); // before closing the file.
+
+   Used by the Sketch's loop() only; not by the sample ISR.
+*/
+class PulseSensorRecorder {
+  public:
+    PulseSensorRecorder();
+
+    /*
+       Start a recording: write its header to out.
+       storage = where to collect each chunk; at least 16 bytes
+         per PulseSensor, and no more than 65535 bytes are used.
+       sensorCount = number of PulseSensors in each frame (1..255).
+       sampleIntervalMicros = time between frames.
+       thresholds = each PulseSensor's threshold, or NULL (0).
+       Returns false if storage is too small or the header couldn't be written.
+    */
+    bool begin(Print &out, byte *storage, word storageSize, byte sensorCount,
+      unsigned long sampleIntervalMicros, const int *thresholds = NULL);
+
+    /*
+       Add a frame: samples[i] is the latest sample of PulseSensor i.
+       Writes the current chunk first if this frame might not fit.
+       Returns false if writing failed.
+    */
+    bool addFrame(const int16_t *samples);
+
+    /*
+       Add a beat, found on the latest frame.
+       Returns false if there's no frame to add it to
+       (no frame since begin() or flush()), or if writing failed.
+    */
+    bool addBeat(byte sensorIndex, int beatsPerMinute, int interBeatIntervalMs);
+
+    /*
+       Write the current chunk, if it has any frames.
+       Call before closing the file.
+       Returns false if writing failed.
+    */
+    bool flush();
+
+    // Returns the number of frames added since begin().
+    unsigned long getFrameCount();
+
+  private:
+    // (internal to the library) Write bytes to pOut, noting any failure.
+    void writeBytes(const byte *data, word count);
+    void writeWord(word value);
+    void writeLong(unsigned long value);
+
+    Print *pOut;                // where the recording goes, or NULL before begin().
+    byte *pStorage;             // the caller's storage: previous samples, then the chunk.
+    word StorageSize;           // bytes in pStorage.
+    byte SensorCount;           // PulseSensors per frame.
+    word ChunkStart;            // where chunk samples start in pStorage.
+    word SampleEnd;             // where the next sample byte goes.
+    word BeatStart;             // beats are stored downwards from the end of pStorage.
+    word ChunkFrames;           // frames in the current chunk.
+    word ChunkBeats;            // beats in the current chunk.
+    unsigned long FrameCount;   // frames since begin().
+    unsigned long ChunkFirstFrame; // number of the current chunk's first frame.
+    bool WriteFailed;           // a write since begin() wrote less than asked.
+};
+#endif // PULSE_SENSOR_RECORDER_H
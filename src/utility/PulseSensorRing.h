@@ -0,0 +1,140 @@
+/*
+   Lock-free single-producer, single-consumer ring buffer.
+   The PulseSensor sampling code (usually an Interrupt Service Routine)
+   puts items in, and the Sketch's loop() takes them out.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_RING_H
+#define PULSE_SENSOR_RING_H
+
+#include <Arduino.h>
+#include "SelectTimer.h"
+
+/*
+   Head and Tail must be read and written in one instruction, so that
+   neither side ever sees half of an update. That's one byte on AVR,
+   which limits an AVR ring to 128 items.
+
+   The barrier keeps the compiler (and, on multi-core chips, the CPU)
+   from moving item reads and writes past the Head and Tail updates.
+*/
+#if defined(ARDUINO_ARCH_AVR)
+typedef uint8_t PulseSensorRingIndex;
+#define PULSE_SENSOR_RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+#else
+typedef unsigned int PulseSensorRingIndex;
+#define PULSE_SENSOR_RING_BARRIER() __sync_synchronize()
+#endif
+
+#define PULSE_SENSOR_RING_MAX_CAPACITY \
+  ((PulseSensorRingIndex) (((PulseSensorRingIndex) ~0) / 2 + 1))
+
+template <typename T>
+class PulseSensorRing {
+  public:
+    PulseSensorRing() {
+      pItems = NULL;
+      Mask = 0;
+      Head = 0;
+      Tail = 0;
+      Overruns = 0;
+    }
+
+    /*
+       Use the given storage for the ring.
+
+       capacity must be a power of 2 (2, 4, 8, 16...), no larger than
+       PULSE_SENSOR_RING_MAX_CAPACITY (128 on AVR). It's checked before
+       it's narrowed to a PulseSensorRingIndex, so 256 is refused on AVR
+       rather than taken for 0.
+       Returns false, and leaves the ring unusable, otherwise.
+       Call this before the producer starts.
+    */
+    bool begin(T *storage, size_t capacity) {
+      if (!storage || capacity == 0 || capacity > PULSE_SENSOR_RING_MAX_CAPACITY
+        || (capacity & (capacity - 1)) != 0) {
+        pItems = NULL;
+        return false;
+      }
+      pItems = storage;
+      Mask = (PulseSensorRingIndex) (capacity - 1);
+      Head = 0;
+      Tail = 0;
+      Overruns = 0;
+      return true;
+    }
+
+    /*
+       (producer) Add an item. If the ring is full, the item is dropped,
+       the overrun count goes up, and this returns false.
+    */
+    bool put(const T &item) {
+      if (!pItems) {
+        return false;
+      }
+      PulseSensorRingIndex head = Head;
+      if ((PulseSensorRingIndex) (head - Tail) > Mask) {
+        ++Overruns;
+        return false;
+      }
+      pItems[head & Mask] = item;
+      PULSE_SENSOR_RING_BARRIER();
+      Head = head + 1;
+      return true;
+    }
+
+    /*
+       (consumer) Copy up to n of the oldest items into out,
+       and remove them from the ring.
+       Returns the number of items copied.
+    */
+    PulseSensorRingIndex get(T *out, PulseSensorRingIndex n) {
+      if (!pItems) {
+        return 0;
+      }
+      PulseSensorRingIndex tail = Tail;
+      PulseSensorRingIndex count = Head - tail;
+      PULSE_SENSOR_RING_BARRIER();
+      if (count > n) {
+        count = n;
+      }
+      for (PulseSensorRingIndex i = 0; i < count; ++i) {
+        out[i] = pItems[(PulseSensorRingIndex) (tail + i) & Mask];
+      }
+      PULSE_SENSOR_RING_BARRIER();
+      Tail = tail + count;
+      return count;
+    }
+
+    // (consumer) Returns the number of items waiting to be read.
+    PulseSensorRingIndex available() {
+      return (PulseSensorRingIndex) (Head - Tail);
+    }
+
+    // (consumer) Returns the number of items dropped because the ring was full.
+    unsigned long getOverruns() {
+      DISABLE_PULSE_SENSOR_INTERRUPTS;
+      unsigned long overruns = Overruns;
+      ENABLE_PULSE_SENSOR_INTERRUPTS;
+      return overruns;
+    }
+
+  private:
+    T *pItems;                           // the caller's storage, or NULL.
+    PulseSensorRingIndex Mask;           // capacity - 1.
+    volatile PulseSensorRingIndex Head;  // count of items put. Written by the producer only.
+    volatile PulseSensorRingIndex Tail;  // count of items taken. Written by the consumer only.
+    volatile unsigned long Overruns;     // items dropped because the ring was full.
+};
+#endif // PULSE_SENSOR_RING_H
@@ -0,0 +1,258 @@
+/*
+   Compresses PulseSensor samples into small packets, for links
+   that can't carry every sample as text: BLE, WiFi, or an SD card.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+/*
+   Rice parameter adaptation, the same in the encoder and decoder.
+   Each PulseSensor keeps the sum of its recent zigzag differences
+   (each counted as at most SIZE_CAP, so a spike doesn't upset k for long),
+   and k is the smallest with (count << k) >= sum: about log2 of the
+   average difference. The sums are halved every SIZE_WINDOW frames,
+   so k follows the signal as it speeds up and slows down.
+*/
+#define SIZE_START 8
+#define SIZE_CAP 2047
+#define SIZE_WINDOW 16
+#define ESCAPE_BITS 17 // enough for any zigzag difference of two int16 samples.
+
+static byte riceParameter(word sum, byte count) {
+  byte k = 0;
+  while (((unsigned long) count << k) < sum && k < 15) {
+    ++k;
+  }
+  return k;
+}
+
+static unsigned long zigzag(int16_t sample, int16_t previous) {
+  long difference = (long) sample - previous;
+  return difference < 0
+    ? ((unsigned long) (-difference) << 1) - 1
+    : (unsigned long) difference << 1;
+}
+
+static byte riceBits(unsigned long z, byte k) {
+  unsigned long q = z >> k;
+  return q < PULSE_SENSOR_ENCODER_ESCAPE
+    ? (byte) q + 1 + k
+    : PULSE_SENSOR_ENCODER_ESCAPE + ESCAPE_BITS;
+}
+
+PulseSensorSampleEncoder::PulseSensorSampleEncoder() {
+  pPacket = NULL;
+  PacketSize = 0;
+  BitCount = 0;
+  SensorCount = 0;
+  Sequence = 0;
+  FrameCount = 0;
+  SizeCount = 0;
+}
+
+bool PulseSensorSampleEncoder::begin(byte *packet, word packetSize, byte sensorCount) {
+  pPacket = NULL;
+  if (!packet || sensorCount == 0 || sensorCount > PULSE_SENSOR_ENCODER_MAX_SENSORS
+    || packetSize < PULSE_SENSOR_ENCODER_HEADER_BYTES + 2 * sensorCount
+    || packetSize > 8191) {
+    return false;
+  }
+  pPacket = packet;
+  PacketSize = packetSize;
+  SensorCount = sensorCount;
+  Sequence = 0xFF; // so the first packet is number 0.
+  startPacket();
+  return true;
+}
+
+void PulseSensorSampleEncoder::startPacket() {
+  if (!pPacket) {
+    return; // no begin().
+  }
+  ++Sequence;
+  pPacket[0] = Sequence;
+  pPacket[1] = SensorCount;
+  pPacket[2] = 0;
+  FrameCount = 0;
+  BitCount = 0;
+}
+
+word PulseSensorSampleEncoder::frameBits(const int16_t *samples) {
+  word bits = 0;
+  for (byte i = 0; i < SensorCount; ++i) {
+    bits += riceBits(zigzag(samples[i], Previous[i]),
+      riceParameter(SizeSum[i], SizeCount));
+  }
+  return bits;
+}
+
+bool PulseSensorSampleEncoder::addFrame(const int16_t *samples) {
+  if (!pPacket || FrameCount == 255) {
+    return false;
+  }
+  word bits = FrameCount == 0 ? 16 * SensorCount : frameBits(samples);
+  if (PULSE_SENSOR_ENCODER_HEADER_BYTES + (((unsigned long) BitCount + bits + 7) >> 3)
+    > PacketSize) {
+    return false; // doesn't fit.
+  }
+
+  if (FrameCount == 0) {
+    // The first frame, as-is, so the packet can be decoded on its own.
+    for (byte i = 0; i < SensorCount; ++i) {
+      writeBits((word) samples[i], 16);
+      Previous[i] = samples[i];
+      SizeSum[i] = SIZE_START;
+    }
+    SizeCount = 1;
+  } else {
+    for (byte i = 0; i < SensorCount; ++i) {
+      unsigned long z = zigzag(samples[i], Previous[i]);
+      byte k = riceParameter(SizeSum[i], SizeCount);
+      unsigned long q = z >> k;
+      if (q < PULSE_SENSOR_ENCODER_ESCAPE) {
+        writeBits((1UL << q) - 1, (byte) q + 1); // q 1 bits, then a 0 bit.
+        writeBits(z, k);
+      } else {
+        writeBits((1UL << PULSE_SENSOR_ENCODER_ESCAPE) - 1, PULSE_SENSOR_ENCODER_ESCAPE);
+        writeBits(z, ESCAPE_BITS);
+      }
+      Previous[i] = samples[i];
+      SizeSum[i] += z < SIZE_CAP ? (word) z : SIZE_CAP;
+    }
+    if (++SizeCount >= SIZE_WINDOW) {
+      SizeCount /= 2;
+      for (byte i = 0; i < SensorCount; ++i) {
+        SizeSum[i] /= 2;
+      }
+    }
+  }
+  pPacket[2] = ++FrameCount;
+  return true;
+}
+
+void PulseSensorSampleEncoder::writeBits(unsigned long value, byte count) {
+  value &= (1UL << count) - 1;
+  while (count > 0) {
+    byte *pByte = pPacket + PULSE_SENSOR_ENCODER_HEADER_BYTES + (BitCount >> 3);
+    byte offset = BitCount & 7;
+    if (offset == 0) {
+      *pByte = 0;
+    }
+    *pByte |= (byte) (value << offset);
+    byte n = 8 - offset;
+    if (n > count) {
+      n = count;
+    }
+    value >>= n;
+    count -= n;
+    BitCount += n;
+  }
+}
+
+const byte *PulseSensorSampleEncoder::getPacket() {
+  return pPacket;
+}
+
+word PulseSensorSampleEncoder::getPacketLength() {
+  return pPacket ? PULSE_SENSOR_ENCODER_HEADER_BYTES + ((BitCount + 7) >> 3) : 0;
+}
+
+byte PulseSensorSampleEncoder::getFrameCount() {
+  return FrameCount;
+}
+
+/*
+   Reads a packet's bits, least significant bit of each byte first.
+*/
+class PacketBitReader {
+  public:
+    PacketBitReader(const byte *bits, word length)
+      : pBits(bits), BitsLeft((unsigned long) length * 8), Position(0), Overrun(false) {
+    }
+
+    unsigned long read(byte count) {
+      unsigned long value = 0;
+      for (byte i = 0; i < count; ++i) {
+        value |= (unsigned long) readBit() << i;
+      }
+      return value;
+    }
+
+    byte readBit() {
+      if (Position >= BitsLeft) {
+        Overrun = true;
+        return 0;
+      }
+      byte bit = (pBits[Position >> 3] >> (Position & 7)) & 1;
+      ++Position;
+      return bit;
+    }
+
+    bool overran() { return Overrun; }
+
+  private:
+    const byte *pBits;
+    unsigned long BitsLeft;
+    unsigned long Position;
+    bool Overrun;
+};
+
+int PulseSensorSampleEncoder::decodePacket(const byte *packet, word length,
+  int16_t *samples, word maxSamples) {
+  if (length < PULSE_SENSOR_ENCODER_HEADER_BYTES) {
+    return -1;
+  }
+  byte sensorCount = packet[1];
+  byte frameCount = packet[2];
+  if (sensorCount == 0 || sensorCount > PULSE_SENSOR_ENCODER_MAX_SENSORS
+    || (word) sensorCount * frameCount > maxSamples) {
+    return -1;
+  }
+
+  PacketBitReader bits(packet + PULSE_SENSOR_ENCODER_HEADER_BYTES,
+    length - PULSE_SENSOR_ENCODER_HEADER_BYTES);
+  word sizeSum[PULSE_SENSOR_ENCODER_MAX_SENSORS];
+  byte sizeCount = 1;
+  const int16_t *pPrevious = samples;
+  for (byte frame = 0; frame < frameCount; ++frame) {
+    if (frame == 0) {
+      for (byte i = 0; i < sensorCount; ++i) {
+        *samples++ = (int16_t) bits.read(16);
+        sizeSum[i] = SIZE_START;
+      }
+      continue;
+    }
+    for (byte i = 0; i < sensorCount; ++i) {
+      byte k = riceParameter(sizeSum[i], sizeCount);
+      byte q = 0;
+      while (q < PULSE_SENSOR_ENCODER_ESCAPE && bits.readBit()) {
+        ++q;
+      }
+      unsigned long z = q < PULSE_SENSOR_ENCODER_ESCAPE
+        ? ((unsigned long) q << k) | bits.read(k)
+        : bits.read(ESCAPE_BITS);
+      long difference = (z & 1) ? -(long) ((z + 1) >> 1) : (long) (z >> 1);
+      *samples++ = (int16_t) (*pPrevious++ + difference);
+      sizeSum[i] += z < SIZE_CAP ? (word) z : SIZE_CAP;
+    }
+    if (++sizeCount >= SIZE_WINDOW) {
+      sizeCount /= 2;
+      for (byte i = 0; i < sensorCount; ++i) {
+        sizeSum[i] /= 2;
+      }
+    }
+  }
+  return bits.overran() ? -1 : frameCount;
+}
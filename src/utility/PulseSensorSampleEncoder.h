@@ -0,0 +1,141 @@
+/*
+   Compresses PulseSensor samples into small packets, for links
+   that can't carry every sample as text: BLE, WiFi, or an SD card.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_SAMPLE_ENCODER_H
+#define PULSE_SENSOR_SAMPLE_ENCODER_H
+
+#include <Arduino.h>
+
+/*
+   The most PulseSensors a packet can hold. Each one costs
+   4 bytes of RAM in every PulseSensorSampleEncoder.
+*/
+#ifndef PULSE_SENSOR_ENCODER_MAX_SENSORS
+#define PULSE_SENSOR_ENCODER_MAX_SENSORS 8
+#endif
+
+/*
+   Packet format. A packet can be decoded on its own, so a lost
+   packet (a dropped BLE notification, say) loses only its samples.
+
+     1 byte   sequence number, one more than the previous packet's (wraps)
+     1 byte   number of PulseSensors in each frame
+     1 byte   number of frames (sample periods) in the packet
+     then bits, least significant bit of each byte first:
+       the first frame: each sample as 16 bits.
+       each later sample: the difference from the PulseSensor's previous
+         sample, zigzag encoded (0, -1, 1, -2, 2... as 0, 1, 2, 3, 4...),
+         then Rice coded with parameter k: z >> k as that many 1 bits
+         and a 0 bit, then the low k bits of z.
+         If z >> k is PULSE_SENSOR_ENCODER_ESCAPE or more, it's sent as
+         PULSE_SENSOR_ENCODER_ESCAPE 1 bits and z as 17 bits.
+       padded with 0 bits to a whole byte.
+
+   k adapts to each PulseSensor's signal as the packet goes, from the
+   sizes of its recent differences (see riceParameter() in the .cpp),
+   so the decoder works out the same k without it being sent.
+   A sample of a clean PulseSensor signal usually takes 2 to 4 bits;
+   a noisy one, 6 to 9.
+*/
+#define PULSE_SENSOR_ENCODER_HEADER_BYTES 3
+#define PULSE_SENSOR_ENCODER_ESCAPE 16
+
+/*
+   Encodes frames (a sample from each PulseSensor) into a packet
+   in storage the Sketch provides. For example, over BLE:
+
+     byte packet[20];  // the most a BLE notification holds by default.
+     PulseSensorSampleEncoder encoder;
+     ...
+     encoder.begin(packet, sizeof(packet), 1);
+     ...
+     if (pulseSensor.sawNewSample()) {
+       int16_t sample = pulseSensor.getLatestSample();
+       if (!encoder.addFrame(&sample)) {
+         // The packet is full: send it, and start the next one with this frame.
+         characteristic.notify(encoder.getPacket(), encoder.getPacketLength());
+         encoder.startPacket();
+         encoder.addFrame(&sample);
+       }
+     }
+
+   decodePacket() turns a packet back into samples.
+   Used by the Sketch's loop() only; not by the sample ISR.
+*/
+class PulseSensorSampleEncoder {
+  public:
+    PulseSensorSampleEncoder();
+
+    /*
+       Start encoding into the given storage.
+       packet = where to build each packet; getPacket() returns it.
+       packetSize = its size, in bytes: at least 3 + 2 per PulseSensor,
+         and no more than 8191.
+       sensorCount = samples in each frame, 1..PULSE_SENSOR_ENCODER_MAX_SENSORS.
+       Returns false if the sizes can't be used.
+    */
+    bool begin(byte *packet, word packetSize, byte sensorCount);
+
+    /*
+       Start the next packet, empty.
+       Call after sending the full one.
+    */
+    void startPacket();
+
+    /*
+       Add a frame to the packet: samples[i] is the latest sample
+       of PulseSensor i.
+       Returns false, without adding it, if it doesn't fit; send the
+       packet, call startPacket(), then add the frame again.
+    */
+    bool addFrame(const int16_t *samples);
+
+    // The packet so far, and its length in bytes.
+    const byte *getPacket();
+    word getPacketLength();
+
+    // Returns the number of frames in the packet.
+    byte getFrameCount();
+
+    /*
+       Decode a packet made by addFrame().
+       samples = where to put the frames, one after another:
+         frames * sensors samples. packet[1] is the number of sensors.
+       maxSamples = the room in samples.
+       Returns the number of frames, or -1 if the packet is damaged
+       or doesn't fit in samples.
+    */
+    static int decodePacket(const byte *packet, word length,
+      int16_t *samples, word maxSamples);
+
+  private:
+    // (internal to the library) Returns the bits the frame would take.
+    word frameBits(const int16_t *samples);
+
+    // (internal to the library) Add the low count bits of value to the packet.
+    void writeBits(unsigned long value, byte count);
+
+    byte *pPacket;            // the packet being built, or NULL before begin().
+    word PacketSize;          // bytes in pPacket.
+    word BitCount;            // bits in the packet after the header.
+    byte SensorCount;         // samples in each frame.
+    byte Sequence;            // the packet's sequence number.
+    byte FrameCount;          // frames in the packet.
+    byte SizeCount;           // differences in SizeSum, per PulseSensor (the same for all).
+    int16_t Previous[PULSE_SENSOR_ENCODER_MAX_SENSORS];  // each PulseSensor's previous sample.
+    word SizeSum[PULSE_SENSOR_ENCODER_MAX_SENSORS];      // sum of recent zigzag differences.
+};
+#endif // PULSE_SENSOR_SAMPLE_ENCODER_H
@@ -18,7 +18,14 @@
 
 PulseSensorSerialOutput::PulseSensorSerialOutput() {
   pOutput = NULL;
+  pPrint = NULL;
   OutputType = SERIAL_PLOTTER;
+  pFrameSamples = NULL;
+  FrameSensors = 0;
+  FramePeriods = 0;
+  pEncoder = NULL;
+  Sequence = 0;
+  PendingBeats = 0;
 }
 
 void PulseSensorSerialOutput::setSerial(Stream &output) {
@@ -40,34 +47,46 @@ void PulseSensorSerialOutput::outputSample(PulseSensor sensors[], int numSensors
 
   switch (OutputType) {
     case SERIAL_PLOTTER:
+      beginOutput();
       if (numSensors == 1) {
-        pOutput->print(sensors[0].getBeatsPerMinute());
-        pOutput->print(',');
-        pOutput->print(sensors[0].getInterBeatIntervalMs());
-        pOutput->print(',');
-        pOutput->print(sensors[0].getLatestSample());
+        pPrint->print(sensors[0].getBeatsPerMinute());
+        pPrint->print(',');
+        pPrint->print(sensors[0].getInterBeatIntervalMs());
+        pPrint->print(',');
+        pPrint->print(sensors[0].getLatestSample());
       } else {
         for (int i = 0; i < numSensors; ++i) {
           if (i != 0) {
-            pOutput->print(',');
+            pPrint->print(',');
           }
-          pOutput->print(sensors[i].getLatestSample());
+          pPrint->print(sensors[i].getLatestSample());
           // Could output BPM and IBI here.
         }
       }
-        pOutput->println();
+        pPrint->println();
+      endOutput();
       break;
 
     case PROCESSING_VISUALIZER:
       // Don't print bpm and ibi here; they're printed per-beat.
+      beginOutput();
       if (numSensors == 1) {
-        outputToSerial('S', sensors[0].getLatestSample());
+        printSymbol('S', sensors[0].getLatestSample());
       } else {
         // PulseSensor 0 = a; #1 = b; #2 = c, etc.
         for(int i = 0; i < numSensors; ++i){
-          outputToSerial('a' + i, sensors[i].getLatestSample());
+          printSymbol('a' + i, sensors[i].getLatestSample());
         }
       }
+      endOutput();
+      break;
+
+    case BINARY_STREAM:
+      outputBinarySample(sensors, numSensors);
+      break;
+
+    case COMPRESSED_STREAM:
+      outputCompressedSample(sensors, numSensors);
       break;
 
     default:
@@ -90,16 +109,28 @@ void PulseSensorSerialOutput::outputBeat(PulseSensor sensors[], int numSensors,
       break;
 
     case PROCESSING_VISUALIZER:
+      beginOutput();
       if (numSensors == 1) {
-        outputToSerial('B', sensors[sensorIndex].getBeatsPerMinute());
-        outputToSerial('Q', sensors[sensorIndex].getInterBeatIntervalMs());
+        printSymbol('B', sensors[sensorIndex].getBeatsPerMinute());
+        printSymbol('Q', sensors[sensorIndex].getInterBeatIntervalMs());
       } else {
         // PulseSensor 0 = A, M; #1 = B, N; etc.
-        outputToSerial('A' + sensorIndex
+        printSymbol('A' + sensorIndex
           , sensors[sensorIndex].getBeatsPerMinute());
-        outputToSerial('M' + sensorIndex
+        printSymbol('M' + sensorIndex
           , sensors[sensorIndex].getInterBeatIntervalMs());
       }
+      endOutput();
+      break;
+
+    case BINARY_STREAM:
+    case COMPRESSED_STREAM:
+      drainQueue();
+      // Sent with the frame that's being filled.
+      if (sensorIndex >= 0 && sensorIndex < numSensors
+        && sensorIndex < BINARY_STREAM_MAX_SENSORS) {
+        PendingBeats |= (byte) (1 << sensorIndex);
+      }
       break;
 
     default:
@@ -114,7 +145,228 @@ void PulseSensorSerialOutput::outputToSerial(char symbol, int data) {
     return;  // no serial output object has been set.
   }
 
-  pOutput->print(symbol);
-  pOutput->println(data);
+  beginOutput();
+  printSymbol(symbol, data);
+  endOutput();
+}
+
+void PulseSensorSerialOutput::printSymbol(char symbol, int data) {
+  pPrint->print(symbol);
+  pPrint->println(data);
+}
+
+void PulseSensorSerialOutput::setQueue(byte *storage, word size) {
+  Queue.begin(storage, size);
+}
+
+unsigned long PulseSensorSerialOutput::getDrops() {
+  return Queue.getDrops();
+}
+
+void PulseSensorSerialOutput::drainQueue() {
+  if (pOutput && Queue.isActive()) {
+    Queue.drain(*pOutput);
+  }
+}
+
+void PulseSensorSerialOutput::beginOutput() {
+  if (Queue.isActive()) {
+    // Make room first, so the new message is less likely to be dropped.
+    Queue.drain(*pOutput);
+    Queue.beginMessage();
+    pPrint = &Queue;
+  } else {
+    pPrint = pOutput;
+  }
+}
+
+bool PulseSensorSerialOutput::endOutput() {
+  if (!Queue.isActive()) {
+    return true;
+  }
+  bool queued = Queue.endMessage();
+  Queue.drain(*pOutput);
+  return queued;
+}
+
+
+void PulseSensorSerialOutput::outputBinarySample(PulseSensor sensors[], int numSensors) {
+  if (numSensors > BINARY_STREAM_MAX_SENSORS) {
+    numSensors = BINARY_STREAM_MAX_SENSORS;
+  }
+  if (!pFrameSamples) {
+    // Allocated here so that other output types don't use the RAM.
+    pFrameSamples = new word[BINARY_STREAM_SAMPLES_PER_FRAME * numSensors];
+    FrameSensors = (byte) numSensors;
+  }
+
+  word *pPeriod = pFrameSamples + FramePeriods * FrameSensors;
+  for (byte i = 0; i < FrameSensors; ++i) {
+    int sample = sensors[i].getLatestSample();
+    pPeriod[i] = (word) constrain(sample, 0, 4095);
+  }
+  if (++FramePeriods >= BINARY_STREAM_SAMPLES_PER_FRAME) {
+    outputBinaryFrame(sensors, FrameSensors);
+    FramePeriods = 0;
+  }
+}
+
+void PulseSensorSerialOutput::outputBinaryFrame(PulseSensor sensors[], byte numSensors) {
+  word sampleCount = FramePeriods * numSensors;
+
+  // Use 12 bit samples only if a sample needs them.
+  byte flags = (byte) ((FramePeriods - 1) << BINARY_STREAM_PERIODS_SHIFT);
+  byte sampleBits = 10;
+  for (word i = 0; i < sampleCount; ++i) {
+    if (pFrameSamples[i] > 1023) {
+      flags |= BINARY_STREAM_12_BIT;
+      sampleBits = 12;
+      break;
+    }
+  }
+  byte beats = PendingBeats;
+  PendingBeats = 0;
+  if (beats) {
+    flags |= BINARY_STREAM_BEATS;
+  }
+
+  /*
+     Write the frame a few bytes at a time, computing the CRC as we go,
+     so the frame needn't fit in RAM.
+  */
+  byte chunk[8];
+  byte n = 0;
+  word crc = 0xFFFF;
+  chunk[n++] = Sequence++;
+  chunk[n++] = flags;
+  chunk[n++] = (byte) ((1 << numSensors) - 1);
+  beginOutput();
+  pPrint->write(BINARY_STREAM_SYNC0);
+  pPrint->write(BINARY_STREAM_SYNC1);
+
+  // Pack the samples, least significant bit first.
+  unsigned long bits = 0;
+  byte bitCount = 0;
+  for (word i = 0; i < sampleCount; ++i) {
+    bits |= (unsigned long) pFrameSamples[i] << bitCount;
+    bitCount += sampleBits;
+    while (bitCount >= 8) {
+      chunk[n++] = (byte) bits;
+      bits >>= 8;
+      bitCount -= 8;
+    }
+    if (n > sizeof(chunk) - 2) {
+      for (byte j = 0; j < n; ++j) {
+        crc = crc16Update(crc, chunk[j]);
+      }
+      pPrint->write(chunk, n);
+      n = 0;
+    }
+  }
+  if (bitCount > 0) {
+    chunk[n++] = (byte) bits;
+  }
+
+  if (beats) {
+    chunk[n++] = beats;
+    for (byte i = 0; i < numSensors; ++i) {
+      if (beats & (1 << i)) {
+        if (n > sizeof(chunk) - 3) {
+          for (byte j = 0; j < n; ++j) {
+            crc = crc16Update(crc, chunk[j]);
+          }
+          pPrint->write(chunk, n);
+          n = 0;
+        }
+        int bpm = sensors[i].getBeatsPerMinute();
+        word ibi = (word) sensors[i].getInterBeatIntervalMs();
+        chunk[n++] = (byte) constrain(bpm, 0, 255);
+        chunk[n++] = (byte) ibi;
+        chunk[n++] = (byte) (ibi >> 8);
+      }
+    }
+  }
+
+  for (byte j = 0; j < n; ++j) {
+    crc = crc16Update(crc, chunk[j]);
+  }
+  pPrint->write(chunk, n);
+  pPrint->write((byte) crc);
+  pPrint->write((byte) (crc >> 8));
+  if (!endOutput()) {
+    // Dropped. The sequence number shows the gap; send the beats next time.
+    PendingBeats |= beats;
+  }
 }
 
+void PulseSensorSerialOutput::outputCompressedSample(PulseSensor sensors[], int numSensors) {
+  if (numSensors > BINARY_STREAM_MAX_SENSORS) {
+    numSensors = BINARY_STREAM_MAX_SENSORS;
+  }
+  if (!pEncoder) {
+    // Allocated here so that other output types don't use the RAM.
+    byte *pPacket = new byte[COMPRESSED_STREAM_PACKET_BYTES];
+    pEncoder = new PulseSensorSampleEncoder();
+    pEncoder->begin(pPacket, COMPRESSED_STREAM_PACKET_BYTES, (byte) numSensors);
+  }
+  if (!pEncoder->getPacket()) {
+    return; // the packet is too small for the number of PulseSensors.
+  }
+
+  int16_t frame[BINARY_STREAM_MAX_SENSORS];
+  for (int i = 0; i < numSensors; ++i) {
+    frame[i] = sensors[i].getLatestSample();
+  }
+  if (!pEncoder->addFrame(frame)) {
+    outputCompressedFrame(sensors, (byte) numSensors);
+    pEncoder->startPacket();
+    pEncoder->addFrame(frame);
+  }
+}
+
+void PulseSensorSerialOutput::outputCompressedFrame(PulseSensor sensors[], byte numSensors) {
+  byte length = (byte) pEncoder->getPacketLength();
+  const byte *pPacket = pEncoder->getPacket();
+  byte beats = PendingBeats;
+  PendingBeats = 0;
+
+  word crc = crc16Update(0xFFFF, length);
+  for (byte j = 0; j < length; ++j) {
+    crc = crc16Update(crc, pPacket[j]);
+  }
+  beginOutput();
+  pPrint->write(BINARY_STREAM_SYNC0);
+  pPrint->write(COMPRESSED_STREAM_SYNC1);
+  pPrint->write(length);
+  pPrint->write(pPacket, length);
+
+  crc = crc16Update(crc, beats);
+  pPrint->write(beats);
+  for (byte i = 0; i < numSensors; ++i) {
+    if (beats & (1 << i)) {
+      int bpm = sensors[i].getBeatsPerMinute();
+      word ibi = (word) sensors[i].getInterBeatIntervalMs();
+      byte beat[3] = { (byte) constrain(bpm, 0, 255), (byte) ibi, (byte) (ibi >> 8) };
+      for (byte j = 0; j < 3; ++j) {
+        crc = crc16Update(crc, beat[j]);
+      }
+      pPrint->write(beat, 3);
+    }
+  }
+  pPrint->write((byte) crc);
+  pPrint->write((byte) (crc >> 8));
+  if (!endOutput()) {
+    // Dropped. The packet's sequence number shows the gap; send the beats next time.
+    PendingBeats |= beats;
+  }
+}
+
+word PulseSensorSerialOutput::crc16Update(word crc, byte data) {
+  // The polynomial applied a byte at a time, without a table.
+  crc = (word) ((crc >> 8) | (crc << 8));
+  crc ^= data;
+  crc ^= (crc & 0xFF) >> 4;
+  crc ^= (word) (crc << 12);
+  crc ^= (word) ((crc & 0xFF) << 5);
+  return crc;
+}
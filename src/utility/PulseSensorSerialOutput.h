@@ -20,14 +20,92 @@
 
 #include <Arduino.h>
 #include "PulseSensor.h" // to access PulseSensor state.
+#include "PulseSensorOutputQueue.h"
+#include "PulseSensorSampleEncoder.h"
 
 /*
    Destinations for serial output:
    PROCESSING_VISUALIZER = write to the Processing Visualizer Sketch.
    SERIAL_PLOTTER = write to the Arduino IDE Serial Plotter.
+   BINARY_STREAM = write compact binary frames, for a program to decode.
+   COMPRESSED_STREAM = write compressed binary frames, a third to a half
+     the size of BINARY_STREAM's, for a program to decode.
 */
 #define PROCESSING_VISUALIZER ((byte) 1)
 #define SERIAL_PLOTTER ((byte) 2)
+#define BINARY_STREAM ((byte) 3)
+#define COMPRESSED_STREAM ((byte) 4)
+
+/*
+   BINARY_STREAM frame format. Each frame holds the samples of
+   BINARY_STREAM_SAMPLES_PER_FRAME outputSample() calls, to spread
+   the frame's header and CRC over several sample periods.
+   Multi-byte values are little-endian.
+
+     2 bytes  sync: BINARY_STREAM_SYNC0, BINARY_STREAM_SYNC1
+     1 byte   sequence number, one more than the previous frame's (wraps)
+     1 byte   flags: BINARY_STREAM_12_BIT, BINARY_STREAM_BEATS,
+              and in the top 4 bits, the number of sample periods minus 1
+     1 byte   sensor bitmap: bit i is set if PulseSensor i's samples follow
+     n bytes  the samples, oldest sample period first, and in sensor order
+              within each period. Packed least significant bit first,
+              10 bits each (12 if BINARY_STREAM_12_BIT is set),
+              padded with 0 bits to a whole byte
+   If BINARY_STREAM_BEATS is set:
+     1 byte   beat bitmap: bit i is set if PulseSensor i found a beat
+              during the frame, and its beat fields follow
+     3 bytes  per beat, in sensor order: BPM (1 byte, at most 255)
+              and IBI in milliseconds (2 bytes)
+   Finally:
+     2 bytes  CRC-16/CCITT-FALSE of everything after the sync bytes.
+              See crc16Update().
+
+   Only the first BINARY_STREAM_MAX_SENSORS PulseSensors are sent.
+   extras/host/tools/pulse_decode.cpp decodes this format.
+*/
+#define BINARY_STREAM_SYNC0 ((byte) 0xA5)
+#define BINARY_STREAM_SYNC1 ((byte) 0x5A)
+#define BINARY_STREAM_12_BIT ((byte) 0x01)
+#define BINARY_STREAM_BEATS ((byte) 0x02)
+#define BINARY_STREAM_PERIODS_SHIFT 4
+#define BINARY_STREAM_MAX_SENSORS 8
+
+/*
+   COMPRESSED_STREAM frame format. Each frame holds a
+   PulseSensorSampleEncoder packet (see PulseSensorSampleEncoder.h),
+   sent when the next sample period's samples won't fit in it.
+   Multi-byte values are little-endian.
+
+     2 bytes  sync: BINARY_STREAM_SYNC0, COMPRESSED_STREAM_SYNC1
+     1 byte   packet length, in bytes
+     n bytes  the packet
+     1 byte   beat bitmap: bit i is set if PulseSensor i found a beat
+              during the frame, and its beat fields follow
+     3 bytes  per beat, as in BINARY_STREAM
+     2 bytes  CRC-16/CCITT-FALSE of everything after the sync bytes.
+
+   Only the first BINARY_STREAM_MAX_SENSORS PulseSensors are sent.
+   extras/host/tools/pulse_decode.cpp decodes this format too.
+*/
+#define COMPRESSED_STREAM_SYNC1 ((byte) 0x5C)
+
+/*
+   Bytes per COMPRESSED_STREAM packet, 16..255. Bigger packets use less
+   bandwidth on headers, but delay each sample longer. The packet is
+   kept in RAM.
+*/
+#ifndef COMPRESSED_STREAM_PACKET_BYTES
+#define COMPRESSED_STREAM_PACKET_BYTES 64
+#endif
+
+/*
+   Sample periods per BINARY_STREAM frame, 1..16. More periods use less
+   bandwidth, but delay each sample longer and use 2 bytes of RAM
+   per period per PulseSensor.
+*/
+#ifndef BINARY_STREAM_SAMPLES_PER_FRAME
+#define BINARY_STREAM_SAMPLES_PER_FRAME 8
+#endif
 
 class PulseSensorSerialOutput {
   public:
@@ -54,7 +132,8 @@ class PulseSensorSerialOutput {
 
     /*
        Sets the format (destination) of the Serial Output:
-       SERIAL_PLOTTER or PROCESSING_VISUALIZER.
+       SERIAL_PLOTTER, PROCESSING_VISUALIZER, BINARY_STREAM
+       or COMPRESSED_STREAM.
     */
     void setOutputType(byte outputType);
 
@@ -77,11 +156,76 @@ class PulseSensorSerialOutput {
     */
     void outputToSerial(char symbol, int data);
 
+    /*
+       Queue output in the given storage, and write it to the Serial
+       only as fast as the Serial can take it without waiting.
+       Output that doesn't fit is dropped and counted.
+       storage = NULL stops queuing.
+    */
+    void setQueue(byte *storage, word size);
+
+    // Returns the number of outputs dropped because the queue was full.
+    unsigned long getDrops();
+
+    // Write as much queued output as the Serial can take without waiting.
+    void drainQueue();
+
+    /*
+       Add one byte to a CRC-16/CCITT-FALSE (polynomial 0x1021).
+       Start a BINARY_STREAM frame's CRC at 0xFFFF.
+    */
+    static word crc16Update(word crc, byte data);
+
   private:
+    // Start one output (a sample, beat or symbol); sets pPrint.
+    void beginOutput();
+
+    // End the output. Returns false if it was dropped.
+    bool endOutput();
+
+    // Write the given data prefixed by the given symbol, to pPrint.
+    void printSymbol(char symbol, int data);
+
+    // Add the latest samples to the BINARY_STREAM frame, and write it if it's full.
+    void outputBinarySample(PulseSensor sensors[], int numberOfSensors);
+
+    // Write the BINARY_STREAM frame of the saved samples.
+    void outputBinaryFrame(PulseSensor sensors[], byte numberOfSensors);
+
+    // Add the latest samples to the COMPRESSED_STREAM packet, writing it first if they don't fit.
+    void outputCompressedSample(PulseSensor sensors[], int numberOfSensors);
+
+    // Write the COMPRESSED_STREAM frame of the packet so far.
+    void outputCompressedFrame(PulseSensor sensors[], byte numberOfSensors);
+
+    // BINARY_STREAM samples waiting for the frame, or NULL until the first sample.
+    word *pFrameSamples;
+
+    // The number of PulseSensors pFrameSamples has room for.
+    byte FrameSensors;
+
+    // The number of sample periods in pFrameSamples.
+    byte FramePeriods;
+
+    // COMPRESSED_STREAM packet being filled, or NULL until the first sample.
+    PulseSensorSampleEncoder *pEncoder;
+
+    // BINARY_STREAM sequence number of the next frame.
+    byte Sequence;
+
+    // BINARY_STREAM or COMPRESSED_STREAM sensors whose beat is waiting for the next frame. Bit i = sensor i.
+    byte PendingBeats;
+
     // If non-null, the output stream to print to. If null, don't print.
     Stream *pOutput;
 
-    // The destination of data: PROCESSING_VISUALIZER or SERIAL_PLOTTER
+    // Where the current output goes: pOutput, or Queue if it's in use.
+    Print *pPrint;
+
+    // Output waiting for room in pOutput, if setQueue() was given storage.
+    PulseSensorOutputQueue Queue;
+
+    // The destination of data: PROCESSING_VISUALIZER, SERIAL_PLOTTER, BINARY_STREAM or COMPRESSED_STREAM
     int OutputType;
 
 };
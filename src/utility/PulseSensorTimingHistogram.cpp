@@ -0,0 +1,155 @@
+/*
+   Sample timing histograms for the PulseSensor Playground.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+PulseSensorTimingHistogram::PulseSensorTimingHistogram() {
+  SampleIntervalMicros = PulseSensorPlayground::MICROS_PER_READ;
+  SensorCount = 1;
+  reset();
+}
+
+void PulseSensorTimingHistogram::reset() {
+  for (byte b = 0; b < PULSE_SENSOR_HISTOGRAM_BUCKETS; ++b) {
+    JitterCounts[b] = 0;
+    ExecutionCounts[b] = 0;
+    AcquisitionCounts[b] = 0;
+  }
+  Samples = 0;
+  MaxJitterMicros = 0;
+  MaxExecutionMicros = 0;
+  MaxAcquisitionMicros = 0;
+  // Keep LastStartMicros, so the next sample's jitter still counts.
+}
+
+void PulseSensorTimingHistogram::begin(unsigned long sampleIntervalMicros,
+  byte sensorCount) {
+  SampleIntervalMicros = sampleIntervalMicros;
+  SensorCount = sensorCount;
+  reset();
+  restart();
+}
+
+void PulseSensorTimingHistogram::restart() {
+  HaveLastStart = false;
+}
+
+void PulseSensorTimingHistogram::recordSample(unsigned long startMicros,
+  unsigned long acquisitionMicros, unsigned long executionMicros) {
+  if (HaveLastStart) {
+    unsigned long interval = startMicros - LastStartMicros;
+    unsigned long jitter = interval > SampleIntervalMicros
+      ? interval - SampleIntervalMicros : SampleIntervalMicros - interval;
+    ++JitterCounts[bucketOf(jitter)];
+    if (jitter > MaxJitterMicros) {
+      MaxJitterMicros = jitter;
+    }
+  }
+  LastStartMicros = startMicros;
+  HaveLastStart = true;
+
+  ++ExecutionCounts[bucketOf(executionMicros)];
+  if (executionMicros > MaxExecutionMicros) {
+    MaxExecutionMicros = executionMicros;
+  }
+  ++AcquisitionCounts[bucketOf(acquisitionMicros)];
+  if (acquisitionMicros > MaxAcquisitionMicros) {
+    MaxAcquisitionMicros = acquisitionMicros;
+  }
+  ++Samples;
+}
+
+unsigned long PulseSensorTimingHistogram::getSamples() {
+  return Samples;
+}
+
+unsigned long PulseSensorTimingHistogram::getJitterCount(byte b) {
+  return b < PULSE_SENSOR_HISTOGRAM_BUCKETS ? JitterCounts[b] : 0;
+}
+
+unsigned long PulseSensorTimingHistogram::getExecutionCount(byte b) {
+  return b < PULSE_SENSOR_HISTOGRAM_BUCKETS ? ExecutionCounts[b] : 0;
+}
+
+unsigned long PulseSensorTimingHistogram::getAcquisitionCount(byte b) {
+  return b < PULSE_SENSOR_HISTOGRAM_BUCKETS ? AcquisitionCounts[b] : 0;
+}
+
+unsigned long PulseSensorTimingHistogram::getMaxJitterMicros() {
+  return MaxJitterMicros;
+}
+
+unsigned long PulseSensorTimingHistogram::getMaxExecutionMicros() {
+  return MaxExecutionMicros;
+}
+
+unsigned long PulseSensorTimingHistogram::getMaxAcquisitionMicros() {
+  return MaxAcquisitionMicros;
+}
+
+byte PulseSensorTimingHistogram::getSensorCount() {
+  return SensorCount;
+}
+
+byte PulseSensorTimingHistogram::bucketOf(unsigned long micros) {
+  if (micros >= (1UL << (PULSE_SENSOR_HISTOGRAM_BUCKETS - 2))) {
+    return PULSE_SENSOR_HISTOGRAM_BUCKETS - 1;
+  }
+  // Find the highest bit set, a few bits at a time. micros fits in a word here.
+  word w = (word) micros;
+  byte b = 0;
+  if (w >= 0x100) {
+    w >>= 8;
+    b += 8;
+  }
+  if (w >= 0x10) {
+    w >>= 4;
+    b += 4;
+  }
+  if (w >= 0x4) {
+    w >>= 2;
+    b += 2;
+  }
+  if (w >= 0x2) {
+    w >>= 1;
+    b += 1;
+  }
+  return w ? b + 1 : 0;
+}
+
+unsigned long PulseSensorTimingHistogram::bucketMinMicros(byte b) {
+  return b == 0 ? 0 : 1UL << (b - 1);
+}
+
+#if USE_SERIAL
+void PulseSensorTimingHistogram::outputHistogram(Stream *pOut) {
+  if (!pOut) {
+    return; // not configured for Serial output.
+  }
+  for (byte b = 0; b < PULSE_SENSOR_HISTOGRAM_BUCKETS; ++b) {
+    if (JitterCounts[b] == 0 && ExecutionCounts[b] == 0 && AcquisitionCounts[b] == 0) {
+      continue;
+    }
+    pOut->print(bucketMinMicros(b));
+    pOut->print(' ');
+    pOut->print(JitterCounts[b]);
+    pOut->print(' ');
+    pOut->print(ExecutionCounts[b]);
+    pOut->print(' ');
+    pOut->println(AcquisitionCounts[b]);
+  }
+}
+#endif
@@ -0,0 +1,123 @@
+/*
+   Sample timing histograms for the PulseSensor Playground.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_TIMING_HISTOGRAM_H
+#define PULSE_SENSOR_TIMING_HISTOGRAM_H
+
+#include <Arduino.h>
+
+/*
+   Number of histogram buckets. Bucket 0 counts 0 microseconds,
+   bucket b counts 2^(b-1) up to 2^b - 1 microseconds,
+   and the last bucket also counts anything longer.
+   16 buckets reach 16384 microseconds and up.
+*/
+#define PULSE_SENSOR_HISTOGRAM_BUCKETS 16
+
+/*
+   Histograms of how well the Playground keeps time, kept for as long
+   as it runs, in both hardware timer and software timer Sketches:
+
+   jitter = how far the time between one sample and the next was from
+     the sample interval, either way (microseconds).
+   execution = how long onSampleTime() took to read and process a sample
+     from every PulseSensor (microseconds). Divide by getSensorCount()
+     for the time per PulseSensor.
+   acquisition = how much of that was spent reading the PulseSensors:
+     analogRead() time, which grows with setOversampling().
+
+   Times are measured with micros(), so are no finer than micros()
+   (4 microseconds on a 16MHz AVR).
+
+   Get a copy from pulse.getTimingHistogram(), which is safe to call
+   while the Playground is sampling.
+*/
+class PulseSensorTimingHistogram {
+  public:
+    PulseSensorTimingHistogram();
+
+    // Clear all counts.
+    void reset();
+
+    /*
+       (internal to the library) Set the expected time between samples
+       and the number of PulseSensors sampled.
+    */
+    void begin(unsigned long sampleIntervalMicros, byte sensorCount);
+
+    /*
+       (internal to the library) Forget the previous sample time,
+       so a pause isn't counted as jitter.
+    */
+    void restart();
+
+    /*
+       (internal to the library) Count one call of onSampleTime().
+       startMicros = micros() when it started.
+       acquisitionMicros = how long it took to read every PulseSensor.
+       executionMicros = how long it took in all.
+    */
+    void recordSample(unsigned long startMicros, unsigned long acquisitionMicros,
+      unsigned long executionMicros);
+
+    // Number of samples counted in the execution histogram.
+    unsigned long getSamples();
+
+    // The count in jitter bucket b (0..PULSE_SENSOR_HISTOGRAM_BUCKETS - 1).
+    unsigned long getJitterCount(byte b);
+
+    // The count in execution time bucket b (0..PULSE_SENSOR_HISTOGRAM_BUCKETS - 1).
+    unsigned long getExecutionCount(byte b);
+
+    // The count in acquisition time bucket b (0..PULSE_SENSOR_HISTOGRAM_BUCKETS - 1).
+    unsigned long getAcquisitionCount(byte b);
+
+    // The largest jitter, execution and acquisition time seen (microseconds).
+    unsigned long getMaxJitterMicros();
+    unsigned long getMaxExecutionMicros();
+    unsigned long getMaxAcquisitionMicros();
+
+    // The number of PulseSensors sampled by each onSampleTime() call.
+    byte getSensorCount();
+
+    // The bucket a time falls in.
+    static byte bucketOf(unsigned long micros);
+
+    // The shortest time counted in bucket b.
+    static unsigned long bucketMinMicros(byte b);
+
+#if USE_SERIAL
+    /*
+       Serial prints the histograms, one line per non-empty bucket:
+       shortest time in the bucket (microseconds), jitter count,
+       execution count, acquisition count.
+    */
+    void outputHistogram(Stream *pOut);
+#endif
+
+  private:
+    unsigned long JitterCounts[PULSE_SENSOR_HISTOGRAM_BUCKETS];
+    unsigned long ExecutionCounts[PULSE_SENSOR_HISTOGRAM_BUCKETS];
+    unsigned long AcquisitionCounts[PULSE_SENSOR_HISTOGRAM_BUCKETS];
+    unsigned long Samples;             // onSampleTime() calls counted.
+    unsigned long MaxJitterMicros;     // largest jitter seen.
+    unsigned long MaxExecutionMicros;  // largest execution time seen.
+    unsigned long MaxAcquisitionMicros; // largest acquisition time seen.
+    unsigned long SampleIntervalMicros; // expected time between samples.
+    unsigned long LastStartMicros;     // startMicros of the previous sample.
+    bool HaveLastStart;                // LastStartMicros is valid.
+    byte SensorCount;                  // PulseSensors per onSampleTime().
+};
+#endif // PULSE_SENSOR_TIMING_HISTOGRAM_H
@@ -21,43 +21,68 @@
 #include <PulseSensorPlayground.h>
 
 PulseSensorTimingStatistics::PulseSensorTimingStatistics(
-  long sampleIntervalMicros, int samplesToMeasure) {
-  SamplesDesired = samplesToMeasure;
+  long sampleIntervalMicros, unsigned long samplesPerReport) {
+  SamplesPerReport = samplesPerReport > 0 ? samplesPerReport : 1;
   SampleIntervalMicros = sampleIntervalMicros;
 
   resetStatistics();
 }
 
 void PulseSensorTimingStatistics::resetStatistics() {
-  SamplesSeen = 0;
+  SamplesToReport = SamplesPerReport;
+  OffsetsSeen = 0;
   MinJitterMicros = 0;
   MaxJitterMicros = 0;
-  OffsetsSum = 0.0;
+  OffsetsSum = 0;
+  OffsetsSquaredSum = 0;
+  for (byte b = 0; b < PULSE_SENSOR_STATISTICS_BUCKETS; ++b) {
+    JitterCounts[b] = 0;
+  }
+  restart();
+}
+
+void PulseSensorTimingStatistics::restart() {
+  HaveLastSample = false;
   LastSampleMicros = 0L;
 }
 
-int PulseSensorTimingStatistics::recordSampleTime() {
+unsigned long PulseSensorTimingStatistics::recordSampleTime() {
   unsigned long nowMicros = micros();
 
-  if (SamplesSeen > 0) {
+  if (HaveLastSample) {
     long offsetMicros =
       (long) (nowMicros - LastSampleMicros) - SampleIntervalMicros;
-    offsetMicros = constrain(offsetMicros, -32767, 32767);
+    int offset = (int) constrain(offsetMicros, -32767L, 32767L);
 
-    OffsetsSum += (float) offsetMicros;
-
-    if (MinJitterMicros > offsetMicros) {
-      MinJitterMicros = offsetMicros;
+    if (OffsetsSeen == 0 || MinJitterMicros > offset) {
+      MinJitterMicros = offset;
+    }
+    if (OffsetsSeen == 0 || MaxJitterMicros < offset) {
+      MaxJitterMicros = offset;
     }
-    if (MaxJitterMicros < offsetMicros) {
-      MaxJitterMicros = offsetMicros;
+
+    /*
+       Exact integer sums rather than a running mean and variance:
+       there is no rounding to accumulate, and each sample costs only
+       additions. The sums can't overflow in 2^32 samples.
+    */
+    unsigned int jitter = (unsigned int) (offset < 0 ? -offset : offset);
+    OffsetsSum += offset;
+    OffsetsSquaredSum += (unsigned long) jitter * jitter;
+    ++JitterCounts[bucketOf(jitter)];
+    if (OffsetsSeen < 0xFFFFFFFFUL) {
+      ++OffsetsSeen;
     }
   }
 
   LastSampleMicros = nowMicros;
-  ++SamplesSeen;
+  HaveLastSample = true;
 
-  return (SamplesDesired - SamplesSeen);
+  if (--SamplesToReport == 0) {
+    SamplesToReport = SamplesPerReport;
+    return 0;
+  }
+  return SamplesToReport;
 }
 
 #if USE_SERIAL
@@ -69,14 +94,119 @@ int PulseSensorTimingStatistics::recordSampleTime() {
     pOut->print(" ");
     pOut->print(getAverageOffsetMicros());
     pOut->print(" ");
-    pOut->println(MaxJitterMicros);
+    pOut->print(MaxJitterMicros);
+    pOut->print(" ");
+    pOut->print(getStdDevMicros());
+    pOut->print(" ");
+    pOut->print(getPercentileMicros(50));
+    pOut->print(" ");
+    pOut->print(getPercentileMicros(95));
+    pOut->print(" ");
+    pOut->print(getPercentileMicros(99));
+    pOut->print(" ");
+    pOut->println(OffsetsSeen);
   }
 #endif
-  
+
 int PulseSensorTimingStatistics::getAverageOffsetMicros() {
-  // the number of offsets is the number of samples - 1.
-  if (SamplesSeen - 1 <= 0) {
+  if (OffsetsSeen == 0) {
+    return 0;
+  }
+  int64_t half = OffsetsSeen / 2;
+  return (int) ((OffsetsSum + (OffsetsSum < 0 ? -half : half)) / (int64_t) OffsetsSeen);
+}
+
+unsigned int PulseSensorTimingStatistics::getStdDevMicros() {
+  if (OffsetsSeen < 2) {
+    return 0;
+  }
+
+  /*
+     variance = (sum of squares - sum * sum / n) / (n - 1).
+     sum * sum would overflow, so with sum = m * n + r,
+     sum * sum / n = sum * m + m * r + r * r / n.
+  */
+  int64_t n = OffsetsSeen;
+  int64_t m = OffsetsSum / n;
+  int64_t r = OffsetsSum - m * n;
+  uint64_t rAbs = (uint64_t) (r < 0 ? -r : r);
+  int64_t deviations = (int64_t) OffsetsSquaredSum - OffsetsSum * m - m * r
+    - (int64_t) (rAbs * rAbs / (uint64_t) n);
+  if (deviations <= 0) {
+    return 0;
+  }
+  unsigned long variance = (unsigned long) (deviations / (n - 1));
+
+  // Integer square root, rounded to the nearest microsecond.
+  unsigned long root = 0;
+  unsigned long bit = 1UL << 30;
+  unsigned long rest = variance;
+  while (bit > rest) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (rest >= root + bit) {
+      rest -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  if (rest > root) {
+    ++root;
+  }
+  return (unsigned int) root;
+}
+
+unsigned int PulseSensorTimingStatistics::getPercentileMicros(byte percent) {
+  if (OffsetsSeen == 0) {
     return 0;
   }
-  return (int) ((OffsetsSum + 0.5) / (SamplesSeen - 1));
+  if (percent > 100) {
+    percent = 100;
+  }
+
+  // The number of intervals that must be within the answer, rounded up.
+  unsigned long wanted = (OffsetsSeen / 100) * percent
+    + ((OffsetsSeen % 100) * percent + 99) / 100;
+  if (wanted == 0) {
+    wanted = 1;
+  }
+
+  unsigned int maxJitter = (unsigned int)
+    (-MinJitterMicros > MaxJitterMicros ? -MinJitterMicros : MaxJitterMicros);
+  unsigned long seen = 0;
+  for (byte b = 0; b < PULSE_SENSOR_STATISTICS_BUCKETS - 1; ++b) {
+    seen += JitterCounts[b];
+    if (seen >= wanted) {
+      // The largest jitter this bucket counts, or the largest seen.
+      unsigned int top = bucketMinMicros(b + 1) - 1;
+      return top < maxJitter ? top : maxJitter;
+    }
+  }
+  return maxJitter;
+}
+
+byte PulseSensorTimingStatistics::bucketOf(unsigned int jitterMicros) {
+  if (jitterMicros < 4) {
+    return (byte) jitterMicros;
+  }
+  if (jitterMicros > 32767) {
+    jitterMicros = 32767;
+  }
+  byte shift = 0;
+  while ((jitterMicros >> shift) >= 8) {
+    ++shift;
+  }
+  // jitterMicros >> shift is 4..7: the power of 2 and a quarter of it.
+  return (byte) (4 + shift * 4 + ((jitterMicros >> shift) & 3));
+}
+
+unsigned int PulseSensorTimingStatistics::bucketMinMicros(byte b) {
+  if (b < 4) {
+    return b;
+  }
+  b -= 4;
+  return (unsigned int) ((4 + (b & 3)) << (b >> 2));
 }
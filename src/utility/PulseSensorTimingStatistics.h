@@ -21,6 +21,14 @@
 
 #include <Arduino.h>
 
+/*
+   Number of buckets in the jitter histogram used for percentiles.
+   Jitters of 0 to 3 microseconds each have a bucket; above that,
+   each power of 2 is split into 4 buckets, up to 32767 microseconds.
+   A percentile is therefore within 25% of the true value.
+*/
+#define PULSE_SENSOR_STATISTICS_BUCKETS 56
+
 /*
    Timing statistics show how accurate the beats per minute
    and inter-beat interval measurements are.
@@ -36,6 +44,12 @@
    A large span between minimum and maximum jitter shows that sometimes
    the sampling loop was slow or fast. This could be due to, for example,
    unexpectedly slow code that executes only every so often.
+   The standard deviation and the 50th, 95th and 99th percentile jitter
+   show how often that happens.
+
+   Only integer arithmetic is used: each sample costs a few additions,
+   and the division and square root are done only when the statistics
+   are read. Counts are 32 bits, so statistics can be kept for days.
 */
 class PulseSensorTimingStatistics {
   public:
@@ -44,52 +58,94 @@ class PulseSensorTimingStatistics {
        of samples from the PulseSensor.
 
        sampleIntervalMicros = expected time between samples, in microseconds.
-       samplesToMeasure = number of samples to measure timing over.
+       samplesPerReport = number of samples between reports;
+         see recordSampleTime().
     */
-    PulseSensorTimingStatistics(long sampleIntervalMicros, int samplesToMeasure);
-    
+    PulseSensorTimingStatistics(long sampleIntervalMicros, unsigned long samplesPerReport);
+
     /*
        (re)start the collection of timing statistics.
        Called automatically by the PulseSensorTimingStatistics constructor.
     */
     void resetStatistics();
 
+    /*
+       Forget the time of the previous sample, so that the time
+       until the next one isn't counted. Call this after
+       doing something slow that isn't part of normal sampling,
+       such as printing the statistics.
+    */
+    void restart();
 
     /*
        Record the fact that we just now read the PulseSensor output.
 
-       Returns the number of samples remaining to be recorded.
-       The caller should stop calling recordSampleTime() once
-       this function returns 0.
+       Returns the number of samples remaining until the next report.
+       When this function returns 0, the caller should report
+       the statistics (for example, with outputStatistics()).
+       The count then starts again; the statistics keep accumulating.
     */
-    int recordSampleTime();
+    unsigned long recordSampleTime();
 
     /*
-       Serial prints the sample timing statistics.
+       Serial prints the sample timing statistics, on one line:
+       minimum, average, maximum offset, standard deviation,
+       50th, 95th and 99th percentile jitter (all in microseconds),
+       and the number of sample intervals measured.
     */
 #if USE_SERIAL
     void outputStatistics(Stream *pOut);
 #endif
-    
+
     int getMinJitterMicros() {
       return MinJitterMicros;
     }
     int getMaxJitterMicros() {
       return MaxJitterMicros;
     }
-    
+
+    // Returns the number of sample intervals measured so far.
+    unsigned long getSamplesSeen() {
+      return OffsetsSeen;
+    }
+
     /*
        Returns the average offset seen so far, in microseconds.
     */
     int getAverageOffsetMicros();
 
+    /*
+       Returns the standard deviation of the offsets seen so far,
+       in microseconds.
+    */
+    unsigned int getStdDevMicros();
+
+    /*
+       Returns the jitter (the size of the offset, either way)
+       that the given percent of sample intervals were within,
+       in microseconds. For example, getPercentileMicros(99)
+       returns the 99th percentile jitter.
+    */
+    unsigned int getPercentileMicros(byte percent);
+
+    /*
+       (internal to the library) Returns the histogram bucket
+       for the given jitter, and the least jitter counted in a bucket.
+    */
+    static byte bucketOf(unsigned int jitterMicros);
+    static unsigned int bucketMinMicros(byte b);
+
   private:
     long SampleIntervalMicros; // desired sample interval, in microseconds.
-    int SamplesDesired;       // total number of samples we want to record.
+    unsigned long SamplesPerReport; // number of samples between reports.
+    unsigned long SamplesToReport;  // number of samples until the next report.
     unsigned long LastSampleMicros; // time (microseconds) of the previous sample.
+    boolean HaveLastSample;   // true if LastSampleMicros is valid.
     int MinJitterMicros;      // minimum offset seen.
     int MaxJitterMicros;      // maximum offset seen.
-    float OffsetsSum;         // sum of offsets so far.
-    int SamplesSeen;          // number of samples seen so far.
+    int64_t OffsetsSum;       // sum of offsets so far.
+    uint64_t OffsetsSquaredSum; // sum of the squares of the offsets so far.
+    unsigned long OffsetsSeen; // number of offsets (sample intervals) seen so far.
+    unsigned long JitterCounts[PULSE_SENSOR_STATISTICS_BUCKETS]; // histogram of jitter.
 };
 #endif // PULSE_SENSOR_TIMING_STATISTICS_H
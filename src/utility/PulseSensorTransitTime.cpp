@@ -0,0 +1,206 @@
+/*
+   Pulse Transit Time: the time the pulse takes to travel
+   from one PulseSensor to another, measured beat by beat.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+
+#include <PulseSensorPlayground.h>
+
+PulseSensorTransitTime::PulseSensorTransitTime(byte proximalIndex,
+  byte distalIndex, TransitTimeEvent *storage, size_t capacity) {
+  pNext = NULL;
+  ProximalIndex = proximalIndex;
+  DistalIndex = distalIndex;
+  MinMicros = 0;
+  MaxMicros = 400000UL;
+  if (storage) {
+    Events.begin(storage, capacity);
+  }
+  reset();
+}
+
+void PulseSensorTransitTime::setWindow(unsigned long minMicros,
+  unsigned long maxMicros) {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  MinMicros = minMicros;
+  MaxMicros = maxMicros;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+
+byte PulseSensorTransitTime::getProximalIndex() {
+  return ProximalIndex;
+}
+
+byte PulseSensorTransitTime::getDistalIndex() {
+  return DistalIndex;
+}
+
+void PulseSensorTransitTime::reset() {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  HaveProximal = false;
+  ProximalMicros = 0;
+  Latest = -1;
+  SawNew = false;
+  Matches = 0;
+  Misses = 0;
+  WindowIndex = 0;
+  WindowCount = 0;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+}
+
+void PulseSensorTransitTime::addBeat(byte sensorIndex, byte found,
+  unsigned long beatMicros) {
+  if (found & PulseSensor::FOUND_SIGNAL_LOST) {
+    // The beat waiting for its pair won't get one.
+    if (HaveProximal) {
+      ++Misses;
+      HaveProximal = false;
+    }
+    return;
+  }
+  if ((found & PulseSensor::FOUND_BEAT_START) == 0) {
+    return;
+  }
+
+  if (sensorIndex == ProximalIndex) {
+    if (HaveProximal) {
+      ++Misses; // the distal PulseSensor didn't find the previous beat.
+    }
+    HaveProximal = true;
+    ProximalMicros = beatMicros;
+    return;
+  }
+  if (sensorIndex != DistalIndex) {
+    return;
+  }
+
+  if (!HaveProximal) {
+    ++Misses; // the proximal PulseSensor didn't find this beat.
+    return;
+  }
+  long transit = (long) (beatMicros - ProximalMicros);
+  if (transit < 0 || (unsigned long) transit < MinMicros) {
+    ++Misses; // too soon: not the proximal beat's pair.
+    return;
+  }
+  if ((unsigned long) transit > MaxMicros) {
+    Misses += 2; // too late: neither beat has a pair.
+    HaveProximal = false;
+    return;
+  }
+
+  HaveProximal = false;
+  Latest = transit;
+  SawNew = true;
+  ++Matches;
+  Window[WindowIndex] = transit;
+  if (++WindowIndex >= PULSE_SENSOR_TRANSIT_WINDOW) {
+    WindowIndex = 0;
+  }
+  if (WindowCount < PULSE_SENSOR_TRANSIT_WINDOW) {
+    ++WindowCount;
+  }
+
+  TransitTimeEvent event;
+  event.beatTimeMicros = beatMicros;
+  event.transitTimeMicros = transit;
+  Events.put(event);
+}
+
+long PulseSensorTransitTime::getTransitTimeMicros() {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  long transit = Latest;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return transit;
+}
+
+long PulseSensorTransitTime::getAverageMicros() {
+  long window[PULSE_SENSOR_TRANSIT_WINDOW];
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  byte count = WindowCount;
+  for (byte i = 0; i < count; ++i) {
+    window[i] = Window[i];
+  }
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+
+  if (count == 0) {
+    return -1;
+  }
+  long sum = 0;
+  for (byte i = 0; i < count; ++i) {
+    sum += window[i];
+  }
+  return (sum + count / 2) / count;
+}
+
+long PulseSensorTransitTime::getStandardDeviationMicros() {
+  long window[PULSE_SENSOR_TRANSIT_WINDOW];
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  byte count = WindowCount;
+  for (byte i = 0; i < count; ++i) {
+    window[i] = Window[i];
+  }
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+
+  if (count < 2) {
+    return 0;
+  }
+  long sum = 0;
+  for (byte i = 0; i < count; ++i) {
+    sum += window[i];
+  }
+  float mean = (float) sum / count;
+  float squares = 0;
+  for (byte i = 0; i < count; ++i) {
+    float difference = window[i] - mean;
+    squares += difference * difference;
+  }
+  return (long) (sqrt(squares / (count - 1)) + 0.5);
+}
+
+bool PulseSensorTransitTime::sawNewTransitTime() {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  bool sawNew = SawNew;
+  SawNew = false;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return sawNew;
+}
+
+unsigned long PulseSensorTransitTime::getMatchCount() {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  unsigned long matches = Matches;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return matches;
+}
+
+unsigned long PulseSensorTransitTime::getMissCount() {
+  DISABLE_PULSE_SENSOR_INTERRUPTS;
+  unsigned long misses = Misses;
+  ENABLE_PULSE_SENSOR_INTERRUPTS;
+  return misses;
+}
+
+int PulseSensorTransitTime::readTransitTimes(TransitTimeEvent *buf, int n) {
+  if (n <= 0) {
+    return 0;
+  }
+  if ((unsigned long) n > PULSE_SENSOR_RING_MAX_CAPACITY) {
+    n = PULSE_SENSOR_RING_MAX_CAPACITY;
+  }
+  return Events.get(buf, (PulseSensorRingIndex) n);
+}
+
+unsigned long PulseSensorTransitTime::getOverruns() {
+  return Events.getOverruns();
+}
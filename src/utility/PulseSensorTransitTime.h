@@ -0,0 +1,151 @@
+/*
+   Pulse Transit Time: the time the pulse takes to travel
+   from one PulseSensor to another, measured beat by beat.
+   See https://www.pulsesensor.com to get started.
+
+   Copyright World Famous Electronics LLC - see LICENSE
+   Contributors:
+     Joel Murphy, https://pulsesensor.com
+     Yury Gitman, https://pulsesensor.com
+     Bradford Needham, @bneedhamia, https://bluepapertech.com
+
+   Licensed under the MIT License, a copy of which
+   should have been included with this software.
+
+   This software is not intended for medical use.
+*/
+#ifndef PULSE_SENSOR_TRANSIT_TIME_H
+#define PULSE_SENSOR_TRANSIT_TIME_H
+
+#include <Arduino.h>
+#include "PulseSensorRing.h"
+
+/*
+   The number of the latest Pulse Transit Times averaged by
+   getAverageMicros() and getStandardDeviationMicros().
+   Each costs 4 bytes of RAM per PulseSensorTransitTime. Must be 1..255.
+*/
+#ifndef PULSE_SENSOR_TRANSIT_WINDOW
+#define PULSE_SENSOR_TRANSIT_WINDOW 8
+#endif
+
+/*
+   One Pulse Transit Time, queued for readTransitTimes().
+*/
+struct TransitTimeEvent {
+  unsigned long beatTimeMicros;    // time of the beat at the distal PulseSensor (us).
+  long transitTimeMicros;          // time since the same beat reached the proximal one (us).
+};
+
+/*
+   Pairs each beat found on a proximal PulseSensor (the one nearer
+   the heart) with the same beat arriving at a distal one, as the
+   beats are found, so the result doesn't depend on how often
+   loop() looks. For example, with PulseSensors 0 (ear) and 1 (finger):
+
+     PulseSensorTransitTime earToFinger(0, 1);
+     ...
+     pulseSensor.addTransitTime(earToFinger);  // before begin().
+     ...
+     if (earToFinger.sawNewTransitTime()) {
+       Serial.println(earToFinger.getTransitTimeMicros());
+     }
+
+   A distal beat is paired with the latest proximal beat if it comes
+   within the matching window after it (see setWindow()). A proximal
+   beat that isn't paired, and a distal beat that can't be, is counted
+   by getMissCount(): a beat one PulseSensor found and the other didn't.
+
+   Beat times are getLastBeatTimeMicros() times, so set
+   PULSE_SENSOR_INTERPOLATE_BEATS to true (in PulseSensor.h)
+   to measure to a fraction of a sample period.
+
+   To keep every Pulse Transit Time, give it storage for a queue,
+   a power of 2 in size (no larger than 128 on AVR boards):
+     TransitTimeEvent transitStorage[8];
+     PulseSensorTransitTime earToFinger(0, 1, transitStorage, 8);
+   and read them with readTransitTimes().
+*/
+class PulseSensorTransitTime {
+  public:
+    PulseSensorTransitTime(byte proximalIndex, byte distalIndex,
+      TransitTimeEvent *storage = NULL, size_t capacity = 0);
+
+    /*
+       By default, a distal beat is paired with a proximal beat
+       up to 400 milliseconds before it.
+
+       minMicros, maxMicros = the shortest and longest Pulse Transit
+         Time to accept, in microseconds. maxMicros should be shorter
+         than the shortest inter-beat interval, so that a distal beat
+         can't be paired with the next beat's proximal one.
+    */
+    void setWindow(unsigned long minMicros, unsigned long maxMicros);
+
+    // Returns the PulseSensor indexes given to the constructor.
+    byte getProximalIndex();
+    byte getDistalIndex();
+
+    /*
+       Returns the latest Pulse Transit Time, in microseconds,
+       or -1 if there hasn't been one yet.
+    */
+    long getTransitTimeMicros();
+
+    /*
+       Returns the average, and standard deviation, of the latest
+       PULSE_SENSOR_TRANSIT_WINDOW Pulse Transit Times (or of those
+       there have been), in microseconds. The average is -1,
+       and the standard deviation 0, if there hasn't been one yet.
+    */
+    long getAverageMicros();
+    long getStandardDeviationMicros();
+
+    /*
+       Returns true if a new Pulse Transit Time has been found
+       since the last time this was called.
+    */
+    bool sawNewTransitTime();
+
+    // Returns the number of beats paired, and of beats that couldn't be.
+    unsigned long getMatchCount();
+    unsigned long getMissCount();
+
+    /*
+       Copy up to n of the oldest queued Pulse Transit Times into buf,
+       oldest first. Returns the number copied, or 0 with no storage.
+    */
+    int readTransitTimes(TransitTimeEvent *buf, int n);
+
+    // Returns the number of queued Pulse Transit Times dropped because the queue was full.
+    unsigned long getOverruns();
+
+    // Forget all the beats and Pulse Transit Times so far.
+    void reset();
+
+    /*
+       (internal to the library) A PulseSensor found something.
+       found = its FOUND_* flags; beatMicros = its beat time (us).
+    */
+    void addBeat(byte sensorIndex, byte found, unsigned long beatMicros);
+
+    // (internal to the library) The next PulseSensorTransitTime of the Playground's.
+    PulseSensorTransitTime *pNext;
+
+  private:
+    PulseSensorRing<TransitTimeEvent> Events; // queue for readTransitTimes(), if storage given.
+    byte ProximalIndex;
+    byte DistalIndex;
+    unsigned long MinMicros;      // matching window.
+    unsigned long MaxMicros;
+    volatile bool HaveProximal;   // ProximalMicros is a beat not yet paired.
+    volatile unsigned long ProximalMicros; // time of the latest proximal beat.
+    volatile long Latest;         // the latest Pulse Transit Time, or -1.
+    volatile bool SawNew;         // a Pulse Transit Time hasn't been seen by sawNewTransitTime().
+    volatile unsigned long Matches;
+    volatile unsigned long Misses;
+    long Window[PULSE_SENSOR_TRANSIT_WINDOW]; // ring of the latest Pulse Transit Times.
+    byte WindowIndex;             // where in Window[] the next one goes.
+    byte WindowCount;             // how many of Window[] are filled.
+};
+#endif // PULSE_SENSOR_TRANSIT_TIME_H
@@ -117,6 +117,19 @@
         #endif
     #endif
 
+    #if PULSE_SENSOR_ADC_CHAIN
+        /*
+           The ADC conversion complete interrupt, for PULSE_SENSOR_ADC_INTERRUPTS.
+           The sample timer's ISR starts the first conversion; this stores
+           each reading and starts the next. Interrupts stay off only
+           that long; onConversionComplete() turns them on to find beats.
+        */
+        ISR(ADC_vect)
+        {
+          PulseSensorPlayground::OurThis->onConversionComplete(ADC);
+        }
+    #endif
+
     #if defined(ARDUINO_ARCH_RENESAS)
         #include "FspTimer.h"
         FspTimer sampleTimer;
@@ -144,10 +157,9 @@
         /*
           Include the TimerInterrupt library 
           https://github.com/khoih-prog/RPI_PICO_TimerInterrupt
-          Set the sample rate to 500Hz
+          The sample interval is set in setupInterrupt()
          */
         #include "RPi_Pico_TimerInterrupt.h"
-        #define SAMPLE_INTERVAL_US 2000L
         RPI_PICO_Timer sampleTimer(0); // the paramater may need to change, depending?
         bool sampleTimer_ISR(struct repeating_timer *t){ 
           (void) t;
@@ -162,7 +174,6 @@
             use this library and ISR
         */
         #include "NRF52TimerInterrupt.h"
-        #define TIMER3_INTERVAL_US        2000 // critical fine tuning here!
         NRF52Timer sampleTimer(NRF_TIMER_3);
         void Timer3_ISR(){
           PulseSensorPlayground::OurThis->onSampleTime();